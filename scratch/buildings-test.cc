@@ -25,6 +25,7 @@
 #include "ns3/mobility-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/ns2-mobility-helper.h"
+#include "ns3/ns2-streaming-mobility-helper.h"
 #include "ns3/netanim-module.h"
 #include "ns3/aodv-module.h"
 #include "ns3/olsr-module.h"
@@ -35,6 +36,7 @@
 #include "ns3/ipv4-list-routing-helper.h"
 #include "ns3/energy-module.h"
 #include "ns3/buildings-module.h"
+#include "ns3/async-output-stream.h"
 
 #include "ns3/ocb-wifi-mac.h"
 #include "ns3/wifi-80211p-helper.h"
@@ -169,6 +171,8 @@ public:
     uint32_t iter;
     double throughput;
     std::string mobFile; //mobility file
+    bool useMobFile; // drive the vehicles with mobFile
+    std::string record; // GPSR packet lifecycle record file, none if empty
     
     /*Countainers*/
     NodeContainer STANodes;
@@ -189,6 +193,11 @@ public:
     /*Helpers*/
     YansWifiPhyHelper wifiPhy;
     
+    /*Logs written on every event*/
+    Ptr<AsyncOutputStream> rxLog;
+    Ptr<AsyncOutputStream> mobilityLog;
+    Ptr<GpsrPacketRecorder> recorder;
+    
 };
 
 VanetSims::VanetSims () :
@@ -213,7 +222,9 @@ VanetSims::VanetSims () :
     packetsReceived (0),
     iter (0),
     throughput (0),
-    mobFile ("mobility/topos/mob_100_22.ns2")
+    mobFile ("mobility/topos/mob_100_22.ns2"),
+    useMobFile (false),
+    record ("")
                
 {
 }
@@ -234,6 +245,8 @@ VanetSims::Configure (int argc, char **argv)
     cmd.AddValue ("RP", "Routing protocol", m_protocol);
     cmd.AddValue ("application", "application used", application);
     cmd.AddValue ("mobFile", "mobility file", mobFile);
+    cmd.AddValue ("useMobFile", "move the vehicles according to mobFile", useMobFile);
+    cmd.AddValue ("record", "GPSR packet lifecycle record file", record);
     cmd.Parse (argc, argv);
 }
 
@@ -304,11 +317,20 @@ VanetSims::CreateNodes()
     
     MobilityHelper mobility;
     mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
-    mobility.Install (STANodes);
     mobility.Install (BSNodes);
     
-    SetPosition (STANodes.Get(0), Vector (100.0, 150.0, 1.0));
-    SetPosition (STANodes.Get(1), Vector (100.0, 10.0, 1.0)); 
+    if (useMobFile)
+    {
+        // Waypoints are read from the trace while the simulation runs
+        Ns2StreamingMobilityHelper ns2 (mobFile);
+        ns2.Install (STANodes);
+    }
+    else
+    {
+        mobility.Install (STANodes);
+        SetPosition (STANodes.Get(0), Vector (100.0, 150.0, 1.0));
+        SetPosition (STANodes.Get(1), Vector (100.0, 10.0, 1.0)); 
+    }
 //    SetPosition (STANodes.Get(1), Vector (300.0, 150.0, 1.0)); 
     
     SetPosition (BSNodes.Get(0), Vector (150.0, 100.0, 1.0));
@@ -622,8 +644,7 @@ VanetSims::InstallApplications()
 inline std::string
 VanetSims::PrintReceivedPacket (Ptr<Socket> socket, Ptr<Packet> packet)
 {
-  std::ofstream logs;
-  logs.open ((outdir + log_4).c_str(), std::ios::app);
+  std::ostream &logs = *rxLog->GetStream ();
 
   SocketAddressTag tag;
   bool found;
@@ -647,7 +668,6 @@ VanetSims::PrintReceivedPacket (Ptr<Socket> socket, Ptr<Packet> packet)
       //oss << " received one packet!";
       logs << " \nreceived one packet!!!\n";
     }
-  logs.close();
   return oss.str ();
 }
 
@@ -667,8 +687,7 @@ VanetSims::ReceivePacket (Ptr<Socket> socket)
 void 
 VanetSims::trace_node_mobility (NodeContainer nodes) 
 { 
-  std::ofstream logs;
-  logs.open ((outdir + log_2).c_str(), std::ios::app);
+  std::ostream &logs = *mobilityLog->GetStream ();
 
   // iterate our nodes and print their position.
   for (NodeContainer::Iterator j = nodes.Begin ();
@@ -680,7 +699,6 @@ VanetSims::trace_node_mobility (NodeContainer nodes)
       Vector pos = position->GetPosition ();
       logs << "Node: " << object->GetId() << " x= " << pos.x << " y= " << pos.y << " z= " << pos.z << "\n";
     }
-  logs.close();
 }
 
 //Set position of the nodes
@@ -730,7 +748,6 @@ VanetSims::TotalEnergy (double oldValue, double totalEnergy)
 void
 VanetSims::ExportEnergyPerNode ()
 {
-  std::ofstream logs;
   std::string rp = "rp_1_";
    switch (m_protocol)
     {
@@ -753,11 +770,11 @@ VanetSims::ExportEnergyPerNode ()
         NS_FATAL_ERROR ("No such protocol:" << m_protocol);
     }
    
-  logs.open ((outdir + rp + log_1).c_str(),std::ios::app);
+  Ptr<AsyncOutputStream> energyLog = Create<AsyncOutputStream> (outdir + rp + log_1, std::ios::app);
+  std::ostream &logs = *energyLog->GetStream ();
   for (uint32_t i = 0; i < STANodesNum; ++i) {
     logs << i << " " << NodeTotEnergyCons[i] << "\n";
   }
-  logs.close();
 }
 
 void
@@ -768,17 +785,13 @@ VanetSims::clearLogFiles ()
     logf1.open ((outdir + log_1).c_str(),std::ios::trunc);
     logf1.close();
     
-    std::ofstream logf2;
-    logf2.open ((outdir + log_2).c_str(),std::ios::trunc);
-    logf2.close();
+    // Written in the background until Simulator::Destroy
+    mobilityLog = Create<AsyncOutputStream> (outdir + log_2);
+    rxLog = Create<AsyncOutputStream> (outdir + log_4);
     
     std::ofstream logf3;
     logf3.open ((outdir + log_3).c_str(),std::ios::trunc);
     logf3.close();
-
-    std::ofstream logf4;
-    logf4.open ((outdir + log_4).c_str(),std::ios::trunc);
-    logf4.close();
 }
 
 void
@@ -793,6 +806,11 @@ VanetSims::ExportTraceFiles()
 void
 VanetSims::PrintAppOutput()
 {
+    if (recorder != 0)
+    {
+        std::cout << "GPSR: " << recorder->GetDelivered () << " of " << recorder->GetSent ()
+                  << " packets delivered, " << recorder->GetDropped () << " dropped\n";
+    }
     if (application == 1)
     {
         // Socket Broadcast UDP
@@ -903,6 +921,11 @@ VanetSims::installGpsr_IfChosen()
     {
         GpsrHelper gpsr;
         gpsr.Install ();
+        if (!record.empty ())
+        {
+            recorder = Create<GpsrPacketRecorder> (record);
+            recorder->InstallAll ();
+        }
     }
 }
 
@@ -0,0 +1,621 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * Micro-benchmarks of the GPSR and wifi hot paths.
+ *
+ * Each benchmark is calibrated until one batch runs for at least --minTime
+ * milliseconds, then timed --repeat times. Results are written as JSON, to
+ * stdout or to the file given by --json:
+ *
+ *   ./waf --run "gpsr-bench --json=bench.json"
+ *   ./waf --run "gpsr-bench --filter=BestNeighbor --minTime=500"
+ *
+ * Inputs are drawn from a fixed seed, so two runs time the same work.
+ */
+
+#include "ns3/gpsr-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/system-wall-clock-ms.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/// One benchmark, run for each of a list of sizes
+class BenchCase
+{
+public:
+  virtual ~BenchCase ()
+  {
+  }
+  /// Name in the results, e.g. "PositionTable::BestNeighbor"
+  virtual std::string GetName (void) const = 0;
+  /// Meaning of the size, e.g. "neighbors"
+  virtual std::string GetParamName (void) const = 0;
+  /// Build the state for size param
+  virtual void Setup (uint32_t param) = 0;
+  /// Run iterations operations
+  virtual void RunBatch (uint64_t iterations) = 0;
+  /// Release the state of Setup
+  virtual void Teardown (void)
+  {
+  }
+};
+
+struct BenchResult
+{
+  std::string name;
+  std::string paramName;
+  uint32_t param;
+  uint64_t iterations;
+  double bestNsPerOp;
+  double medianNsPerOp;
+};
+
+class BenchRunner
+{
+public:
+  BenchRunner ();
+  bool Configure (int argc, char **argv);
+  void Run (BenchCase &bench, std::vector<uint32_t> params);
+  void Report (std::ostream &os) const;
+  std::string GetJsonFile (void) const
+  {
+    return m_jsonFile;
+  }
+  std::string GetManager (void) const
+  {
+    return m_manager;
+  }
+
+private:
+  uint32_t m_seed;
+  uint32_t m_run;
+  uint32_t m_minTime;
+  uint32_t m_repeat;
+  std::string m_filter;
+  std::string m_jsonFile;
+  std::string m_manager;
+  std::vector<BenchResult> m_results;
+};
+
+BenchRunner::BenchRunner ()
+  : m_seed (12345),
+    m_run (1),
+    m_minTime (200),
+    m_repeat (5),
+    m_manager ("ns3::ArfWifiManager")
+{
+}
+
+bool
+BenchRunner::Configure (int argc, char **argv)
+{
+  CommandLine cmd;
+  cmd.AddValue ("seed", "RNG seed of the inputs.", m_seed);
+  cmd.AddValue ("run", "RNG run of the inputs.", m_run);
+  cmd.AddValue ("minTime", "Minimum duration of a timed batch, ms.", m_minTime);
+  cmd.AddValue ("repeat", "Timed batches per benchmark.", m_repeat);
+  cmd.AddValue ("filter", "Only run benchmarks whose name contains this.", m_filter);
+  cmd.AddValue ("json", "Write the results to this file instead of stdout.", m_jsonFile);
+  cmd.AddValue ("manager", "WifiRemoteStationManager type to benchmark.", m_manager);
+  cmd.Parse (argc, argv);
+
+  RngSeedManager::SetSeed (m_seed);
+  RngSeedManager::SetRun (m_run);
+  return m_repeat > 0;
+}
+
+void
+BenchRunner::Run (BenchCase &bench, std::vector<uint32_t> params)
+{
+  if (bench.GetName ().find (m_filter) == std::string::npos)
+    {
+      return;
+    }
+  for (std::vector<uint32_t>::const_iterator p = params.begin (); p != params.end (); ++p)
+    {
+      bench.Setup (*p);
+      bench.RunBatch (1);
+
+      // Grow the batch until it is long enough to be timed in milliseconds
+      SystemWallClockMs clock;
+      uint64_t iterations = 1;
+      for (;;)
+        {
+          clock.Start ();
+          bench.RunBatch (iterations);
+          int64_t elapsed = clock.End ();
+          if (elapsed >= m_minTime)
+            {
+              break;
+            }
+          iterations *= elapsed < 10 ? 10 : 2;
+        }
+
+      std::vector<double> samples;
+      for (uint32_t r = 0; r < m_repeat; ++r)
+        {
+          clock.Start ();
+          bench.RunBatch (iterations);
+          samples.push_back (clock.End () * 1e6 / iterations);
+        }
+      bench.Teardown ();
+      Simulator::Destroy ();
+
+      std::sort (samples.begin (), samples.end ());
+      BenchResult result;
+      result.name = bench.GetName ();
+      result.paramName = bench.GetParamName ();
+      result.param = *p;
+      result.iterations = iterations;
+      result.bestNsPerOp = samples.front ();
+      result.medianNsPerOp = samples[samples.size () / 2];
+      m_results.push_back (result);
+      std::clog << result.name << " " << result.paramName << "=" << result.param
+                << ": " << result.medianNsPerOp << " ns/op\n";
+    }
+}
+
+void
+BenchRunner::Report (std::ostream &os) const
+{
+  os << std::fixed << std::setprecision (1);
+  os << "{\n"
+     << "  \"seed\": " << m_seed << ",\n"
+     << "  \"run\": " << m_run << ",\n"
+     << "  \"minTimeMs\": " << m_minTime << ",\n"
+     << "  \"repeat\": " << m_repeat << ",\n"
+     << "  \"manager\": \"" << m_manager << "\",\n"
+     << "  \"results\": [";
+  for (std::vector<BenchResult>::const_iterator i = m_results.begin (); i != m_results.end (); ++i)
+    {
+      os << (i == m_results.begin () ? "\n" : ",\n")
+         << "    {\"name\": \"" << i->name << "\", "
+         << "\"" << i->paramName << "\": " << i->param << ", "
+         << "\"iterations\": " << i->iterations << ", "
+         << "\"bestNsPerOp\": " << i->bestNsPerOp << ", "
+         << "\"medianNsPerOp\": " << i->medianNsPerOp << "}";
+    }
+  os << "\n  ]\n}\n";
+}
+
+//-----------------------------------------------------------------------------
+/// Neighbours spread around the origin within radio range
+static void
+FillPositionTable (gpsr::PositionTable &table, uint32_t neighbors, Ptr<UniformRandomVariable> rng)
+{
+  for (uint32_t i = 0; i < neighbors; ++i)
+    {
+      Vector pos (rng->GetValue (-250, 250), rng->GetValue (-250, 250), 0);
+      Vector vel (rng->GetValue (-30, 30), rng->GetValue (-30, 30), 0);
+      table.AddEntry (Ipv4Address (0x0a000001 + i), pos, vel, rng->GetValue (5, 30));
+    }
+}
+
+class BestNeighborBench : public BenchCase
+{
+public:
+  std::string GetName (void) const
+  {
+    return "PositionTable::BestNeighbor";
+  }
+  std::string GetParamName (void) const
+  {
+    return "neighbors";
+  }
+  void Setup (uint32_t param)
+  {
+    m_rng = CreateObject<UniformRandomVariable> ();
+    m_table.Clear ();
+    FillPositionTable (m_table, param, m_rng);
+    m_destinations.clear ();
+    for (uint32_t i = 0; i < 256; ++i)
+      {
+        m_destinations.push_back (Vector (m_rng->GetValue (-5000, 5000), m_rng->GetValue (-5000, 5000), 0));
+      }
+  }
+  void RunBatch (uint64_t iterations)
+  {
+    Vector nodeVel (20, 0, 0);
+    Vector dstVel (-20, 0, 0);
+    for (uint64_t i = 0; i < iterations; ++i)
+      {
+        m_table.BestNeighbor (m_destinations[i & 255], dstVel, Vector (0, 0, 0), nodeVel);
+      }
+  }
+
+private:
+  gpsr::PositionTable m_table;
+  Ptr<UniformRandomVariable> m_rng;
+  std::vector<Vector> m_destinations;
+};
+
+class BestAngleBench : public BenchCase
+{
+public:
+  std::string GetName (void) const
+  {
+    return "PositionTable::BestAngle";
+  }
+  std::string GetParamName (void) const
+  {
+    return "neighbors";
+  }
+  void Setup (uint32_t param)
+  {
+    m_rng = CreateObject<UniformRandomVariable> ();
+    m_table.Clear ();
+    FillPositionTable (m_table, param, m_rng);
+    m_previousHops.clear ();
+    for (uint32_t i = 0; i < 256; ++i)
+      {
+        m_previousHops.push_back (Vector (m_rng->GetValue (-250, 250), m_rng->GetValue (-250, 250), 0));
+      }
+  }
+  void RunBatch (uint64_t iterations)
+  {
+    for (uint64_t i = 0; i < iterations; ++i)
+      {
+        m_table.BestAngle (m_previousHops[i & 255], Vector (0, 0, 0));
+      }
+  }
+
+private:
+  gpsr::PositionTable m_table;
+  Ptr<UniformRandomVariable> m_rng;
+  std::vector<Vector> m_previousHops;
+};
+
+/// One operation is a Dequeue and an Enqueue on a queue holding param packets
+class RequestQueueBench : public BenchCase
+{
+public:
+  RequestQueueBench ()
+    : m_queue (0, Seconds (30))
+  {
+  }
+  std::string GetName (void) const
+  {
+    return "RequestQueue::EnqueueDequeue";
+  }
+  std::string GetParamName (void) const
+  {
+    return "queued";
+  }
+  void Setup (uint32_t param)
+  {
+    m_queue = gpsr::RequestQueue (param + 1, Seconds (30));
+    m_size = param;
+    for (uint32_t i = 0; i < param; ++i)
+      {
+        Ipv4Header header;
+        header.SetDestination (Ipv4Address (0x0a000001 + i));
+        gpsr::QueueEntry entry (Create<Packet> (512), header);
+        m_queue.Enqueue (entry);
+      }
+  }
+  void RunBatch (uint64_t iterations)
+  {
+    gpsr::QueueEntry entry;
+    for (uint64_t i = 0; i < iterations; ++i)
+      {
+        if (m_queue.Dequeue (Ipv4Address (0x0a000001 + i % m_size), entry))
+          {
+            m_queue.Enqueue (entry);
+          }
+      }
+  }
+
+private:
+  gpsr::RequestQueue m_queue;
+  uint32_t m_size;
+};
+
+/// One operation adds and removes the headers of a GPSR data packet
+class PositionHeaderBench : public BenchCase
+{
+public:
+  std::string GetName (void) const
+  {
+    return "PositionHeader::SerializeDeserialize";
+  }
+  std::string GetParamName (void) const
+  {
+    return "payload";
+  }
+  void Setup (uint32_t param)
+  {
+    m_payload = param;
+  }
+  void RunBatch (uint64_t iterations)
+  {
+    for (uint64_t i = 0; i < iterations; ++i)
+      {
+        Ptr<Packet> p = Create<Packet> (m_payload);
+        p->AddHeader (gpsr::PositionHeader (1200, 340, 7, 800, 20, 1, 410, 90));
+        p->AddHeader (gpsr::TypeHeader (gpsr::GPSRTYPE_POS));
+        gpsr::TypeHeader type;
+        gpsr::PositionHeader position;
+        p->RemoveHeader (type);
+        p->RemoveHeader (position);
+      }
+  }
+
+private:
+  uint32_t m_payload;
+};
+
+/// One operation adds and removes the headers of a hello
+class HelloHeaderBench : public BenchCase
+{
+public:
+  std::string GetName (void) const
+  {
+    return "HelloHeader::SerializeDeserialize";
+  }
+  std::string GetParamName (void) const
+  {
+    return "payload";
+  }
+  void Setup (uint32_t param)
+  {
+    m_payload = param;
+  }
+  void RunBatch (uint64_t iterations)
+  {
+    for (uint64_t i = 0; i < iterations; ++i)
+      {
+        Ptr<Packet> p = Create<Packet> (m_payload);
+        p->AddHeader (gpsr::HelloHeader (1200, 340, 25, -3));
+        p->AddHeader (gpsr::TypeHeader (gpsr::GPSRTYPE_HELLO));
+        gpsr::TypeHeader type;
+        gpsr::HelloHeader hello;
+        p->RemoveHeader (type);
+        p->RemoveHeader (hello);
+      }
+  }
+
+private:
+  uint32_t m_payload;
+};
+
+static Ptr<YansWifiPhy>
+CreatePhy (Ptr<YansWifiChannel> channel, Vector position)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (position);
+  phy->SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+  phy->SetMobility (mobility);
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211_10MHZ);
+  if (channel != 0)
+    {
+      phy->SetChannel (channel);
+    }
+  return phy;
+}
+
+static void
+DiscardRx (Ptr<Packet> p, double snr, WifiMode mode, enum WifiPreamble preamble)
+{
+}
+
+/**
+ * One operation is a broadcast frame sent to param receivers in range and
+ * the simulation of its reception by all of them.
+ */
+class ChannelSendBench : public BenchCase
+{
+public:
+  std::string GetName (void) const
+  {
+    return "YansWifiChannel::Send";
+  }
+  std::string GetParamName (void) const
+  {
+    return "receivers";
+  }
+  void Setup (uint32_t param)
+  {
+    Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+    m_channel = CreateObject<YansWifiChannel> ();
+    m_channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+    m_channel->SetPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+    m_sender = CreatePhy (m_channel, Vector (0, 0, 0));
+    for (uint32_t i = 0; i < param; ++i)
+      {
+        Ptr<YansWifiPhy> phy = CreatePhy (m_channel, Vector (rng->GetValue (-100, 100), rng->GetValue (-100, 100), 0));
+        phy->SetReceiveOkCallback (MakeCallback (&DiscardRx));
+        m_receivers.push_back (phy);
+      }
+    m_txVector.SetMode (WifiPhy::GetOfdmRate6MbpsBW10MHz ());
+    m_txVector.SetTxPowerLevel (0);
+    m_packet = Create<Packet> (200);
+  }
+  void RunBatch (uint64_t iterations)
+  {
+    for (uint64_t i = 0; i < iterations; ++i)
+      {
+        m_channel->Send (m_sender, m_packet, 16.0206, m_txVector, WIFI_PREAMBLE_LONG);
+        Simulator::Run ();
+      }
+  }
+  void Teardown (void)
+  {
+    m_receivers.clear ();
+    m_sender = 0;
+    m_channel = 0;
+    m_packet = 0;
+  }
+
+private:
+  Ptr<YansWifiChannel> m_channel;
+  Ptr<YansWifiPhy> m_sender;
+  std::vector<Ptr<YansWifiPhy> > m_receivers;
+  WifiTxVector m_txVector;
+  Ptr<Packet> m_packet;
+};
+
+/// One operation computes the SNR and PER of a frame overlapping param others
+class SnrPerBench : public BenchCase
+{
+public:
+  std::string GetName (void) const
+  {
+    return "InterferenceHelper::CalculateSnrPer";
+  }
+  std::string GetParamName (void) const
+  {
+    return "interferers";
+  }
+  void Setup (uint32_t param)
+  {
+    m_helper.SetNoiseFigure (7.94);
+    m_helper.SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+    m_helper.EraseEvents ();
+    m_txVector.SetMode (WifiPhy::GetOfdmRate6MbpsBW10MHz ());
+    Time duration = MicroSeconds (400);
+    for (uint32_t i = 0; i < param; ++i)
+      {
+        m_helper.Add (200, m_txVector.GetMode (), WIFI_PREAMBLE_LONG, duration + MicroSeconds (i * 10),
+                      1e-12 * (i + 1), m_txVector);
+      }
+    m_event = m_helper.Add (200, m_txVector.GetMode (), WIFI_PREAMBLE_LONG, duration, 1e-9, m_txVector);
+  }
+  void RunBatch (uint64_t iterations)
+  {
+    for (uint64_t i = 0; i < iterations; ++i)
+      {
+        m_helper.CalculateSnrPer (m_event);
+      }
+  }
+  void Teardown (void)
+  {
+    m_helper.EraseEvents ();
+    m_event = 0;
+  }
+
+private:
+  InterferenceHelper m_helper;
+  WifiTxVector m_txVector;
+  Ptr<InterferenceHelper::Event> m_event;
+};
+
+/// One operation selects the rate of a frame to one of param stations and reports its success
+class StationManagerBench : public BenchCase
+{
+public:
+  StationManagerBench (std::string manager)
+  {
+    m_factory.SetTypeId (manager);
+  }
+  std::string GetName (void) const
+  {
+    return "WifiRemoteStationManager::GetDataTxVector";
+  }
+  std::string GetParamName (void) const
+  {
+    return "stations";
+  }
+  void Setup (uint32_t param)
+  {
+    m_phy = CreatePhy (0, Vector (0, 0, 0));
+    m_manager = m_factory.Create<WifiRemoteStationManager> ();
+    m_manager->SetupPhy (m_phy);
+    m_addresses.clear ();
+    for (uint32_t i = 0; i < param; ++i)
+      {
+        Mac48Address address = Mac48Address::Allocate ();
+        for (uint32_t j = 0; j < m_phy->GetNModes (); ++j)
+          {
+            m_manager->AddSupportedMode (address, m_phy->GetMode (j));
+          }
+        m_manager->RecordGotAssocTxOk (address);
+        m_addresses.push_back (address);
+      }
+    m_header.SetType (WIFI_MAC_DATA);
+    m_packet = Create<Packet> (500);
+  }
+  void RunBatch (uint64_t iterations)
+  {
+    for (uint64_t i = 0; i < iterations; ++i)
+      {
+        Mac48Address address = m_addresses[i % m_addresses.size ()];
+        m_header.SetAddr1 (address);
+        WifiTxVector txVector = m_manager->GetDataTxVector (address, &m_header, m_packet, 528);
+        m_manager->ReportDataOk (address, &m_header, 20, txVector.GetMode (), 20);
+      }
+  }
+  void Teardown (void)
+  {
+    m_manager = 0;
+    m_phy = 0;
+    m_packet = 0;
+  }
+
+private:
+  ObjectFactory m_factory;
+  Ptr<WifiRemoteStationManager> m_manager;
+  Ptr<YansWifiPhy> m_phy;
+  std::vector<Mac48Address> m_addresses;
+  WifiMacHeader m_header;
+  Ptr<Packet> m_packet;
+};
+
+//-----------------------------------------------------------------------------
+static std::vector<uint32_t>
+Sizes (uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+  std::vector<uint32_t> sizes;
+  sizes.push_back (a);
+  sizes.push_back (b);
+  sizes.push_back (c);
+  sizes.push_back (d);
+  return sizes;
+}
+
+int main (int argc, char **argv)
+{
+  BenchRunner runner;
+  if (!runner.Configure (argc, argv))
+    {
+      NS_FATAL_ERROR ("Configuration failed. Aborted.");
+    }
+
+  BestNeighborBench bestNeighbor;
+  runner.Run (bestNeighbor, Sizes (8, 32, 128, 512));
+  BestAngleBench bestAngle;
+  runner.Run (bestAngle, Sizes (8, 32, 128, 512));
+  RequestQueueBench queue;
+  runner.Run (queue, Sizes (8, 64, 256, 1024));
+  PositionHeaderBench positionHeader;
+  runner.Run (positionHeader, Sizes (0, 64, 512, 1400));
+  HelloHeaderBench helloHeader;
+  runner.Run (helloHeader, Sizes (0, 64, 512, 1400));
+  ChannelSendBench channel;
+  runner.Run (channel, Sizes (10, 50, 200, 1000));
+  SnrPerBench snrPer;
+  runner.Run (snrPer, Sizes (0, 4, 16, 64));
+  StationManagerBench stations (runner.GetManager ());
+  runner.Run (stations, Sizes (1, 16, 128, 1024));
+
+  if (runner.GetJsonFile ().empty ())
+    {
+      runner.Report (std::cout);
+    }
+  else
+    {
+      std::ofstream os (runner.GetJsonFile ().c_str ());
+      runner.Report (os);
+    }
+  return 0;
+}
@@ -0,0 +1,517 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/*
+ * End-to-end scaling benchmark: N vehicles on a synthetic Manhattan grid or
+ * highway, M random UDP flows, GPSR over 802.11p (10 MHz, 6 Mbps).
+ *
+ * One run prints one CSV row: simulated seconds per wall second, events
+ * executed, peak RSS and the per-layer activity of the run. With --sweep,
+ * every size of the list is run in its own child process (so that peak RSS
+ * is that of the size alone) and one row is printed per size:
+ *
+ *   ./waf --run "gpsr-scaling --size=500 --flows=20"
+ *   ./waf --run "gpsr-scaling --sweep=100,250,500,1000,2500,5000 --topology=highway"
+ *
+ * --saveSnapshot writes the converged neighbour tables at the end of the
+ * warm-up; --loadSnapshot starts from such a file, so that the run skips
+ * the warm-up and its flows start at once:
+ *
+ *   ./waf --run "gpsr-scaling --size=1000 --saveSnapshot=warm-1000.snap"
+ *   ./waf --run "gpsr-scaling --size=1000 --loadSnapshot=warm-1000.snap --RngRun=2"
+ *
+ * --profile writes to standard error where the event loop spent its time,
+ * per class of the object each event calls (see ProfilingSimulatorImpl).
+ * --record=run.pvzr records the run for src/visualizer/visualizer/replay.py.
+ * --rateManager=ns3::VehicularWifiManager picks the data rate from the
+ * neighbour positions GPSR keeps instead of sending at 6 Mb/s.
+ */
+
+#include "ns3/gpsr-module.h"
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/profiling-simulator-impl.h"
+#include "ns3/pyviz-recorder.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+using namespace ns3;
+
+class ScalingScenario
+{
+public:
+  ScalingScenario ();
+  /// Configure script parameters, \return true on successful configuration
+  bool Configure (int argc, char **argv);
+  /// Run the sweep, or the single size if there is no sweep
+  void Run ();
+
+private:
+  ///\name parameters
+  //\{
+  /// Number of vehicles
+  uint32_t size;
+  /// Number of UDP flows between random vehicles
+  uint32_t flows;
+  /// "manhattan" or "highway"
+  std::string topology;
+  /// Vehicles per km of street (manhattan) or of lane (highway)
+  double density;
+  /// Mean vehicle speed, m/s
+  double speed;
+  /// Highway lanes, half of them in each direction
+  uint32_t lanes;
+  /// Manhattan block length, m
+  double block;
+  /// Simulation time, s
+  double totalTime;
+  /// Flows start after this time, once neighbour tables are filled, s
+  double warmup;
+  /// Flow packet size, bytes
+  uint32_t packetSize;
+  /// Flow packet interval, s
+  double interval;
+  /// Comma-separated sizes, each run in a child process
+  std::string sweep;
+  /// Save the GPSR state at the end of the warm-up to this file
+  std::string saveSnapshot;
+  /// Start from the GPSR state saved in this file, without warm-up
+  std::string loadSnapshot;
+  /// Report the event time per callee class
+  bool profile;
+  /// Record positions and transmissions to this file for a PyViz replay
+  std::string record;
+  /// WifiRemoteStationManager type, constant 6 Mb/s if empty
+  std::string rateManager;
+  //\}
+
+  ///\name network
+  //\{
+  NodeContainer nodes;
+  NetDeviceContainer devices;
+  Ipv4InterfaceContainer interfaces;
+  /// Side of the grid or length of the highway, m
+  double extent;
+  //\}
+
+  ///\name counters
+  //\{
+  uint64_t m_phyTx;
+  uint64_t m_phyRx;
+  uint64_t m_phyRxDrop;
+  uint64_t m_gpsrForward;
+  uint64_t m_gpsrDrop;
+  uint64_t m_sent;
+  uint64_t m_received;
+  //\}
+
+  void RunOne ();
+  void ReportHeader (std::ostream &os) const;
+  void Report (std::ostream &os, double setupSeconds, double runSeconds) const;
+  void CreateNodes ();
+  void CreateDevices ();
+  void InstallInternetStack ();
+  void InstallApplications ();
+  void ConnectCounters ();
+  /// Put the vehicles that left the area back at the other end
+  void WrapAround ();
+  void Send (Ptr<Socket> socket);
+  void Receive (Ptr<Socket> socket);
+
+  void PhyTx (Ptr<const Packet> p)
+  {
+    m_phyTx++;
+  }
+  void PhyRx (Ptr<const Packet> p)
+  {
+    m_phyRx++;
+  }
+  void PhyRxDrop (Ptr<const Packet> p)
+  {
+    m_phyRxDrop++;
+  }
+  void GpsrForward (Ptr<const Packet> p, Ipv4Address nextHop, Vector position, uint8_t mode)
+  {
+    m_gpsrForward++;
+  }
+  void GpsrDrop (Ptr<const Packet> p, uint8_t reason)
+  {
+    m_gpsrDrop++;
+  }
+};
+
+int main (int argc, char **argv)
+{
+  ScalingScenario test;
+  if (! test.Configure (argc, argv))
+    NS_FATAL_ERROR ("Configuration failed. Aborted.");
+
+  test.Run ();
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+ScalingScenario::ScalingScenario () :
+  size (500),
+  flows (20),
+  topology ("manhattan"),
+  density (20),
+  speed (15),
+  lanes (4),
+  block (200),
+  totalTime (30),
+  warmup (5),
+  packetSize (512),
+  interval (0.25),
+  profile (false),
+  extent (0),
+  m_phyTx (0),
+  m_phyRx (0),
+  m_phyRxDrop (0),
+  m_gpsrForward (0),
+  m_gpsrDrop (0),
+  m_sent (0),
+  m_received (0)
+{
+}
+
+bool
+ScalingScenario::Configure (int argc, char **argv)
+{
+  SeedManager::SetSeed (12345);
+  CommandLine cmd;
+
+  cmd.AddValue ("size", "Number of vehicles.", size);
+  cmd.AddValue ("flows", "Number of UDP flows.", flows);
+  cmd.AddValue ("topology", "manhattan or highway.", topology);
+  cmd.AddValue ("density", "Vehicles per km of street or lane.", density);
+  cmd.AddValue ("speed", "Mean vehicle speed, m/s.", speed);
+  cmd.AddValue ("lanes", "Highway lanes.", lanes);
+  cmd.AddValue ("block", "Manhattan block length, m.", block);
+  cmd.AddValue ("time", "Simulation time, s.", totalTime);
+  cmd.AddValue ("warmup", "Flows start time, s.", warmup);
+  cmd.AddValue ("packetSize", "Flow packet size, bytes.", packetSize);
+  cmd.AddValue ("interval", "Flow packet interval, s.", interval);
+  cmd.AddValue ("sweep", "Comma-separated sizes to run one after the other, e.g. 100,500,1000.", sweep);
+  cmd.AddValue ("saveSnapshot", "Save the GPSR state to this file at the end of the warm-up.", saveSnapshot);
+  cmd.AddValue ("loadSnapshot", "Start from the GPSR state in this file, skipping the warm-up.", loadSnapshot);
+  cmd.AddValue ("profile", "Print the event time per callee class to standard error.", profile);
+  cmd.AddValue ("record", "Record the run to this file for a PyViz replay.", record);
+  cmd.AddValue ("rateManager", "Rate control, e.g. ns3::VehicularWifiManager; constant 6 Mb/s if empty.", rateManager);
+
+  cmd.Parse (argc, argv);
+  if (!sweep.empty () && !(saveSnapshot.empty () && loadSnapshot.empty () && record.empty ()))
+    {
+      std::cerr << "A snapshot or a recording is for one size, not for a sweep\n";
+      return false;
+    }
+  if (!loadSnapshot.empty ())
+    {
+      // The snapshot replaces the warm-up
+      totalTime = std::max (totalTime - warmup, 0.0);
+      warmup = 0;
+    }
+  return size > 1 && density > 0 && (topology == "manhattan" || topology == "highway");
+}
+
+void
+ScalingScenario::Run ()
+{
+  ReportHeader (std::cout);
+  if (sweep.empty ())
+    {
+      RunOne ();
+      return;
+    }
+
+  std::istringstream sizes (sweep);
+  std::string token;
+  while (std::getline (sizes, token, ','))
+    {
+      size = std::atoi (token.c_str ());
+      std::cout.flush ();
+      pid_t child = fork ();
+      if (child < 0)
+        {
+          NS_FATAL_ERROR ("fork failed");
+        }
+      if (child == 0)
+        {
+          RunOne ();
+          std::cout.flush ();
+          _exit (0);
+        }
+      int status;
+      waitpid (child, &status, 0);
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+        {
+          std::cerr << "Run with " << size << " vehicles failed\n";
+        }
+    }
+}
+
+void
+ScalingScenario::RunOne ()
+{
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::ProfilingSimulatorImpl"));
+  Config::SetDefault ("ns3::ProfilingSimulatorImpl::ProfileEvents", BooleanValue (profile));
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  CreateNodes ();
+  CreateDevices ();
+  InstallInternetStack ();
+  InstallApplications ();
+
+  GpsrHelper gpsr;
+  gpsr.Install ();
+  ConnectCounters ();
+  if (!loadSnapshot.empty () && !GpsrSnapshotHelper::Restore (loadSnapshot, nodes))
+    {
+      NS_FATAL_ERROR ("Can not load snapshot " << loadSnapshot);
+    }
+  if (!saveSnapshot.empty ())
+    {
+      Simulator::Schedule (Seconds (warmup), &GpsrSnapshotHelper::Save, saveSnapshot, nodes);
+    }
+  Ptr<PyVizRecorder> recorder;
+  if (!record.empty ())
+    {
+      recorder = Create<PyVizRecorder> (record);
+      recorder->Install (nodes);
+    }
+  double setupSeconds = clock.End () / 1000.0;
+
+  Simulator::Stop (Seconds (totalTime));
+  clock.Start ();
+  Simulator::Run ();
+  double runSeconds = clock.End () / 1000.0;
+
+  Report (std::cout, setupSeconds, runSeconds);
+  Simulator::Destroy ();
+}
+
+void
+ScalingScenario::ReportHeader (std::ostream &os) const
+{
+  os << "topology,nodes,flows,simTime,setupWall,runWall,simPerWall,"
+     << "eventsExecuted,eventsPerWall,peakRssMB,pdr,"
+     << "phyTx,phyRx,phyRxDrop,gpsrForward,gpsrDrop\n";
+}
+
+void
+ScalingScenario::Report (std::ostream &os, double setupSeconds, double runSeconds) const
+{
+  Ptr<ProfilingSimulatorImpl> sim = DynamicCast<ProfilingSimulatorImpl> (Simulator::GetImplementation ());
+  uint64_t events = sim == 0 ? 0 : sim->GetExecutedEvents ();
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  double wall = std::max (runSeconds, 0.001);
+
+  os << topology << "," << size << "," << flows << "," << totalTime << ","
+     << setupSeconds << "," << runSeconds << "," << totalTime / wall << ","
+     << events << "," << events / wall << "," << usage.ru_maxrss / 1024.0 << ","
+     << (m_sent == 0 ? 0.0 : double (m_received) / m_sent) << ","
+     << m_phyTx << "," << m_phyRx << "," << m_phyRxDrop << ","
+     << m_gpsrForward << "," << m_gpsrDrop << "\n";
+}
+
+void
+ScalingScenario::CreateNodes ()
+{
+  nodes.Create (size);
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantVelocityMobilityModel");
+  mobility.Install (nodes);
+
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  // Road length needed for the density, m
+  double road = size / density * 1000;
+  if (topology == "highway")
+    {
+      extent = road / lanes;
+    }
+  else
+    {
+      // s streets of length extent each way: 2 * (extent / block + 1) * extent = road
+      extent = block * std::floor ((-1 + std::sqrt (1 + 2 * road / block)) / 2);
+      extent = std::max (extent, block);
+    }
+  uint32_t streets = uint32_t (extent / block) + 1;
+
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      Ptr<ConstantVelocityMobilityModel> mob = nodes.Get (i)->GetObject<ConstantVelocityMobilityModel> ();
+      double v = speed * rng->GetValue (0.8, 1.2);
+      double along = rng->GetValue (0, extent);
+      if (topology == "highway")
+        {
+          uint32_t lane = rng->GetInteger (0, lanes - 1);
+          double dir = lane < lanes / 2 ? 1 : -1;
+          mob->SetPosition (Vector (along, lane * 4.0, 0));
+          mob->SetVelocity (Vector (dir * v, 0, 0));
+        }
+      else
+        {
+          double street = rng->GetInteger (0, streets - 1) * block;
+          double dir = rng->GetValue () < 0.5 ? 1 : -1;
+          if (rng->GetValue () < 0.5)
+            {
+              mob->SetPosition (Vector (along, street, 0));
+              mob->SetVelocity (Vector (dir * v, 0, 0));
+            }
+          else
+            {
+              mob->SetPosition (Vector (street, along, 0));
+              mob->SetVelocity (Vector (0, dir * v, 0));
+            }
+        }
+    }
+  Simulator::Schedule (Seconds (1), &ScalingScenario::WrapAround, this);
+}
+
+void
+ScalingScenario::WrapAround ()
+{
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<MobilityModel> mob = (*i)->GetObject<MobilityModel> ();
+      Vector pos = mob->GetPosition ();
+      bool moved = false;
+      if (pos.x < 0 || pos.x > extent)
+        {
+          pos.x -= std::floor (pos.x / extent) * extent;
+          moved = true;
+        }
+      if (topology == "manhattan" && (pos.y < 0 || pos.y > extent))
+        {
+          pos.y -= std::floor (pos.y / extent) * extent;
+          moved = true;
+        }
+      if (moved)
+        {
+          mob->SetPosition (pos);
+        }
+    }
+  Simulator::Schedule (Seconds (1), &ScalingScenario::WrapAround, this);
+}
+
+void
+ScalingScenario::CreateDevices ()
+{
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::FriisPropagationLossModel");
+
+  YansWifiPhyHelper wifiPhy = YansWifiPhyHelper::Default ();
+  wifiPhy.Set ("RxGain", DoubleValue (-10));
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  NqosWifiMacHelper wifiMac = NqosWifiMacHelper::Default ();
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+
+  WifiHelper wifi = WifiHelper::Default ();
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211_10MHZ);
+  if (rateManager.empty ())
+    {
+      wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                    "DataMode", StringValue ("OfdmRate6MbpsBW10MHz"),
+                                    "ControlMode", StringValue ("OfdmRate6MbpsBW10MHz"));
+    }
+  else
+    {
+      wifi.SetRemoteStationManager (rateManager);
+    }
+  devices = wifi.Install (wifiPhy, wifiMac, nodes);
+}
+
+void
+ScalingScenario::InstallInternetStack ()
+{
+  GpsrHelper gpsr;
+  InternetStackHelper stack;
+  stack.SetRoutingHelper (gpsr);
+  stack.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.255.0.0");
+  interfaces = address.Assign (devices);
+}
+
+void
+ScalingScenario::InstallApplications ()
+{
+  uint16_t port = 9;
+  TypeId tid = TypeId::LookupByName ("ns3::UdpSocketFactory");
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  std::vector<bool> isSink (size, false);
+
+  for (uint32_t f = 0; f < flows; ++f)
+    {
+      uint32_t src = rng->GetInteger (0, size - 1);
+      uint32_t dst = rng->GetInteger (0, size - 2);
+      if (dst >= src)
+        {
+          dst++;
+        }
+      if (!isSink[dst])
+        {
+          Ptr<Socket> sink = Socket::CreateSocket (nodes.Get (dst), tid);
+          sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), port));
+          sink->SetRecvCallback (MakeCallback (&ScalingScenario::Receive, this));
+          isSink[dst] = true;
+        }
+      Ptr<Socket> source = Socket::CreateSocket (nodes.Get (src), tid);
+      source->Connect (InetSocketAddress (interfaces.GetAddress (dst), port));
+      Simulator::Schedule (Seconds (warmup + rng->GetValue (0, interval)),
+                           &ScalingScenario::Send, this, source);
+    }
+}
+
+void
+ScalingScenario::Send (Ptr<Socket> socket)
+{
+  socket->Send (Create<Packet> (packetSize));
+  m_sent++;
+  Simulator::Schedule (Seconds (interval), &ScalingScenario::Send, this, socket);
+}
+
+void
+ScalingScenario::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      m_received++;
+    }
+}
+
+void
+ScalingScenario::ConnectCounters ()
+{
+  for (uint32_t i = 0; i < devices.GetN (); ++i)
+    {
+      Ptr<WifiPhy> phy = DynamicCast<WifiNetDevice> (devices.Get (i))->GetPhy ();
+      phy->TraceConnectWithoutContext ("PhyTxBegin", MakeCallback (&ScalingScenario::PhyTx, this));
+      phy->TraceConnectWithoutContext ("PhyRxEnd", MakeCallback (&ScalingScenario::PhyRx, this));
+      phy->TraceConnectWithoutContext ("PhyRxDrop", MakeCallback (&ScalingScenario::PhyRxDrop, this));
+    }
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<gpsr::RoutingProtocol> gpsr = (*i)->GetObject<gpsr::RoutingProtocol> ();
+      if (gpsr != 0)
+        {
+          gpsr->TraceConnectWithoutContext ("Forward", MakeCallback (&ScalingScenario::GpsrForward, this));
+          gpsr->TraceConnectWithoutContext ("Drop", MakeCallback (&ScalingScenario::GpsrDrop, this));
+        }
+    }
+}
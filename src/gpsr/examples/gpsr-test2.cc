@@ -40,6 +40,8 @@ private:
   double totalTime;
   /// Write per-device PCAP traces if true
   bool pcap;
+  /// Record the life of every data packet in this file if not empty
+  std::string record;
   //\}
 
   ///\name network
@@ -95,6 +97,7 @@ GpsrExample::Configure (int argc, char **argv)
   cmd.AddValue ("size", "Number of nodes.", size);
   cmd.AddValue ("time", "Simulation time, s.", totalTime);
   cmd.AddValue ("step", "Grid step, m", step);
+  cmd.AddValue ("record", "Packet lifecycle record file.", record);
 
   cmd.Parse (argc, argv);
   return true;
@@ -112,11 +115,24 @@ GpsrExample::Run ()
   GpsrHelper gpsr;
   gpsr.Install ();
 
+  Ptr<GpsrPacketRecorder> recorder;
+  if (!record.empty ())
+    {
+      recorder = Create<GpsrPacketRecorder> (record);
+      recorder->InstallAll ();
+    }
+
   std::cout << "Starting simulation for " << totalTime << " s ...\n";
 
   Simulator::Stop (Seconds (totalTime));
   Simulator::Run ();
   Simulator::Destroy ();
+
+  if (recorder != 0)
+    {
+      std::cout << recorder->GetDelivered () << " of " << recorder->GetSent () << " packets delivered, "
+                << recorder->GetDropped () << " dropped\n";
+    }
 }
 
 void
@@ -25,13 +25,19 @@
 #include "ns3/node-container.h"
 #include "ns3/callback.h"
 #include "ns3/udp-l4-protocol.h"
+#include "ns3/enum.h"
+#include "ns3/god.h"
+#include "ns3/cached-location-service.h"
+#include "ns3/rls.h"
 
 namespace ns3 {
 
 GpsrHelper::GpsrHelper ()
-  : Ipv4RoutingHelper ()
+  : Ipv4RoutingHelper (),
+    m_cacheLifeTime (Seconds (0))
 {
   m_agentFactory.SetTypeId ("ns3::gpsr::RoutingProtocol");
+  m_locationService = CreateObject<GodLocationService> ();
 }
 
 GpsrHelper*
@@ -45,6 +51,29 @@ GpsrHelper::Create (Ptr<Node> node) const
 {
   //Ptr<Ipv4L4Protocol> ipv4l4 = node->GetObject<Ipv4L4Protocol> ();
   Ptr<gpsr::RoutingProtocol> gpsr = m_agentFactory.Create<gpsr::RoutingProtocol> ();
+  EnumValue lsName;
+  gpsr->GetAttribute ("LocationServiceName", lsName);
+  Ptr<LocationService> ls;
+  if (lsName.Get () == GPSR_LS_GOD)
+    {
+      ls = m_locationService;
+    }
+  else if (lsName.Get () == GPSR_LS_RLS && m_cacheLifeTime.IsStrictlyPositive ())
+    {
+      // RLS keeps per-node state, so each cache gets its own backend
+      ls = CreateObject<ReactiveLocationService> ();
+    }
+  if (ls != 0 && m_cacheLifeTime.IsStrictlyPositive ())
+    {
+      Ptr<CachedLocationService> cache = CreateObject<CachedLocationService> ();
+      cache->SetAttribute ("EntryLifeTime", TimeValue (m_cacheLifeTime));
+      cache->SetBackend (ls);
+      ls = cache;
+    }
+  if (ls != 0)
+    {
+      gpsr->SetLS (ls);
+    }
   //gpsr->SetDownTarget (ipv4l4->GetDownTarget ());
   //ipv4l4->SetDownTarget (MakeCallback (&gpsr::RoutingProtocol::AddHeaders, gpsr));
   node->AggregateObject (gpsr);
@@ -58,6 +87,18 @@ GpsrHelper::Set (std::string name, const AttributeValue &value)
 }
 
 
+void
+GpsrHelper::SetLocationService (Ptr<LocationService> locationService)
+{
+  m_locationService = locationService;
+}
+
+void
+GpsrHelper::SetLocationCache (Time entryLifeTime)
+{
+  m_cacheLifeTime = entryLifeTime;
+}
+
 void 
 GpsrHelper::Install (void) const
 {
@@ -24,6 +24,8 @@
 #include "ns3/node.h"
 #include "ns3/node-container.h"
 #include "ns3/ipv4-routing-helper.h"
+#include "ns3/location-service.h"
+#include "ns3/nstime.h"
 
 namespace ns3 {
 /**
@@ -63,8 +65,28 @@ public:
 
   void Install (void) const;
 
+  /**
+   * \param locationService the location service given to every node created by this helper
+   *
+   * By default all nodes using the GOD location service share one GodLocationService
+   * instance. Pass 0 to let each node create its own in RoutingProtocol::Start.
+   */
+  void SetLocationService (Ptr<LocationService> locationService);
+
+  /**
+   * \param entryLifeTime how long each node serves a cached position, zero to disable
+   *
+   * Puts a per-node CachedLocationService in front of the location service:
+   * the shared one for GOD, a per-node ReactiveLocationService for RLS.
+   */
+  void SetLocationCache (Time entryLifeTime);
+
 private:
   ObjectFactory m_agentFactory;
+  /// Location service shared by all nodes
+  Ptr<LocationService> m_locationService;
+  /// Lifetime of the per-node location cache entries, zero if disabled
+  Time m_cacheLifeTime;
 };
 
 }
@@ -0,0 +1,258 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "gpsr-packet-recorder.h"
+#include "ns3/gpsr.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/callback.h"
+
+NS_LOG_COMPONENT_DEFINE ("GpsrPacketRecorder");
+
+namespace ns3 {
+
+static const char g_magic[4] = { 'G', 'P', 'K', 'T' };
+
+GpsrPacketRecorder::GpsrPacketRecorder (std::string filename, uint32_t rowGroupSize)
+  : m_file (Create<AsyncOutputStream> (filename)),
+    m_rowGroupSize (rowGroupSize == 0 ? 1 : rowGroupSize),
+    m_sent (0),
+    m_delivered (0),
+    m_dropped (0)
+{
+  uint32_t version = VERSION;
+  m_file->Write (g_magic, sizeof (g_magic));
+  m_file->Write (&version, sizeof (version));
+  m_file->SetCloseCallback (MakeCallback (&GpsrPacketRecorder::Flush, this));
+}
+
+GpsrPacketRecorder::~GpsrPacketRecorder ()
+{
+  Close ();
+}
+
+void
+GpsrPacketRecorder::Install (NodeContainer nodes)
+{
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<gpsr::RoutingProtocol> gpsr = (*i)->GetObject<gpsr::RoutingProtocol> ();
+      if (gpsr == 0)
+        {
+          NS_LOG_WARN ("Node " << (*i)->GetId () << " does not run GPSR");
+          continue;
+        }
+      uint32_t id = (*i)->GetId ();
+      gpsr->TraceConnectWithoutContext ("Tx", MakeCallback (&GpsrPacketRecorder::Tx, this).Bind (id));
+      gpsr->TraceConnectWithoutContext ("Forward", MakeCallback (&GpsrPacketRecorder::Forward, this).Bind (id));
+      gpsr->TraceConnectWithoutContext ("Dequeue", MakeCallback (&GpsrPacketRecorder::Dequeue, this).Bind (id));
+      gpsr->TraceConnectWithoutContext ("Deliver", MakeCallback (&GpsrPacketRecorder::Deliver, this).Bind (id));
+      gpsr->TraceConnectWithoutContext ("Drop", MakeCallback (&GpsrPacketRecorder::Drop, this).Bind (id));
+    }
+}
+
+void
+GpsrPacketRecorder::InstallAll (void)
+{
+  Install (NodeContainer::GetGlobal ());
+}
+
+uint64_t
+GpsrPacketRecorder::GetSent (void) const
+{
+  return m_sent;
+}
+
+uint64_t
+GpsrPacketRecorder::GetDelivered (void) const
+{
+  return m_delivered;
+}
+
+uint64_t
+GpsrPacketRecorder::GetDropped (void) const
+{
+  return m_dropped;
+}
+
+void
+GpsrPacketRecorder::Tx (uint32_t node, Ptr<const Packet> p, Ipv4Address dst)
+{
+  if (m_inFlight.find (p->GetUid ()) != m_inFlight.end ())
+    {
+      return;
+    }
+  PacketRow &row = m_inFlight[p->GetUid ()];
+  row.src = node;
+  row.dst = dst.Get ();
+  row.sent = Simulator::Now ().GetNanoSeconds ();
+  row.queueWait = 0;
+  row.hops = 0;
+  m_sent++;
+}
+
+void
+GpsrPacketRecorder::Forward (uint32_t node, Ptr<const Packet> p, Ipv4Address nextHop, Vector position, uint8_t mode)
+{
+  std::map<uint64_t, PacketRow>::iterator i = m_inFlight.find (p->GetUid ());
+  if (i == m_inFlight.end ())
+    {
+      return;
+    }
+  i->second.hops++;
+  m_hUid.push_back (p->GetUid ());
+  m_hNode.push_back (node);
+  m_hTime.push_back (Simulator::Now ().GetNanoSeconds ());
+  m_hX.push_back (position.x);
+  m_hY.push_back (position.y);
+  m_hMode.push_back (mode);
+  if (m_hUid.size () >= m_rowGroupSize)
+    {
+      WriteHops ();
+    }
+}
+
+void
+GpsrPacketRecorder::Dequeue (uint32_t node, Ptr<const Packet> p, Time wait)
+{
+  std::map<uint64_t, PacketRow>::iterator i = m_inFlight.find (p->GetUid ());
+  if (i != m_inFlight.end ())
+    {
+      i->second.queueWait += wait.GetNanoSeconds ();
+    }
+}
+
+void
+GpsrPacketRecorder::Deliver (uint32_t node, Ptr<const Packet> p)
+{
+  std::map<uint64_t, PacketRow>::iterator i = m_inFlight.find (p->GetUid ());
+  if (i == m_inFlight.end ())
+    {
+      return;
+    }
+  m_delivered++;
+  Finish (i->first, i->second, 1, 0);
+  m_inFlight.erase (i);
+}
+
+void
+GpsrPacketRecorder::Drop (uint32_t node, Ptr<const Packet> p, uint8_t reason)
+{
+  std::map<uint64_t, PacketRow>::iterator i = m_inFlight.find (p->GetUid ());
+  if (i == m_inFlight.end ())
+    {
+      return;
+    }
+  m_dropped++;
+  Finish (i->first, i->second, 2, reason);
+  m_inFlight.erase (i);
+}
+
+void
+GpsrPacketRecorder::Finish (uint64_t uid, const PacketRow &row, uint8_t outcome, uint8_t reason)
+{
+  m_pUid.push_back (uid);
+  m_pSrc.push_back (row.src);
+  m_pDst.push_back (row.dst);
+  m_pSent.push_back (row.sent);
+  m_pEnd.push_back (outcome == 0 ? -1 : Simulator::Now ().GetNanoSeconds ());
+  m_pQueueWait.push_back (row.queueWait);
+  m_pHops.push_back (row.hops);
+  m_pOutcome.push_back (outcome);
+  m_pReason.push_back (reason);
+  if (m_pUid.size () >= m_rowGroupSize)
+    {
+      WritePackets ();
+    }
+}
+
+template <typename T>
+void
+GpsrPacketRecorder::WriteColumn (const std::vector<T> &column)
+{
+  if (!column.empty ())
+    {
+      m_file->Write (&column[0], column.size () * sizeof (T));
+    }
+}
+
+void
+GpsrPacketRecorder::WritePackets (void)
+{
+  if (m_pUid.empty ())
+    {
+      return;
+    }
+  uint8_t table = 1;
+  uint32_t rows = m_pUid.size ();
+  m_file->Write (&table, sizeof (table));
+  m_file->Write (&rows, sizeof (rows));
+  WriteColumn (m_pUid);
+  WriteColumn (m_pSrc);
+  WriteColumn (m_pDst);
+  WriteColumn (m_pSent);
+  WriteColumn (m_pEnd);
+  WriteColumn (m_pQueueWait);
+  WriteColumn (m_pHops);
+  WriteColumn (m_pOutcome);
+  WriteColumn (m_pReason);
+  m_pUid.clear ();
+  m_pSrc.clear ();
+  m_pDst.clear ();
+  m_pSent.clear ();
+  m_pEnd.clear ();
+  m_pQueueWait.clear ();
+  m_pHops.clear ();
+  m_pOutcome.clear ();
+  m_pReason.clear ();
+}
+
+void
+GpsrPacketRecorder::WriteHops (void)
+{
+  if (m_hUid.empty ())
+    {
+      return;
+    }
+  uint8_t table = 2;
+  uint32_t rows = m_hUid.size ();
+  m_file->Write (&table, sizeof (table));
+  m_file->Write (&rows, sizeof (rows));
+  WriteColumn (m_hUid);
+  WriteColumn (m_hNode);
+  WriteColumn (m_hTime);
+  WriteColumn (m_hX);
+  WriteColumn (m_hY);
+  WriteColumn (m_hMode);
+  m_hUid.clear ();
+  m_hNode.clear ();
+  m_hTime.clear ();
+  m_hX.clear ();
+  m_hY.clear ();
+  m_hMode.clear ();
+}
+
+void
+GpsrPacketRecorder::Close (void)
+{
+  if (m_file != 0)
+    {
+      m_file->Close ();
+      m_file = 0;
+    }
+}
+
+void
+GpsrPacketRecorder::Flush (void)
+{
+  for (std::map<uint64_t, PacketRow>::const_iterator i = m_inFlight.begin (); i != m_inFlight.end (); ++i)
+    {
+      Finish (i->first, i->second, 0, 0);
+    }
+  m_inFlight.clear ();
+  WritePackets ();
+  WriteHops ();
+  NS_LOG_DEBUG ("Recorded " << m_sent << " packets, " << m_delivered << " delivered, "
+                            << m_dropped << " dropped");
+}
+
+} // namespace ns3
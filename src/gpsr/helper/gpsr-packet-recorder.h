@@ -0,0 +1,126 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef GPSR_PACKET_RECORDER_H
+#define GPSR_PACKET_RECORDER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+#include "ns3/simple-ref-count.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/vector.h"
+#include "ns3/nstime.h"
+#include "ns3/async-output-stream.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup gpsr
+ * \brief Records the life of every GPSR data packet in a columnar file
+ *
+ * Connects to the Tx, Forward, Dequeue, Deliver and Drop trace sources of
+ * gpsr::RoutingProtocol and keeps one row per packet (keyed by UID) and one
+ * row per hop. Rows are written in blocks of up to RowGroupSize rows, each
+ * column of a block stored as a contiguous array, so that a block can be
+ * read straight into numpy arrays:
+ *
+ * \verbatim
+   file     "GPKT" | version (u32) | block*
+   block    table (u8) | rows (u32) | column arrays, in the order below
+   table 1  packets: uid u64 | src node u32 | dst address u32 | sent ns i64 |
+            end ns i64 | queue wait ns i64 | hops u16 | outcome u8 | reason u8
+   table 2  hops: uid u64 | node u32 | time ns i64 | x f32 | y f32 | mode u8
+   \endverbatim
+ *
+ * outcome is 1 for delivered, 2 for dropped (reason is a gpsr::DropReason)
+ * and 0 for packets still in flight when the recorder is closed, i.e. lost
+ * below GPSR. mode is 0 for greedy and 1 for perimeter forwarding. Values
+ * are in host byte order.
+ */
+class GpsrPacketRecorder : public SimpleRefCount<GpsrPacketRecorder>
+{
+public:
+  static const uint32_t VERSION = 1;
+
+  /**
+   * \param filename file to write
+   * \param rowGroupSize rows buffered per table before a block is written
+   */
+  GpsrPacketRecorder (std::string filename, uint32_t rowGroupSize = 65536);
+  ~GpsrPacketRecorder ();
+
+  /// Record the packets of the GPSR agents of nodes
+  void Install (NodeContainer nodes);
+  /// Record the packets of every GPSR agent
+  void InstallAll (void);
+
+  /// Write the remaining rows and close the file; done by Simulator::Destroy
+  void Close (void);
+
+  uint64_t GetSent (void) const;
+  uint64_t GetDelivered (void) const;
+  uint64_t GetDropped (void) const;
+
+private:
+  struct PacketRow
+  {
+    uint32_t src;
+    uint32_t dst;
+    int64_t sent;
+    int64_t queueWait;
+    uint16_t hops;
+  };
+
+  void Tx (uint32_t node, Ptr<const Packet> p, Ipv4Address dst);
+  void Forward (uint32_t node, Ptr<const Packet> p, Ipv4Address nextHop, Vector position, uint8_t mode);
+  void Dequeue (uint32_t node, Ptr<const Packet> p, Time wait);
+  void Deliver (uint32_t node, Ptr<const Packet> p);
+  void Drop (uint32_t node, Ptr<const Packet> p, uint8_t reason);
+
+  /// Write packets in flight and the pending blocks, before m_file closes
+  void Flush (void);
+  /// Move the packet to the packets table
+  void Finish (uint64_t uid, const PacketRow &row, uint8_t outcome, uint8_t reason);
+  void WritePackets (void);
+  void WriteHops (void);
+  template <typename T>
+  void WriteColumn (const std::vector<T> &column);
+
+  Ptr<AsyncOutputStream> m_file;
+  uint32_t m_rowGroupSize;
+  uint64_t m_sent;
+  uint64_t m_delivered;
+  uint64_t m_dropped;
+
+  /// Packets sent but neither delivered nor dropped yet
+  std::map<uint64_t, PacketRow> m_inFlight;
+
+  ///\name Packets table, pending block
+  //\{
+  std::vector<uint64_t> m_pUid;
+  std::vector<uint32_t> m_pSrc;
+  std::vector<uint32_t> m_pDst;
+  std::vector<int64_t> m_pSent;
+  std::vector<int64_t> m_pEnd;
+  std::vector<int64_t> m_pQueueWait;
+  std::vector<uint16_t> m_pHops;
+  std::vector<uint8_t> m_pOutcome;
+  std::vector<uint8_t> m_pReason;
+  //\}
+
+  ///\name Hops table, pending block
+  //\{
+  std::vector<uint64_t> m_hUid;
+  std::vector<uint32_t> m_hNode;
+  std::vector<int64_t> m_hTime;
+  std::vector<float> m_hX;
+  std::vector<float> m_hY;
+  std::vector<uint8_t> m_hMode;
+  //\}
+};
+
+} // namespace ns3
+
+#endif /* GPSR_PACKET_RECORDER_H */
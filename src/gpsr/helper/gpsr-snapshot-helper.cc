@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "gpsr-snapshot-helper.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+
+NS_LOG_COMPONENT_DEFINE ("GpsrSnapshotHelper");
+
+namespace ns3 {
+
+void
+GpsrSnapshotHelper::Save (std::string filename, NodeContainer nodes)
+{
+  std::ofstream os (filename.c_str ());
+  if (!os)
+    {
+      NS_LOG_ERROR ("Can not write snapshot " << filename);
+      return;
+    }
+  os << std::setprecision (std::numeric_limits<double>::digits10 + 2);
+  os << "GPSR-SNAPSHOT " << VERSION << std::endl;
+  os << "time " << Simulator::Now ().GetNanoSeconds () << std::endl;
+  os << "rng " << RngSeedManager::GetSeed () << " " << RngSeedManager::GetRun () << std::endl;
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      Ptr<MobilityModel> mobility = (*i)->GetObject<MobilityModel> ();
+      if (mobility != 0)
+        {
+          Vector pos = mobility->GetPosition ();
+          Vector vel = mobility->GetVelocity ();
+          os << "node " << (*i)->GetId ()
+             << " " << pos.x << " " << pos.y << " " << pos.z
+             << " " << vel.x << " " << vel.y << " " << vel.z << std::endl;
+        }
+      Ptr<gpsr::RoutingProtocol> gpsr = (*i)->GetObject<gpsr::RoutingProtocol> ();
+      if (gpsr != 0)
+        {
+          os << "gpsr " << (*i)->GetId () << std::endl;
+          gpsr->SaveState (os);
+        }
+    }
+  NS_LOG_INFO ("Saved " << nodes.GetN () << " nodes at " << Simulator::Now ().GetSeconds ()
+                        << "s to " << filename);
+}
+
+bool
+GpsrSnapshotHelper::Restore (std::string filename, NodeContainer nodes, bool restoreMobility)
+{
+  std::ifstream is (filename.c_str ());
+  std::string magic;
+  uint32_t version = 0;
+  is >> magic >> version;
+  if (!is || magic != "GPSR-SNAPSHOT" || version != VERSION)
+    {
+      NS_LOG_ERROR ("Can not read snapshot " << filename);
+      return false;
+    }
+
+  std::map<uint32_t, Ptr<Node> > byId;
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      byId[(*i)->GetId ()] = *i;
+    }
+
+  uint32_t restored = 0;
+  std::string line;
+  std::getline (is, line);
+  while (std::getline (is, line))
+    {
+      std::istringstream record (line);
+      std::string keyword;
+      record >> keyword;
+      if (keyword == "time")
+        {
+          int64_t saved;
+          record >> saved;
+          NS_LOG_INFO ("Snapshot taken at " << NanoSeconds (saved).GetSeconds () << "s");
+        }
+      else if (keyword == "rng")
+        {
+          uint32_t seed;
+          uint64_t run;
+          record >> seed >> run;
+          if (seed != RngSeedManager::GetSeed () || run != RngSeedManager::GetRun ())
+            {
+              NS_LOG_INFO ("Snapshot saved with seed " << seed << " run " << run);
+            }
+        }
+      else if (keyword == "node")
+        {
+          uint32_t id;
+          Vector pos, vel;
+          record >> id >> pos.x >> pos.y >> pos.z >> vel.x >> vel.y >> vel.z;
+          std::map<uint32_t, Ptr<Node> >::iterator node = byId.find (id);
+          if (!restoreMobility || node == byId.end ())
+            {
+              continue;
+            }
+          Ptr<MobilityModel> mobility = node->second->GetObject<MobilityModel> ();
+          if (mobility == 0)
+            {
+              continue;
+            }
+          mobility->SetPosition (pos);
+          Ptr<ConstantVelocityMobilityModel> cv = DynamicCast<ConstantVelocityMobilityModel> (mobility);
+          if (cv != 0)
+            {
+              cv->SetVelocity (vel);
+            }
+        }
+      else if (keyword == "gpsr")
+        {
+          uint32_t id;
+          record >> id;
+          // The block runs up to its "end" line
+          std::ostringstream block;
+          while (std::getline (is, line))
+            {
+              block << line << '\n';
+              if (line == "end")
+                {
+                  break;
+                }
+            }
+          std::map<uint32_t, Ptr<Node> >::iterator node = byId.find (id);
+          if (node == byId.end ())
+            {
+              continue;
+            }
+          Ptr<gpsr::RoutingProtocol> gpsr = node->second->GetObject<gpsr::RoutingProtocol> ();
+          if (gpsr == 0)
+            {
+              NS_LOG_WARN ("Node " << id << " does not run GPSR");
+              continue;
+            }
+          // After RoutingProtocol::Start, itself scheduled now by SetIpv4
+          Simulator::ScheduleNow (&GpsrSnapshotHelper::RestoreNode, gpsr, block.str ());
+          restored++;
+        }
+    }
+  if (restored != nodes.GetN ())
+    {
+      NS_LOG_WARN ("Snapshot " << filename << " restored " << restored << " of "
+                               << nodes.GetN () << " nodes");
+    }
+  return true;
+}
+
+void
+GpsrSnapshotHelper::RestoreNode (Ptr<gpsr::RoutingProtocol> gpsr, std::string state)
+{
+  std::istringstream is (state);
+  gpsr->RestoreState (is);
+}
+
+} // namespace ns3
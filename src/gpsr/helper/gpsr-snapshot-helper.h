@@ -0,0 +1,64 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef GPSR_SNAPSHOT_HELPER_H
+#define GPSR_SNAPSHOT_HELPER_H
+
+#include <string>
+#include "ns3/node-container.h"
+#include "ns3/gpsr.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup gpsr
+ * \brief Saves the converged GPSR state of a run and restores it in another
+ *
+ * A scenario that sweeps parameters after a warm-up spends most of its time
+ * re-learning the same neighbour tables. Save the state at the end of the
+ * warm-up once:
+ *
+ * \code
+ * Simulator::Schedule (warmup, &GpsrSnapshotHelper::Save, "warm.snap", nodes);
+ * \endcode
+ *
+ * and start the following runs from it, before Simulator::Run:
+ *
+ * \code
+ * GpsrSnapshotHelper::Restore ("warm.snap", nodes);
+ * \endcode
+ *
+ * The snapshot is a text file holding, per node, the position and velocity
+ * and the GPSR state (hello phase, neighbour table, location service
+ * entries). Entries keep their age, so they expire as in the saved run; the
+ * restored run starts at time 0 and its traffic should start right away.
+ *
+ * Only the seed and run number are saved, not the state of the random
+ * streams: a restored run is a statistically equivalent continuation, not a
+ * bit-exact one. Mobility is restored for ConstantVelocityMobilityModel
+ * (position and velocity) and, for the position only, for other models; a
+ * trace-driven model resumes from the start of its trace.
+ */
+class GpsrSnapshotHelper
+{
+public:
+  static const uint32_t VERSION = 1;
+
+  /// Write the state of nodes to filename
+  static void Save (std::string filename, NodeContainer nodes);
+
+  /**
+   * \brief Load the state of nodes from filename
+   * \param restoreMobility also move the nodes to their saved position
+   *
+   * Nodes are matched by id. The GPSR state is applied once the agents
+   * have started, i.e. with Simulator::ScheduleNow.
+   * \return false if the file could not be read
+   */
+  static bool Restore (std::string filename, NodeContainer nodes, bool restoreMobility = true);
+
+private:
+  static void RestoreNode (Ptr<gpsr::RoutingProtocol> gpsr, std::string state);
+};
+
+} // namespace ns3
+
+#endif /* GPSR_SNAPSHOT_HELPER_H */
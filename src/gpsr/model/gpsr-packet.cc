@@ -209,7 +209,11 @@ PositionHeader::PositionHeader (uint64_t dstPosx, uint64_t dstPosy, uint32_t upd
     m_recPosy (recPosy),
     m_inRec (inRec),
     m_lastPosx (lastPosx),
-    m_lastPosy (lastPosy)
+    m_lastPosy (lastPosy),
+    m_facePosx (recPosx),
+    m_facePosy (recPosy),
+    m_firstEdgeFrom (Ipv4Address::GetZero ()),
+    m_firstEdgeTo (Ipv4Address::GetZero ())
 {
 }
 
@@ -234,7 +238,8 @@ PositionHeader::GetInstanceTypeId () const
 uint32_t
 PositionHeader::GetSerializedSize () const
 {
-  return 53;
+  // the face fields are only carried in Recovery-mode
+  return m_inRec ? 77 : 53;
 }
 
 void
@@ -248,6 +253,13 @@ PositionHeader::Serialize (Buffer::Iterator i) const
   i.WriteU8 (m_inRec);
   i.WriteU64 (m_lastPosx);
   i.WriteU64 (m_lastPosy);
+  if (m_inRec)
+    {
+      i.WriteU64 (m_facePosx);
+      i.WriteU64 (m_facePosy);
+      WriteTo (i, m_firstEdgeFrom);
+      WriteTo (i, m_firstEdgeTo);
+    }
 }
 
 uint32_t
@@ -262,6 +274,20 @@ PositionHeader::Deserialize (Buffer::Iterator start)
   m_inRec = i.ReadU8 ();
   m_lastPosx = i.ReadU64 ();
   m_lastPosy = i.ReadU64 ();
+  if (m_inRec)
+    {
+      m_facePosx = i.ReadU64 ();
+      m_facePosy = i.ReadU64 ();
+      ReadFrom (i, m_firstEdgeFrom);
+      ReadFrom (i, m_firstEdgeTo);
+    }
+  else
+    {
+      m_facePosx = m_recPosx;
+      m_facePosy = m_recPosy;
+      m_firstEdgeFrom = Ipv4Address::GetZero ();
+      m_firstEdgeTo = Ipv4Address::GetZero ();
+    }
 
   uint32_t dist = i.GetDistanceFrom (start);
   NS_ASSERT (dist == GetSerializedSize ());
@@ -278,7 +304,10 @@ PositionHeader::Print (std::ostream &os) const
      << " RecPositionY: " << m_recPosy
      << " inRec: " << (int) m_inRec
      << " LastPositionX: " << m_lastPosx
-     << " LastPositionY: " << m_lastPosy;
+     << " LastPositionY: " << m_lastPosy
+     << " FacePositionX: " << m_facePosx
+     << " FacePositionY: " << m_facePosy
+     << " FirstEdge: " << m_firstEdgeFrom << " -> " << m_firstEdgeTo;
 }
 
 std::ostream &
@@ -293,7 +322,9 @@ operator<< (std::ostream & os, PositionHeader const & h)
 bool
 PositionHeader::operator== (PositionHeader const & o) const
 {
-  return (m_dstPosx == o.m_dstPosx && m_dstPosy == m_dstPosy && m_updated == o.m_updated && m_recPosx == o.m_recPosx && m_recPosy == o.m_recPosy && m_inRec == o.m_inRec && m_lastPosx == o.m_lastPosx && m_lastPosy == o.m_lastPosy);
+  return (m_dstPosx == o.m_dstPosx && m_dstPosy == m_dstPosy && m_updated == o.m_updated && m_recPosx == o.m_recPosx && m_recPosy == o.m_recPosy && m_inRec == o.m_inRec && m_lastPosx == o.m_lastPosx && m_lastPosy == o.m_lastPosy
+          && (!m_inRec || (m_facePosx == o.m_facePosx && m_facePosy == o.m_facePosy
+                           && m_firstEdgeFrom == o.m_firstEdgeFrom && m_firstEdgeTo == o.m_firstEdgeTo)));
 }
 
 
@@ -205,18 +205,54 @@ public:
   {
     return m_lastPosy;
   }
+  void SetFacePosx (uint64_t posx)
+  {
+    m_facePosx = posx;
+  }
+  uint64_t GetFacePosx () const
+  {
+    return m_facePosx;
+  }
+  void SetFacePosy (uint64_t posy)
+  {
+    m_facePosy = posy;
+  }
+  uint64_t GetFacePosy () const
+  {
+    return m_facePosy;
+  }
+  void SetFirstEdgeFrom (Ipv4Address from)
+  {
+    m_firstEdgeFrom = from;
+  }
+  Ipv4Address GetFirstEdgeFrom () const
+  {
+    return m_firstEdgeFrom;
+  }
+  void SetFirstEdgeTo (Ipv4Address to)
+  {
+    m_firstEdgeTo = to;
+  }
+  Ipv4Address GetFirstEdgeTo () const
+  {
+    return m_firstEdgeTo;
+  }
 
 
   bool operator== (PositionHeader const & o) const;
 private:
   uint64_t         m_dstPosx;          ///< Destination Position x
   uint64_t         m_dstPosy;          ///< Destination Position x
-  uint32_t         m_updated;          ///< Time of last update
+  uint32_t         m_updated;          ///< Time of last update, ms
   uint64_t         m_recPosx;          ///< x of position that entered Recovery-mode
   uint64_t         m_recPosy;          ///< y of position that entered Recovery-mode
   uint8_t          m_inRec;          ///< 1 if in Recovery-mode, 0 otherwise
   uint64_t         m_lastPosx;          ///< x of position of previous hop
   uint64_t         m_lastPosy;          ///< y of position of previous hop
+  uint64_t         m_facePosx;          ///< x of the point where the current face was entered
+  uint64_t         m_facePosy;          ///< y of the point where the current face was entered
+  Ipv4Address      m_firstEdgeFrom;     ///< Sender of the first edge taken on the current face
+  Ipv4Address      m_firstEdgeTo;       ///< Receiver of the first edge taken on the current face
 
 };
 
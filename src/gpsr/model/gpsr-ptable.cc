@@ -2,6 +2,8 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <iostream>     // std::cout, std::fixed
 #include <iomanip>      // std::setprecision
 
@@ -19,7 +21,23 @@ PositionTable::PositionTable ()
 {
   m_txErrorCallback = MakeCallback (&PositionTable::ProcessTxError, this);
   m_entryLifeTime = Seconds (2); //FIXME fazer isto parametrizavel de acordo com tempo de hello
-
+  m_version = 0;
+  m_nextHopCacheVersion = 0;
+  m_nextHopCacheTimeout = Seconds (0);
+  m_nextHopCacheDistance = 10;
+  m_nextHopCacheHits = 0;
+  m_nextHopCacheMisses = 0;
+  m_nextExpiry = Seconds (0);
+  m_planarGraph = GPSR_PLANAR_GG;
+  m_planarValid = false;
+  m_planarRebuildDistance = 1;
+  m_helloInterval = Seconds (1);
+  m_snrAlpha = 0.25;
+  m_qualityLow = 0.5;
+  m_qualityHigh = 0.75;
+  m_maxTxErrors = 1;
+  m_txErrors = 0;
+  m_linkBreaks = 0;
 }
 
 Time 
@@ -40,22 +58,64 @@ PositionTable::GetEntryUpdateTime (Ipv4Address id)
 void 
 PositionTable::AddEntry (Ipv4Address id, Vector position, Vector velocity, double snr)
 {
- 
+  std::map<Ipv4Address, std::pair<NodeInfo, Time> >::iterator i = m_table.find (id);
+  if (i != m_table.end ())
+    {
+      NodeInfo &info = i->second.first;
+      bool moved = info.pos.x != position.x || info.pos.y != position.y;
+      info.pos = position;
+      info.vel = velocity;
+      // NoSnr () is a NaN, the only value unequal to itself
+      if (snr == snr)
+        {
+          info.snr = info.snrMeasured ? (1 - m_snrAlpha) * info.snr + m_snrAlpha * snr : snr;
+          info.snrMeasured = true;
+        }
+
+      // Hello intervals since the last hello, rounded since hellos are
+      // jittered by up to half an interval; the ones between were lost
+      uint32_t elapsed = 1;
+      if (m_helloInterval.IsStrictlyPositive ())
+        {
+          double gap = (Simulator::Now () - i->second.second).GetSeconds () / m_helloInterval.GetSeconds ();
+          elapsed = (uint32_t) std::min (std::max (std::floor (gap + 0.5), 1.0), (double) HELLO_WINDOW);
+        }
+      info.hellos = ((info.hellos << elapsed) | 1) & ((1u << HELLO_WINDOW) - 1);
+      info.intervals = std::min (info.intervals + elapsed, (uint32_t) HELLO_WINDOW);
+      info.txErrors /= 2;
+      i->second.second = Simulator::Now ();
+      UpdateUsable (id, info);
+      if (moved)
+        {
+          PlanarAdd (id, position);
+        }
+      return;
+    }
+
   NodeInfo node_info;
-  
-  /* Keep positioning, velocity and snr in NodeInfo struct*/
   node_info.pos = position;
   node_info.vel = velocity;
-  node_info.snr = snr;
-  
-  std::map<Ipv4Address, std::pair<NodeInfo, Time> >::iterator i = m_table.find (id);
-  if (i != m_table.end () || id.IsEqual (i->first))
+  node_info.snrMeasured = snr == snr;
+  node_info.snr = node_info.snrMeasured ? snr : 0;
+  node_info.hellos = 1;
+  node_info.intervals = 1;
+  node_info.txErrors = 0;
+  node_info.usable = true;
+  std::map<Ipv4Address, std::pair<double, Time> >::iterator b = m_broken.find (id);
+  if (b != m_broken.end ())
     {
-      m_table.erase (id);  
-      m_table.insert (std::make_pair (id, std::make_pair (node_info, Simulator::Now ())));
-      return;
+      // Dropped for tx failures: no greedy forwarding until the link recovers
+      if (b->second.second + m_entryLifeTime > Simulator::Now ())
+        {
+          node_info.txErrors = b->second.first;
+          node_info.usable = false;
+        }
+      m_broken.erase (b);
     }
   m_table.insert (std::make_pair (id, std::make_pair (node_info, Simulator::Now ())));
+  m_nextExpiry = std::min (m_nextExpiry, Simulator::Now () + m_entryLifeTime);
+  m_version++;
+  PlanarAdd (id, position);
 }
 
 /**
@@ -63,7 +123,12 @@ PositionTable::AddEntry (Ipv4Address id, Vector position, Vector velocity, doubl
  */
 void PositionTable::DeleteEntry (Ipv4Address id)
 {
-  m_table.erase (id);
+  if (m_table.erase (id) > 0)
+    {
+      m_version++;
+      ForgetMac (id);
+      PlanarRemove (id);
+    }
 }
 
 /**
@@ -103,14 +168,7 @@ PositionTable::GetPosition (Ipv4Address id)
 bool
 PositionTable::isNeighbour (Ipv4Address id)
 {
-
- std::map<Ipv4Address, std::pair<NodeInfo, Time> >::iterator i = m_table.find (id);
-  if (i != m_table.end () || id.IsEqual (i->first))
-    {
-      return true;
-    }
-
-  return false;
+  return m_table.find (id) != m_table.end ();
 }
 
 
@@ -125,8 +183,14 @@ PositionTable::Purge ()
     {
       return;
     }
+  // No entry can have expired before the earliest expiry seen on the last scan
+  if (Simulator::Now () < m_nextExpiry)
+    {
+      return;
+    }
 
   std::list<Ipv4Address> toErase;
+  Time nextExpiry = Time::Max ();
 
   std::map<Ipv4Address, std::pair<NodeInfo, Time> >::iterator i = m_table.begin ();
   std::map<Ipv4Address, std::pair<NodeInfo, Time> >::iterator listEnd = m_table.end ();
@@ -134,13 +198,29 @@ PositionTable::Purge ()
   for (; !(i == listEnd); i++)
     {
 
-      if (m_entryLifeTime + GetEntryUpdateTime (i->first) <= Simulator::Now ())
+      if (m_entryLifeTime + i->second.second <= Simulator::Now ())
         {
           toErase.insert (toErase.begin (), i->first);
 
         }
+      else
+        {
+          nextExpiry = std::min (nextExpiry, m_entryLifeTime + i->second.second);
+        }
+    }
+  m_nextExpiry = nextExpiry;
+
+  for (std::map<Ipv4Address, std::pair<double, Time> >::iterator b = m_broken.begin (); b != m_broken.end (); )
+    {
+      if (b->second.second + m_entryLifeTime <= Simulator::Now ())
+        {
+          m_broken.erase (b++);
+        }
+      else
+        {
+          ++b;
+        }
     }
-  toErase.unique ();
 
   std::list<Ipv4Address>::iterator end = toErase.end ();
 
@@ -148,8 +228,61 @@ PositionTable::Purge ()
     {
 
       m_table.erase (*it);
+      ForgetMac (*it);
+      PlanarRemove (*it);
 
     }
+  if (!toErase.empty ())
+    {
+      m_version++;
+    }
+}
+
+double
+PositionTable::GetLinkQuality (Ipv4Address id) const
+{
+  std::map<Ipv4Address, std::pair<NodeInfo, Time> >::const_iterator i = m_table.find (id);
+  if (i == m_table.end ())
+    {
+      return 0;
+    }
+  return GetLinkQuality (i->second.first);
+}
+
+double
+PositionTable::GetSnr (Ipv4Address id) const
+{
+  std::map<Ipv4Address, std::pair<NodeInfo, Time> >::const_iterator i = m_table.find (id);
+  if (i == m_table.end ())
+    {
+      return 0;
+    }
+  return i->second.first.snr;
+}
+
+double
+PositionTable::GetLinkQuality (NodeInfo const &info) const
+{
+  uint32_t received = 0;
+  for (uint32_t bits = info.hellos; bits != 0; bits >>= 1)
+    {
+      received += bits & 1;
+    }
+  return received / (double) info.intervals / (1 + info.txErrors);
+}
+
+void
+PositionTable::UpdateUsable (Ipv4Address id, NodeInfo &info)
+{
+  double quality = GetLinkQuality (info);
+  bool usable = info.usable ? quality >= m_qualityLow : quality >= m_qualityHigh;
+  if (usable != info.usable)
+    {
+      NS_LOG_DEBUG ("Link to " << id << " quality " << quality
+                               << (usable ? ", usable again" : ", no longer usable"));
+      info.usable = usable;
+      m_version++;
+    }
 }
 
 /**
@@ -159,6 +292,12 @@ void
 PositionTable::Clear ()
 {
   m_table.clear ();
+  m_neighborMacs.clear ();
+  m_macNeighbors.clear ();
+  m_broken.clear ();
+  m_nextHopCache.clear ();
+  m_version++;
+  m_planarValid = false;
 }
 
 
@@ -421,58 +560,252 @@ PositionTable::BestNeighbor (Vector dstPos, Vector dstVel, Vector nodePos, Vecto
   double snr = 0.0;
  
   double initialW = calculateW (nodePos, nodeVel, dstPos, dstVel, nodePos, nodeVel, snr, m_table.begin ()->first);
-  
-  double W = calculateW (m_table.begin ()->second.first.pos, m_table.begin ()->second.first.vel, 
-          dstPos, dstVel, nodePos, nodeVel, m_table.begin ()->second.first.snr, m_table.begin ()->first);
-  
-  
+  double W = std::numeric_limits<double>::max ();
+
 //        std::cout << "T: " << std::fixed << std::setprecision(4) << Simulator::Now ().GetSeconds()              
 //              << " \tNode_pos " << nodePos
 //              << " \tDst pos " << dstPos
 //              << "\n";
 
-  
-//  double W = initialW;
-  
-//  std::cout << "dstPos: " << dstPos << "\n";
-//  std::cout << "Initial W: " << initialW << "\n velocity: " << m_table.begin ()->second.first.vel << "\n";
-  
   std::map<Ipv4Address, std::pair<NodeInfo, Time> >::iterator i;
   for (i = m_table.begin (); !(i == m_table.end ()); i++)
     {
-      std::cout << std::fixed;
-      
-//      std::cout << "T: " << std::fixed << std::setprecision(4) << Simulator::Now ().GetSeconds() 
-//              << " \tNode: " << i->first 
-//              << " \tPos: " << std::setprecision(1) << i->second.first.pos
-//              << " \tVelocity: " << std::setprecision(1) << i->second.first.vel
-//              << " \tSnr: " << i->second.first.snr
-//              << " \tDst: " << std::setprecision(1) << dstPos
-//              << " \tW: " << std::setprecision(2) << calculateW (i->second.first.pos,
-//            i->second.first.vel, dstPos, dstVel, nodePos, nodeVel, i->second.first.snr, i->first) << "\n";
-      
-      if (W > calculateW (i->second.first.pos,
-            i->second.first.vel, dstPos, dstVel, nodePos, nodeVel, i->second.first.snr, i->first))
+      NodeInfo const &info = i->second.first;
+      // Lossy links are left to the recovery mode
+      if (!info.usable)
+        {
+          continue;
+        }
+      double w = calculateW (info.pos, info.vel, dstPos, dstVel, nodePos, nodeVel, info.snr, i->first);
+      if (W > w)
         {
           bestFoundID = i->first;
-          W = calculateW (i->second.first.pos,
-            i->second.first.vel, dstPos, dstVel, nodePos, nodeVel, i->second.first.snr, i->first);
+          W = w;
         }
     }
-//  std::cout << "End of loop --> W: " << W <<"\n";
   if(initialW > W)
   {
-//      std::cout << "W: " << W << "\n";
-//    std::cout << "initialW > W| bestFoundID:  " << bestFoundID << "\n";
     return bestFoundID;
   }
   else
   {
-//    std::cout << "Else| Ipv4Address::GetZero:  " << Ipv4Address::GetZero () << "\n";
     return Ipv4Address::GetZero (); //so it enters Recovery-mode
   }
 }
 
+Ipv4Address
+PositionTable::BestNeighbor (Ipv4Address dst, Vector dstPos, Vector dstVel, Vector nodePos, Vector nodeVel)
+{
+  if (!m_nextHopCacheTimeout.IsStrictlyPositive ())
+    {
+      return BestNeighbor (dstPos, dstVel, nodePos, nodeVel);
+    }
+
+  // Expire neighbours first, so that a lost next hop invalidates the cache;
+  // a neighbour added, lost or becoming (un)usable may change the best one
+  Purge ();
+  if (m_version != m_nextHopCacheVersion)
+    {
+      m_nextHopCache.clear ();
+      m_nextHopCacheVersion = m_version;
+    }
+
+  // Hellos that only move a neighbour do not invalidate the cache: the
+  // timeout bounds how far neighbours and speeds drift from the cached choice
+  std::map<Ipv4Address, NextHopCacheEntry>::iterator i = m_nextHopCache.find (dst);
+  if (i != m_nextHopCache.end ()
+      && i->second.created + m_nextHopCacheTimeout > Simulator::Now ()
+      && CalculateDistance (i->second.myPos, nodePos) <= m_nextHopCacheDistance
+      && CalculateDistance (i->second.dstPos, dstPos) <= m_nextHopCacheDistance)
+    {
+      m_nextHopCacheHits++;
+      return i->second.nextHop;
+    }
+
+  m_nextHopCacheMisses++;
+  Ipv4Address nextHop = BestNeighbor (dstPos, dstVel, nodePos, nodeVel);
+  if (nextHop == Ipv4Address::GetZero ())
+    {
+      // Recovery-mode decisions are not cached
+      m_nextHopCache.erase (dst);
+      return nextHop;
+    }
+  NextHopCacheEntry entry;
+  entry.nextHop = nextHop;
+  entry.created = Simulator::Now ();
+  entry.myPos = nodePos;
+  entry.dstPos = dstPos;
+  m_nextHopCache[dst] = entry;
+  return nextHop;
+}
+
+bool
+PositionTable::IsWitness (Vector v, Vector w) const
+{
+  Vector centre = m_planarCentre;
+  double uv = pow (v.x - centre.x, 2.0) + pow (v.y - centre.y, 2.0);
+  double uw = pow (w.x - centre.x, 2.0) + pow (w.y - centre.y, 2.0);
+  double vw = pow (w.x - v.x, 2.0) + pow (w.y - v.y, 2.0);
+  if (m_planarGraph == GPSR_PLANAR_GG)
+    {
+      // w lies inside the circle whose diameter is the edge centre-v
+      return uw + vw < uv;
+    }
+  else if (m_planarGraph == GPSR_PLANAR_RNG)
+    {
+      // w is closer to both ends than they are to each other
+      return std::max (uw, vw) < uv;
+    }
+  return false;
+}
+
+Ipv4Address
+PositionTable::FindWitness (Ipv4Address id, Vector pos) const
+{
+  std::map<Ipv4Address, std::pair<NodeInfo, Time> >::const_iterator w;
+  for (w = m_table.begin (); m_planarGraph != GPSR_PLANAR_NONE && w != m_table.end (); ++w)
+    {
+      if (w->first != id && IsWitness (pos, w->second.first.pos))
+        {
+          return w->first;
+        }
+    }
+  return Ipv4Address::GetZero ();
+}
+
+void
+PositionTable::ErasePlanar (Ipv4Address id)
+{
+  for (std::vector<PlanarNeighbor>::iterator i = m_planar.begin (); i != m_planar.end (); ++i)
+    {
+      if (i->id == id)
+        {
+          m_planar.erase (i);
+          return;
+        }
+    }
+}
+
+void
+PositionTable::InsertPlanar (Ipv4Address id, Vector pos)
+{
+  PlanarNeighbor n;
+  n.angle = atan2 (pos.y - m_planarCentre.y, pos.x - m_planarCentre.x);
+  if (n.angle < 0)
+    {
+      n.angle += 2 * M_PI;
+    }
+  n.id = id;
+  n.pos = pos;
+  m_planar.insert (std::upper_bound (m_planar.begin (), m_planar.end (), n), n);
+}
+
+void
+PositionTable::PlanarRecheck (Ipv4Address id)
+{
+  std::map<Ipv4Address, Ipv4Address>::iterator i = m_planarWitness.begin ();
+  while (i != m_planarWitness.end ())
+    {
+      if (i->second != id)
+        {
+          ++i;
+          continue;
+        }
+      std::map<Ipv4Address, std::pair<NodeInfo, Time> >::const_iterator v = m_table.find (i->first);
+      NS_ASSERT (v != m_table.end ());
+      Ipv4Address witness = FindWitness (v->first, v->second.first.pos);
+      if (witness == Ipv4Address::GetZero ())
+        {
+          InsertPlanar (v->first, v->second.first.pos);
+          m_planarWitness.erase (i++);
+        }
+      else
+        {
+          i->second = witness;
+          ++i;
+        }
+    }
+}
+
+void
+PositionTable::PlanarAdd (Ipv4Address id, Vector pos)
+{
+  if (!m_planarValid)
+    {
+      return;
+    }
+  // Only the edge to id, the edges id now lies over and the edges id
+  // used to remove can change
+  ErasePlanar (id);
+  m_planarWitness.erase (id);
+  Ipv4Address witness = FindWitness (id, pos);
+  if (witness == Ipv4Address::GetZero ())
+    {
+      InsertPlanar (id, pos);
+    }
+  else
+    {
+      m_planarWitness[id] = witness;
+    }
+
+  std::vector<PlanarNeighbor>::iterator i = m_planar.begin ();
+  while (i != m_planar.end ())
+    {
+      if (i->id != id && IsWitness (i->pos, pos))
+        {
+          m_planarWitness[i->id] = id;
+          i = m_planar.erase (i);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+
+  PlanarRecheck (id);
+}
+
+void
+PositionTable::PlanarRemove (Ipv4Address id)
+{
+  if (!m_planarValid)
+    {
+      return;
+    }
+  ErasePlanar (id);
+  m_planarWitness.erase (id);
+  PlanarRecheck (id);
+}
+
+void
+PositionTable::UpdatePlanarGraph (Vector centre)
+{
+  // The table changes are applied as they happen (PlanarAdd, PlanarRemove),
+  // only a new centre needs a rebuild. Every edge starts at the centre, so
+  // a move changes all witness tests: rebuild only once it is noticeable
+  if (m_planarValid && CalculateDistance (m_planarCentre, centre) <= m_planarRebuildDistance)
+    {
+      return;
+    }
+  m_planar.clear ();
+  m_planarWitness.clear ();
+  m_planarCentre = centre;
+
+  std::map<Ipv4Address, std::pair<NodeInfo, Time> >::const_iterator v;
+  for (v = m_table.begin (); v != m_table.end (); ++v)
+    {
+      Ipv4Address witness = FindWitness (v->first, v->second.first.pos);
+      if (witness == Ipv4Address::GetZero ())
+        {
+          InsertPlanar (v->first, v->second.first.pos);
+        }
+      else
+        {
+          m_planarWitness[v->first] = witness;
+        }
+    }
+  m_planarValid = true;
+}
 
 /**
  * \brief Gets next hop according to GPSR recovery-mode protocol (right hand rule)
@@ -482,6 +815,13 @@ PositionTable::BestNeighbor (Vector dstPos, Vector dstVel, Vector nodePos, Vecto
  */
 Ipv4Address
 PositionTable::BestAngle (Vector previousHop, Vector nodePos)
+{
+  Vector nextHopPos;
+  return BestAngle (previousHop, nodePos, nextHopPos);
+}
+
+Ipv4Address
+PositionTable::BestAngle (Vector previousHop, Vector nodePos, Vector &nextHopPos)
 {
   Purge ();
 
@@ -491,70 +831,212 @@ PositionTable::BestAngle (Vector previousHop, Vector nodePos)
       return Ipv4Address::GetZero ();
     }     //if table is empty (no neighbours)
 
-  double tmpAngle;
-  Ipv4Address bestFoundID = Ipv4Address::GetZero ();
-  double bestFoundAngle = 360;
-  std::map<Ipv4Address, std::pair<NodeInfo, Time> >::iterator i;
+  UpdatePlanarGraph (nodePos);
+  NS_ASSERT (!m_planar.empty ()); // the closest neighbour is always kept
 
-  for (i = m_table.begin (); !(i == m_table.end ()); i++)
+  PlanarNeighbor ref;
+  ref.angle = atan2 (previousHop.y - nodePos.y, previousHop.x - nodePos.x);
+  if (ref.angle < 0)
     {
-      tmpAngle = GetAngle(nodePos, previousHop, i->second.first.pos);
-      if (bestFoundAngle > tmpAngle && tmpAngle != 0)
-  {
-    bestFoundID = i->first;
-    bestFoundAngle = tmpAngle;
-  }
+      ref.angle += 2 * M_PI;
     }
-  if(bestFoundID == Ipv4Address::GetZero ()) //only if the only neighbour is who sent the packet
+
+  // The neighbour with the smallest clockwise angle from the reference edge
+  // is the one right before it in angle order (wrapping around)
+  std::vector<PlanarNeighbor>::const_iterator i = std::lower_bound (m_planar.begin (), m_planar.end (), ref);
+  if (i == m_planar.begin ())
     {
-      bestFoundID = m_table.begin ()->first;
+      i = m_planar.end ();
     }
-  return bestFoundID;
+  --i;
+  nextHopPos = i->pos;
+  return i->id;
 }
 
 
-//Gives angle between the vector CentrePos-Refpos to the vector CentrePos-node counterclockwise
-double 
-PositionTable::GetAngle (Vector centrePos, Vector refPos, Vector node){
-  double const PI = 4*atan(1);
+Ipv4Address
+PositionTable::FaceNextHop (Ipv4Address me, Vector myPos, PositionHeader &hdr, bool &loop)
+{
+  loop = false;
+  Vector dstPos (hdr.GetDstPosx (), hdr.GetDstPosy (), 0);
+  Vector recPos (hdr.GetRecPosx (), hdr.GetRecPosy (), 0);
+  Vector previousHop (hdr.GetLastPosx (), hdr.GetLastPosy (), 0);
+  Vector facePos (hdr.GetFacePosx (), hdr.GetFacePosy (), 0);
+
+  Vector nextHopPos;
+  Ipv4Address nextHop = BestAngle (previousHop, myPos, nextHopPos);
+  if (nextHop == Ipv4Address::GetZero ())
+    {
+      return nextHop;
+    }
+
+  // Face change: the edge crosses the line from the recovery point to the
+  // destination closer to the destination than where this face was entered
+  Vector cross;
+  if (SegmentIntersection (myPos, nextHopPos, recPos, dstPos, cross)
+      && CalculateDistance (cross, dstPos) < CalculateDistance (facePos, dstPos))
+    {
+      NS_LOG_LOGIC ("Face change at " << cross);
+      facePos = cross;
+      nextHop = BestAngle (nextHopPos, myPos, nextHopPos);
+      hdr.SetFirstEdgeFrom (Ipv4Address::GetZero ());
+    }
+
+  // Traversing the first edge of the face again means the whole face was
+  // walked without getting closer: the destination is unreachable
+  if (hdr.GetFirstEdgeFrom () == Ipv4Address::GetZero ())
+    {
+      hdr.SetFirstEdgeFrom (me);
+      hdr.SetFirstEdgeTo (nextHop);
+    }
+  else if (hdr.GetFirstEdgeFrom () == me && hdr.GetFirstEdgeTo () == nextHop)
+    {
+      loop = true;
+      return Ipv4Address::GetZero ();
+    }
 
-  std::complex<double> A = std::complex<double>(centrePos.x,centrePos.y);
-  std::complex<double> B = std::complex<double>(node.x,node.y);
-  std::complex<double> C = std::complex<double>(refPos.x,refPos.y);   //Change B with C if you want angles clockwise
+  hdr.SetInRec (1);
+  hdr.SetLastPosx (myPos.x);
+  hdr.SetLastPosy (myPos.y);
+  hdr.SetFacePosx (facePos.x);
+  hdr.SetFacePosy (facePos.y);
+  return nextHop;
+}
 
-  std::complex<double> AB; //reference edge
-  std::complex<double> AC;
-  std::complex<double> tmp;
-  std::complex<double> tmpCplx;
+bool
+PositionTable::SegmentIntersection (Vector a1, Vector a2, Vector b1, Vector b2, Vector &cross)
+{
+  double rx = a2.x - a1.x, ry = a2.y - a1.y;
+  double sx = b2.x - b1.x, sy = b2.y - b1.y;
+  double d = rx * sy - ry * sx;
+  if (std::fabs (d) < 1e-9)
+    {
+      return false; // parallel
+    }
+  double qx = b1.x - a1.x, qy = b1.y - a1.y;
+  double t = (qx * sy - qy * sx) / d;
+  double u = (qx * ry - qy * rx) / d;
+  if (t < 0 || t > 1 || u < 0 || u > 1)
+    {
+      return false;
+    }
+  cross = Vector (a1.x + t * rx, a1.y + t * ry, 0);
+  return true;
+}
 
-  std::complex<double> Angle;
+//Gives angle between the vector CentrePos-Refpos to the vector CentrePos-node counterclockwise
+double 
+PositionTable::GetAngle (Vector centrePos, Vector refPos, Vector node){
+  double angle = atan2 (refPos.y - centrePos.y, refPos.x - centrePos.x)
+    - atan2 (node.y - centrePos.y, node.x - centrePos.x);
+  angle *= 180 / M_PI;
+  if (angle < 0)
+    {
+      angle += 360;
+    }
+  return angle;
+}
 
-  AB = B - A;
-  AB = (real(AB)/norm(AB)) + (std::complex<double>(0.0,1.0)*(imag(AB)/norm(AB)));
 
-  AC = C - A;
-  AC = (real(AC)/norm(AC)) + (std::complex<double>(0.0,1.0)*(imag(AC)/norm(AC)));
 
-  tmp = log(AC/AB);
-  tmpCplx = std::complex<double>(0.0,-1.0);
-  Angle = tmp*tmpCplx;
-  Angle *= (180/PI);
-  if (real(Angle)<0)
-    Angle = 360+real(Angle);
 
-  return real(Angle);
 
+/**
+ * \brief Gets the position and velocity of a neighbour, extrapolated to now
+ */
+bool
+PositionTable::GetKinematics (Ipv4Address id, Vector &position, Vector &velocity)
+{
+  std::map<Ipv4Address, std::pair<NodeInfo, Time> >::const_iterator i = m_table.find (id);
+  if (i == m_table.end ())
+    {
+      return false;
+    }
+  double age = (Simulator::Now () - i->second.second).GetSeconds ();
+  NodeInfo const &info = i->second.first;
+  position = Vector (info.pos.x + info.vel.x * age,
+                     info.pos.y + info.vel.y * age,
+                     info.pos.z + info.vel.z * age);
+  velocity = info.vel;
+  return true;
 }
 
+void
+PositionTable::SetNeighborMac (Ipv4Address id, Mac48Address mac)
+{
+  std::map<Ipv4Address, Mac48Address>::iterator i = m_neighborMacs.find (id);
+  if (i != m_neighborMacs.end ())
+    {
+      if (i->second == mac)
+        {
+          return;
+        }
+      m_macNeighbors.erase (i->second);
+    }
+  m_neighborMacs[id] = mac;
+  m_macNeighbors[mac] = id;
+}
 
+void
+PositionTable::ForgetMac (Ipv4Address id)
+{
+  std::map<Ipv4Address, Mac48Address>::iterator i = m_neighborMacs.find (id);
+  if (i != m_neighborMacs.end ())
+    {
+      m_macNeighbors.erase (i->second);
+      m_neighborMacs.erase (i);
+    }
+}
 
-
+Ipv4Address
+PositionTable::LookupNeighbor (Mac48Address mac) const
+{
+  std::map<Mac48Address, Ipv4Address>::const_iterator i = m_macNeighbors.find (mac);
+  // The MAC is recorded from the frame of a hello, before the hello itself
+  // adds the neighbour
+  if (i == m_macNeighbors.end () || m_table.find (i->second) == m_table.end ())
+    {
+      return Ipv4Address::GetZero ();
+    }
+  return i->second;
+}
 
 /**
  * \ProcessTxError
  */
 void PositionTable::ProcessTxError (WifiMacHeader const & hdr)
 {
+  if (!hdr.IsData ())
+    {
+      return;
+    }
+  m_txErrors++;
+  Mac48Address mac = hdr.GetAddr1 ();
+  std::map<Ipv4Address, std::pair<NodeInfo, Time> >::iterator i = m_table.find (LookupNeighbor (mac));
+  if (i == m_table.end ())
+    {
+      return;
+    }
+  Ipv4Address id = i->first;
+  NodeInfo &info = i->second.first;
+  info.txErrors += 1;
+  if (m_maxTxErrors == 0 || info.txErrors < m_maxTxErrors)
+    {
+      NS_LOG_DEBUG ("Tx error to " << id);
+      UpdateUsable (id, info);
+      return;
+    }
+
+  // The neighbour most likely left: drop it now rather than when its
+  // entry expires, which would cost a full retry chain per packet
+  NS_LOG_DEBUG ("Link to " << id << " broken after " << info.txErrors << " tx errors");
+  m_broken[id] = std::make_pair (info.txErrors, Simulator::Now ());
+  m_linkBreaks++;
+  DeleteEntry (id);
+  if (!m_linkBreakCallback.IsNull ())
+    {
+      m_linkBreakCallback (id, mac);
+    }
 }
 
 
@@ -588,10 +1070,65 @@ PositionTable::PrintPositionTable (Ptr<OutputStreamWrapper> stream) const
         *os << "IP: " << i->first << "\t"
             << "Pos: " << i->second.first.pos.x << ", " << i->second.first.pos.y << "\t"
             << "Vel: " << i->second.first.vel.x << ", " << i->second.first.vel.y << "\t"
+            << "Snr: " << i->second.first.snr << "\t"
+            << "Quality: " << GetLinkQuality (i->second.first) << "\t"
             << "Time: " <<  i->second.second.GetSeconds()
             << "\n\n";    
       }
 }
 
+void
+PositionTable::SaveState (std::ostream &os) const
+{
+  Time now = Simulator::Now ();
+  std::map<Ipv4Address, std::pair<NodeInfo, Time> >::const_iterator i;
+  for (i = m_table.begin (); i != m_table.end (); ++i)
+    {
+      const NodeInfo &info = i->second.first;
+      os << "neighbor " << i->first
+         << " " << info.pos.x << " " << info.pos.y << " " << info.pos.z
+         << " " << info.vel.x << " " << info.vel.y << " " << info.vel.z
+         << " " << info.snr
+         << " " << (now - i->second.second).GetNanoSeconds ()
+         << " " << info.hellos << " " << info.intervals
+         << " " << info.txErrors << " " << info.usable << " " << info.snrMeasured << std::endl;
+    }
+}
+
+void
+PositionTable::RestoreState (std::istream &is)
+{
+  std::string addr;
+  NodeInfo info;
+  int64_t age;
+  if (!(is >> addr >> info.pos.x >> info.pos.y >> info.pos.z
+        >> info.vel.x >> info.vel.y >> info.vel.z >> info.snr >> age))
+    {
+      NS_LOG_WARN ("Malformed neighbor entry in saved state");
+      return;
+    }
+  // The link estimator, absent from states saved before it existed
+  if (!(is >> info.hellos >> info.intervals >> info.txErrors >> info.usable))
+    {
+      info.hellos = 1;
+      info.intervals = 1;
+      info.txErrors = 0;
+      info.usable = true;
+    }
+  // Also absent from older states, whose snr was always taken as measured
+  if (!(is >> info.snrMeasured))
+    {
+      info.snrMeasured = true;
+    }
+  info.hellos &= (1u << HELLO_WINDOW) - 1;
+  info.intervals = std::min (std::max (info.intervals, (uint32_t) 1), (uint32_t) HELLO_WINDOW);
+  // The entry may have been refreshed before the restored run started
+  Time updated = Simulator::Now () - NanoSeconds (age);
+  m_table[Ipv4Address (addr.c_str ())] = std::make_pair (info, updated);
+  m_nextExpiry = std::min (m_nextExpiry, updated + m_entryLifeTime);
+  m_version++;
+  PlanarAdd (Ipv4Address (addr.c_str ()), info.pos);
+}
+
 }   // gpsr
 } // ns3
@@ -2,6 +2,7 @@
 #define GPSR_PTABLE_H
 
 #include <map>
+#include <limits>
 #include <cassert>
 #include <stdint.h>
 #include "ns3/ipv4.h"
@@ -12,8 +13,10 @@
 #include "ns3/mobility-model.h"
 #include "ns3/vector.h"
 #include "ns3/wifi-mac-header.h"
+#include "ns3/mac48-address.h"
 #include "ns3/random-variable.h"
 #include "ns3/output-stream-wrapper.h"
+#include "gpsr-packet.h"
 #include <complex>
 
 namespace ns3 {
@@ -22,7 +25,20 @@ namespace gpsr {
 struct NodeInfo {
     Vector pos;
     Vector vel;
-    double snr;
+    double snr;          ///< smoothed (EWMA) snr of the hellos, dB
+    bool snrMeasured;    ///< false until a hello with an snr is received
+    uint32_t hellos;     ///< bit i set if the hello i intervals ago was received
+    uint32_t intervals;  ///< hello intervals in hellos, up to the window
+    double txErrors;     ///< MAC tx failures, halved at each hello
+    bool usable;         ///< link good enough for greedy forwarding
+};
+
+/// Subgraph of the neighbour set used by the perimeter (recovery) mode
+enum PlanarGraph
+{
+  GPSR_PLANAR_NONE = 0,        //!< all neighbours, not planar
+  GPSR_PLANAR_GG = 1,          //!< Gabriel graph
+  GPSR_PLANAR_RNG = 2,         //!< Relative neighbourhood graph
 };
     
 /*
@@ -44,9 +60,16 @@ public:
 
   /**
    * \brief Adds entry in position table
+   * \param snr the snr of the hello, NoSnr () if the phy did not measure it
    */
   void AddEntry (Ipv4Address id, Vector position, Vector velocity, double snr);
 
+  /// The snr of a hello without a measurement, which leaves the smoothed snr as it is
+  static double NoSnr ()
+  {
+    return std::numeric_limits<double>::quiet_NaN ();
+  }
+
   /**
    * \brief Deletes entry in position table
    */
@@ -75,6 +98,16 @@ public:
    * \brief clears all entries
    */
   void Clear ();
+
+  /**
+   * \brief Gets the version of the neighbour set
+   * \return counter increased whenever a neighbour is added or removed, or its link
+   * starts or stops being usable (not when refreshed)
+   */
+  uint32_t GetVersion () const
+  {
+    return m_version;
+  }
   
   /**
    * \brief Prints positiontable
@@ -82,6 +115,70 @@ public:
    */
   void PrintPositionTable (Ptr<OutputStreamWrapper> stream) const;
 
+  /**
+   * \brief Writes the neighbours, one "neighbor ..." line each, for a warm start
+   *
+   * Entries are saved with their age, so they expire in the restored run as
+   * they would have in the saved one, and with their link estimator state.
+   */
+  void SaveState (std::ostream &os) const;
+
+  /**
+   * \brief Restores one neighbour written by SaveState
+   * \param is the rest of the line after "neighbor"
+   */
+  void RestoreState (std::istream &is);
+
+  /**
+   * \brief Gets the position and velocity of a neighbour, extrapolated to now
+   * \param id Ipv4Address of the neighbour
+   * \return false if id is not a neighbour
+   */
+  bool GetKinematics (Ipv4Address id, Vector &position, Vector &velocity);
+
+  /**
+   * \brief Records the MAC address a neighbour sends its hellos from
+   *
+   * The link layer reports frames by MAC address, LookupNeighbor maps them
+   * back. The mapping is forgotten with the neighbour.
+   */
+  void SetNeighborMac (Ipv4Address id, Mac48Address mac);
+  /**
+   * \brief Finds the neighbour with a MAC address
+   * \return its Ipv4Address, Ipv4Address::GetZero () if none
+   */
+  Ipv4Address LookupNeighbor (Mac48Address mac) const;
+
+  /**
+   * \brief Sets after how many MAC tx failures a neighbour is dropped
+   *
+   * Failures are halved at each hello of the neighbour; 0 never drops one.
+   * A dropped neighbour heard again keeps its failures and is not a greedy
+   * next hop until its link quality recovers (see SetLinkEstimator).
+   */
+  void SetMaxTxErrors (uint32_t maxTxErrors)
+  {
+    m_maxTxErrors = maxTxErrors;
+  }
+
+  /// Callback called with the address and MAC address of a neighbour dropped for tx failures
+  void SetLinkBreakCallback (Callback<void, Ipv4Address, Mac48Address> callback)
+  {
+    m_linkBreakCallback = callback;
+  }
+
+  /// Number of data frames the MAC failed to send
+  uint32_t GetTxErrors () const
+  {
+    return m_txErrors;
+  }
+
+  /// Number of neighbours dropped for tx failures
+  uint32_t GetLinkBreaks () const
+  {
+    return m_linkBreaks;
+  }
+
   /**
    * \Get Callback to ProcessTxError
    */
@@ -98,6 +195,43 @@ public:
    */
   Ipv4Address BestNeighbor (Vector dstPos, Vector dstVel, Vector nodePos, Vector nodeVel);
 
+  /**
+   * \brief Same as BestNeighbor (dstPos, dstVel, nodePos, nodeVel), cached per destination
+   * \param dst the address of the destination node
+   *
+   * See SetNextHopCache for when a cached next hop is used.
+   */
+  Ipv4Address BestNeighbor (Ipv4Address dst, Vector dstPos, Vector dstVel, Vector nodePos, Vector nodeVel);
+
+  /**
+   * \brief Sets up the cache of the greedy next hop per destination
+   *
+   * A cached next hop is used until timeout, unless a neighbour was
+   * added, removed or became (un)usable since, or this node or the
+   * destination moved further than distance. Neighbour movement and speed
+   * changes are only picked up at the timeout: at 30 m/s a neighbour moves
+   * 3 m in the 100 ms the protocol uses by default. A zero timeout
+   * disables the cache.
+   */
+  void SetNextHopCache (Time timeout, double distance)
+  {
+    m_nextHopCacheTimeout = timeout;
+    m_nextHopCacheDistance = distance;
+    m_nextHopCache.clear ();
+  }
+
+  /// Number of greedy next hops served from the cache
+  uint32_t GetNextHopCacheHits () const
+  {
+    return m_nextHopCacheHits;
+  }
+
+  /// Number of greedy next hops computed with the cache enabled
+  uint32_t GetNextHopCacheMisses () const
+  {
+    return m_nextHopCacheMisses;
+  }
+
   bool IsInSearch (Ipv4Address id);
 
   bool HasPosition (Ipv4Address id);
@@ -115,9 +249,86 @@ public:
    */
   Ipv4Address BestAngle (Vector previousHop, Vector nodePos);
 
+  /**
+   * \brief Same as BestAngle (previousHop, nodePos), also returning the position of the chosen neighbour
+   * \param nextHopPos set to the position of the returned neighbour
+   */
+  Ipv4Address BestAngle (Vector previousHop, Vector nodePos, Vector &nextHopPos);
+
+  /**
+   * \brief Gets the next hop of a packet in recovery mode (face routing)
+   *
+   * Walks the face of the planar graph by the right hand rule, changes
+   * face when the chosen edge crosses the line from the recovery point to
+   * the destination closer to it than where the current face was entered,
+   * and updates the face fields and previous hop of hdr accordingly.
+   * \param me the address of this node
+   * \param myPos the position of this node
+   * \param hdr the position header of the packet, in recovery mode
+   * \param loop set to true if the first edge of the face is taken again
+   * \return Ipv4Address of the next hop, Ipv4Address::GetZero () to drop the packet
+   */
+  Ipv4Address FaceNextHop (Ipv4Address me, Vector myPos, PositionHeader &hdr, bool &loop);
+
+  /**
+   * \brief Sets up the link-quality estimator of the neighbours
+   *
+   * The quality of a link is the ratio of the hellos received over the
+   * last HELLO_WINDOW hello intervals, divided by 1 + the MAC tx failures
+   * towards the neighbour (which halve at each hello). A link is no longer
+   * used for greedy forwarding once its quality falls below low, and again
+   * once it rises above high, so that one lost hello does not flip the
+   * next hop. The snr used by the greedy metric is the EWMA of the hello
+   * snr with weight snrAlpha for the latest.
+   */
+  void SetLinkEstimator (Time helloInterval, double snrAlpha, double low, double high)
+  {
+    m_helloInterval = helloInterval;
+    m_snrAlpha = snrAlpha;
+    m_qualityLow = low;
+    m_qualityHigh = high;
+  }
+
+  /**
+   * \brief Gets the link quality of a neighbour
+   * \return the quality in [0, 1], 0 if id is not a neighbour
+   */
+  double GetLinkQuality (Ipv4Address id) const;
+
+  /**
+   * \brief Gets the smoothed snr of the hellos of a neighbour
+   * \return the snr, 0 if id is not a neighbour or no hello was measured
+   */
+  double GetSnr (Ipv4Address id) const;
+
+  /**
+   * \brief Selects the subgraph BestAngle walks on
+   */
+  void SetPlanarGraph (PlanarGraph graph)
+  {
+    m_planarGraph = graph;
+    m_planarValid = false;
+  }
+
+  /**
+   * \brief Sets how far this node moves before the planar graph is rebuilt
+   *
+   * Until then BestAngle walks the graph built around the older position.
+   */
+  void SetPlanarRebuildDistance (double distance)
+  {
+    m_planarRebuildDistance = distance;
+  }
+
   //Gives angle between the vector CentrePos-Refpos to the vector CentrePos-node counterclockwise
   double GetAngle (Vector centrePos, Vector refPos, Vector node);
 
+  /**
+   * Intersection of the segments a1-a2 and b1-b2 (x, y only)
+   * \return true if they intersect, with the intersection point in cross
+   */
+  static bool SegmentIntersection (Vector a1, Vector a2, Vector b1, Vector b2, Vector &cross);
+
 
 
 private:
@@ -128,6 +339,81 @@ private:
   
   /* Keep the previous position per node*/
   std::map<Ipv4Address, std::pair<std::vector <Vector>, Time> > m_table_l;
+  /// Increased whenever a neighbour is added or removed, or becomes (un)usable
+  uint32_t m_version;
+
+  struct NextHopCacheEntry
+  {
+    Ipv4Address nextHop;
+    Time created;
+    Vector myPos;
+    Vector dstPos;
+  };
+  /// Greedy next hop per destination, valid for the table of m_nextHopCacheVersion
+  std::map<Ipv4Address, NextHopCacheEntry> m_nextHopCache;
+  uint32_t m_nextHopCacheVersion;
+  Time m_nextHopCacheTimeout;
+  double m_nextHopCacheDistance;
+  uint32_t m_nextHopCacheHits;
+  uint32_t m_nextHopCacheMisses;
+
+  struct PlanarNeighbor
+  {
+    double angle;              ///< direction from the centre, radians in [0, 2*pi)
+    Ipv4Address id;
+    Vector pos;
+    bool operator< (PlanarNeighbor const & o) const
+    {
+      return angle < o.angle;
+    }
+  };
+  /// Rebuilds m_planar around centre if it is not built yet or the centre moved more than m_planarRebuildDistance
+  void UpdatePlanarGraph (Vector centre);
+  /// True if w removes the edge from the centre to v in m_planarGraph
+  bool IsWitness (Vector v, Vector w) const;
+  /// Neighbour removing the edge to id at pos, Ipv4Address::GetZero () if it is kept
+  Ipv4Address FindWitness (Ipv4Address id, Vector pos) const;
+  /// Removes id from m_planar, if there
+  void ErasePlanar (Ipv4Address id);
+  /// Adds id at pos to m_planar, keeping it sorted
+  void InsertPlanar (Ipv4Address id, Vector pos);
+  /// Updates the planar graph for neighbour id added or moved to pos
+  void PlanarAdd (Ipv4Address id, Vector pos);
+  /// Updates the planar graph for neighbour id removed
+  void PlanarRemove (Ipv4Address id);
+  /// Checks again the removed edges whose witness was id
+  void PlanarRecheck (Ipv4Address id);
+  PlanarGraph m_planarGraph;
+  /// Planar neighbours of m_planarCentre sorted by angle
+  std::vector<PlanarNeighbor> m_planar;
+  /// Neighbours not in m_planar and the neighbour removing their edge
+  std::map<Ipv4Address, Ipv4Address> m_planarWitness;
+  Vector m_planarCentre;
+  bool m_planarValid;
+  double m_planarRebuildDistance;
+  /// No entry expires before this time, Purge skips the scan until then
+  Time m_nextExpiry;
+  /// Number of hello intervals the hello reception ratio is taken over
+  static const uint32_t HELLO_WINDOW = 8;
+  /// Quality of the link to a neighbour, see SetLinkEstimator
+  double GetLinkQuality (NodeInfo const &info) const;
+  /// Applies the hysteresis to a changed quality, bumps m_version if usable flips
+  void UpdateUsable (Ipv4Address id, NodeInfo &info);
+  Time m_helloInterval;
+  double m_snrAlpha;
+  double m_qualityLow;
+  double m_qualityHigh;
+  uint32_t m_maxTxErrors;
+  Callback<void, Ipv4Address, Mac48Address> m_linkBreakCallback;
+  uint32_t m_txErrors;
+  uint32_t m_linkBreaks;
+  /// Tx failures of the neighbours dropped for them and when, taken back if heard again
+  std::map<Ipv4Address, std::pair<double, Time> > m_broken;
+  /// MAC address of each neighbour and the other way round, for LookupNeighbor
+  std::map<Ipv4Address, Mac48Address> m_neighborMacs;
+  std::map<Mac48Address, Ipv4Address> m_macNeighbors;
+  /// Forgets the MAC address of a neighbour that left the table
+  void ForgetMac (Ipv4Address id);
   // TX error callback
   Callback<void, WifiMacHeader const &> m_txErrorCallback;
   // Process layer 2 TX error notification
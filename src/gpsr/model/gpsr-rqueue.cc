@@ -33,9 +33,10 @@ RequestQueue::Enqueue (QueueEntry & entry)
         }
     }
   entry.SetExpireTime (m_queueTimeout);
+  entry.SetEnqueueTime (Simulator::Now ());
   if (m_queue.size () == m_maxLen)
     {
-      Drop (m_queue.front (), "Drop the most aged packet");     // Drop the most aged packet
+      Drop (m_queue.front (), "Drop the most aged packet", GPSR_DROP_QUEUE_FULL);     // Drop the most aged packet
       m_queue.erase (m_queue.begin ());
     }
   m_queue.push_back (entry);
@@ -53,7 +54,7 @@ RequestQueue::DropPacketWithDst (Ipv4Address dst)
     {
       if (IsEqual (*i, addr))
         {
-          Drop (*i, "DropPacketWithDst ");
+          Drop (*i, "DropPacketWithDst ", GPSR_DROP_NO_POSITION);
         }
     }
   m_queue.erase (std::remove_if (m_queue.begin (), m_queue.end (),
@@ -108,7 +109,7 @@ RequestQueue::Purge ()
     {
       if (pred (*i))
         {
-          Drop (*i, "Drop outdated packet ");
+          Drop (*i, "Drop outdated packet ", GPSR_DROP_QUEUE_TIMEOUT);
         }
     }
   m_queue.erase (std::remove_if (m_queue.begin (), m_queue.end (), pred),
@@ -116,9 +117,13 @@ RequestQueue::Purge ()
 }
 
 void
-RequestQueue::Drop (QueueEntry en, std::string reason)
+RequestQueue::Drop (QueueEntry en, std::string reason, DropReason code)
 {
   NS_LOG_LOGIC (reason << en.GetPacket ()->GetUid () << " " << en.GetIpv4Header ().GetDestination ());
+  if (!m_dropCallback.IsNull ())
+    {
+      m_dropCallback (en.GetPacket (), code);
+    }
   en.GetErrorCallback () (en.GetPacket (), en.GetIpv4Header (),
                           Socket::ERROR_NOROUTETOHOST);
   return;
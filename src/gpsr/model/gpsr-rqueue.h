@@ -11,6 +11,17 @@
 namespace ns3 {
 namespace gpsr {
 
+/// Why GPSR dropped a data packet, as reported by the "Drop" trace source
+enum DropReason
+{
+  GPSR_DROP_BAD_HEADER = 1,      ///< Missing or unknown GPSR header
+  GPSR_DROP_NO_POSITION = 2,     ///< The location service did not find the destination
+  GPSR_DROP_QUEUE_TIMEOUT = 3,   ///< Waited too long in the request queue
+  GPSR_DROP_QUEUE_FULL = 4,      ///< Pushed out of a full request queue
+  GPSR_DROP_NO_NEIGHBOR = 5,     ///< No neighbour to forward to in perimeter mode
+  GPSR_DROP_PERIMETER_LOOP = 6,  ///< Walked the whole face without getting closer
+};
+
 /**
  * \ingroup gpsr
  * \brief GPSR Queue Entry
@@ -28,7 +39,8 @@ public:
       m_header (h),
       m_ucb (ucb),
       m_ecb (ecb),
-      m_expire (exp + Simulator::Now ())
+      m_expire (exp + Simulator::Now ()),
+      m_enqueued (Simulator::Now ())
   {
   }
 
@@ -82,6 +94,14 @@ public:
   {
     return m_expire - Simulator::Now ();
   }
+  void SetEnqueueTime (Time t)
+  {
+    m_enqueued = t;
+  }
+  Time GetEnqueueTime () const
+  {
+    return m_enqueued;
+  }
   //\}
 private:
   /// Data packet
@@ -94,6 +114,8 @@ private:
   ErrorCallback m_ecb;
   /// Expire time for queue entry
   Time m_expire;
+  /// Time the entry was put in the queue
+  Time m_enqueued;
 };
 /**
  * \ingroup gpsr
@@ -104,6 +126,9 @@ private:
 class RequestQueue
 {
 public:
+  /// Called with each packet dropped from the queue and the DropReason
+  typedef Callback<void, Ptr<const Packet>, uint8_t> DropCallback;
+
   /// Default c-tor
   RequestQueue (uint32_t maxLen, Time routeToQueueTimeout)
     : m_maxLen (maxLen),
@@ -138,6 +163,10 @@ public:
   {
     m_queueTimeout = t;
   }
+  void SetDropCallback (DropCallback cb)
+  {
+    m_dropCallback = cb;
+  }
   //\}
 
 private:
@@ -145,11 +174,12 @@ private:
   /// Remove all expired entries
   void Purge ();
   /// Notify that packet is dropped from queue by timeout
-  void Drop (QueueEntry en, std::string reason);
+  void Drop (QueueEntry en, std::string reason, DropReason code);
   /// The maximum number of packets that we allow a routing protocol to buffer.
   uint32_t m_maxLen;
   /// The maximum period of time that a routing protocol is allowed to buffer a packet for, seconds.
   Time m_queueTimeout;
+  DropCallback m_dropCallback;
   static bool IsEqual (QueueEntry en, const Ipv4Address dst)
   {
     return (en.GetIpv4Header ().GetDestination () == dst);
@@ -9,21 +9,32 @@
 #include "gpsr.h"
 #include "ns3/log.h"
 #include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
 #include "ns3/random-variable.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/udp-socket-factory.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/udp-header.h"
 #include "ns3/wifi-net-device.h"
 #include "ns3/adhoc-wifi-mac.h"
+#include "ns3/regular-wifi-mac.h"
+#include "ns3/dca-txop.h"
+#include "ns3/edca-txop-n.h"
+#include "ns3/wifi-mac-queue.h"
+#include "ns3/llc-snap-header.h"
+#include "ns3/pointer.h"
+#include "ns3/yans-wifi-phy.h"
+#include "ns3/vehicular-wifi-manager.h"
 #include "src/network/model/packet.h"
 #include <algorithm>
+#include <cmath>
 #include <limits>
+#include <sstream>
 
 
-#define GPSR_LS_GOD 0
-
-#define GPSR_LS_RLS 1
-
 NS_LOG_COMPONENT_DEFINE ("GpsrRoutingProtocol");
 
 namespace ns3 {
@@ -96,10 +107,20 @@ RoutingProtocol::RoutingProtocol ()
     MaxQueueTime (Seconds (30)),
     m_queue (MaxQueueLen, MaxQueueTime),
     HelloIntervalTimer (Timer::CANCEL_ON_DESTROY),
-    PerimeterMode (false)
+    PerimeterMode (false),
+    PlanarGraphName (GPSR_PLANAR_GG),
+    PlanarRebuildDistance (1),
+    NextHopCacheTimeout (MilliSeconds (100)),
+    NextHopCacheDistance (10),
+    LinkSnrAlpha (0.25),
+    LinkQualityLow (0.5),
+    LinkQualityHigh (0.75),
+    MaxTxErrors (1),
+    m_reroutedPackets (0)
 {
 
   m_neighbors = PositionTable ();
+  m_queue.SetDropCallback (MakeCallback (&RoutingProtocol::NotifyDrop, this));
 }
 
 TypeId
@@ -121,6 +142,52 @@ RoutingProtocol::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&RoutingProtocol::PerimeterMode),
                    MakeBooleanChecker ())
+    .AddAttribute ("PlanarGraph", "Neighbour subgraph used in perimeter mode",
+                   EnumValue (GPSR_PLANAR_GG),
+                   MakeEnumAccessor (&RoutingProtocol::PlanarGraphName),
+                   MakeEnumChecker (GPSR_PLANAR_GG, "GG",
+                                    GPSR_PLANAR_RNG, "RNG",
+                                    GPSR_PLANAR_NONE, "NONE"))
+    .AddAttribute ("PlanarRebuildDistance", "Distance this node moves before its perimeter mode planar graph is rebuilt, m.",
+                   DoubleValue (1),
+                   MakeDoubleAccessor (&RoutingProtocol::PlanarRebuildDistance),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("NextHopCacheTimeout", "Lifetime of a cached greedy next hop, zero disables the cache.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&RoutingProtocol::NextHopCacheTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("NextHopCacheDistance", "A cached greedy next hop is recomputed once this node or the destination moved further, m.",
+                   DoubleValue (10),
+                   MakeDoubleAccessor (&RoutingProtocol::NextHopCacheDistance),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("LinkSnrAlpha", "Weight of the latest hello in the smoothed snr of a neighbour.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&RoutingProtocol::LinkSnrAlpha),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("LinkQualityLow", "A neighbour is no longer a greedy next hop once its link quality "
+                   "(hello reception ratio, lowered by MAC tx failures) falls below this.",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&RoutingProtocol::LinkQualityLow),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("LinkQualityHigh", "A neighbour that was no longer a greedy next hop is one again once its link quality rises above this.",
+                   DoubleValue (0.75),
+                   MakeDoubleAccessor (&RoutingProtocol::LinkQualityHigh),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("MaxTxErrors", "MAC tx failures (halved at each hello) after which a neighbour is dropped "
+                   "and the packets queued for it are routed again, zero never drops one.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&RoutingProtocol::MaxTxErrors),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("Tx", "A data packet is sent by this node.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_txTrace))
+    .AddTraceSource ("Forward", "A data packet is given to a next hop, in greedy (0) or perimeter (1) mode.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_forwardTrace))
+    .AddTraceSource ("Dequeue", "A data packet leaves the request queue.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_dequeueTrace))
+    .AddTraceSource ("Deliver", "A data packet is delivered to this node.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_deliverTrace))
+    .AddTraceSource ("Drop", "A data packet is dropped.",
+                     MakeTraceSourceAccessor (&RoutingProtocol::m_dropTrace))
   ;
   return tid;
 }
@@ -133,6 +200,7 @@ void
 RoutingProtocol::DoDispose ()
 {
   m_ipv4 = 0;
+  m_locationService = 0;
   Ipv4RoutingProtocol::DoDispose ();
 }
 
@@ -187,6 +255,7 @@ bool RoutingProtocol::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
       if (!tHeader.IsValid ())
         {
           NS_LOG_DEBUG ("GPSR message " << packet->GetUid () << " with unknown type received: " << tHeader.Get () << ". Ignored");
+          NotifyDrop (packet, GPSR_DROP_BAD_HEADER);
           return false;
         }
       
@@ -199,6 +268,10 @@ bool RoutingProtocol::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
       if (dst != m_ipv4->GetAddress (1, 0).GetBroadcast ())
         {
           NS_LOG_LOGIC ("Unicast local delivery to " << dst);
+          if (IsDataPacket (packet))
+            {
+              m_deliverTrace (packet);
+            }
         }
       else
         {
@@ -308,7 +381,7 @@ RoutingProtocol::SendPacketFromQueue (Ipv4Address dst)
     Vector dstPos = m_locationService->GetPosition (dst);
     Vector dstVel = m_locationService->GetVelocity (dst);
 //    std::cout << "Destination: " << dstPos << "\n";
-    nextHop = m_neighbors.BestNeighbor (dstPos, dstVel, myPos, myVel);
+    nextHop = m_neighbors.BestNeighbor (dst, dstPos, dstVel, myPos, myVel);
 //    std::cout << "---\n SendPacketFromQueue Node: [" << m_ipv4->GetObject<Node> ()->GetId () << "] -> NextHop: " << nextHop 
 //              << "---\n ";
     if (nextHop == Ipv4Address::GetZero ())
@@ -329,12 +402,14 @@ RoutingProtocol::SendPacketFromQueue (Ipv4Address dst)
             Ptr<Packet> p = ConstCast<Packet> (queueEntry.GetPacket ());
             UnicastForwardCallback ucb = queueEntry.GetUnicastForwardCallback ();
             Ipv4Header header = queueEntry.GetIpv4Header ();
+            m_dequeueTrace (p, Simulator::Now () - queueEntry.GetEnqueueTime ());
             
             TypeHeader tHeader (GPSRTYPE_POS);
             p->RemoveHeader (tHeader);
             if (!tHeader.IsValid ())
               {
                 NS_LOG_DEBUG ("GPSR message " << p->GetUid () << " with unknown type received: " << tHeader.Get () << ". Drop");
+                NotifyDrop (p, GPSR_DROP_BAD_HEADER);
                 return false;     // drop
               }
             if (tHeader.Get () == GPSRTYPE_POS)
@@ -379,6 +454,8 @@ RoutingProtocol::SendPacketFromQueue (Ipv4Address dst)
         {
           route->SetSource (header.GetSource ());
         }
+      m_dequeueTrace (p, Simulator::Now () - queueEntry.GetEnqueueTime ());
+      m_forwardTrace (p, nextHop, myPos, 0);
       ucb (route, p, header);
     }
   return true;
@@ -389,13 +466,9 @@ void
 RoutingProtocol::RecoveryMode(Ipv4Address dst, Ptr<Packet> p, UnicastForwardCallback ucb, Ipv4Header header){
 
 //    std:: cout << "Recovery Mode \n";
-  Vector Position;
-  Vector previousHop;
-  uint32_t updated;
   uint64_t positionX;
   uint64_t positionY;
   Vector myPos;
-  Vector recPos;
 
   Ptr<MobilityModel> MM = m_ipv4->GetObject<MobilityModel> ();
   positionX = MM->GetPosition ().x;
@@ -408,33 +481,33 @@ RoutingProtocol::RecoveryMode(Ipv4Address dst, Ptr<Packet> p, UnicastForwardCall
   if (!tHeader.IsValid ())
     {
       NS_LOG_DEBUG ("GPSR message " << p->GetUid () << " with unknown type received: " << tHeader.Get () << ". Drop");
+      NotifyDrop (p, GPSR_DROP_BAD_HEADER);
       return;     // drop
     }
+  PositionHeader hdr;
   if (tHeader.Get () == GPSRTYPE_POS)
     {
-      PositionHeader hdr;
       p->RemoveHeader (hdr);
-      Position.x = hdr.GetDstPosx ();
-      Position.y = hdr.GetDstPosy ();
-      updated = hdr.GetUpdated (); 
-      recPos.x = hdr.GetRecPosx ();
-      recPos.y = hdr.GetRecPosy ();
-      previousHop.x = hdr.GetLastPosx ();
-      previousHop.y = hdr.GetLastPosy ();
    }
 
-  PositionHeader posHeader (Position.x, Position.y,  updated, recPos.x, recPos.y, (uint8_t) 1, myPos.x, myPos.y); 
-  p->AddHeader (posHeader);
-  p->AddHeader (tHeader);
-
-
-
-  Ipv4Address nextHop = m_neighbors.BestAngle (previousHop, myPos); 
+  bool loop;
+  Ipv4Address me = m_ipv4->GetAddress (1, 0).GetLocal ();
+  Ipv4Address nextHop = m_neighbors.FaceNextHop (me, myPos, hdr, loop);
+  if (loop)
+    {
+      NS_LOG_LOGIC ("Perimeter loop, no route to " << dst << ". Drop packet " << p->GetUid ());
+      NotifyDrop (p, GPSR_DROP_PERIMETER_LOOP);
+      return;
+    }
   if (nextHop == Ipv4Address::GetZero ())
     {
+      NotifyDrop (p, GPSR_DROP_NO_NEIGHBOR);
       return;
     }
 
+  p->AddHeader (hdr);
+  p->AddHeader (tHeader);
+
   Ptr<Ipv4Route> route = Create<Ipv4Route> ();
   route->SetDestination (dst);
   route->SetGateway (nextHop);
@@ -443,6 +516,7 @@ RoutingProtocol::RecoveryMode(Ipv4Address dst, Ptr<Packet> p, UnicastForwardCall
   route->SetOutputDevice (m_ipv4->GetNetDevice (1));
   route->SetSource (header.GetSource ());
 
+  m_forwardTrace (p, nextHop, myPos, 1);
   ucb (route, p, header);
   return;
 }
@@ -482,6 +556,15 @@ RoutingProtocol::NotifyInterfaceUp (uint32_t interface)
     {
       return;
     }
+  // The hellos come through a socket, the MAC they were sent from only with the frame
+  GetObject<Node> ()->RegisterProtocolHandler (MakeCallback (&RoutingProtocol::RecvHelloFrame, this),
+                                               Ipv4L3Protocol::PROT_NUMBER, dev);
+  // Rate control from the motion of the neighbours
+  Ptr<VehicularWifiManager> manager = DynamicCast<VehicularWifiManager> (wifi->GetRemoteStationManager ());
+  if (manager != 0)
+    {
+      manager->SetKinematicsCallback (MakeCallback (&RoutingProtocol::GetNeighborKinematics, this));
+    }
   Ptr<WifiMac> mac = wifi->GetMac ();
   if (mac == 0)
     {
@@ -524,21 +607,146 @@ RoutingProtocol::RecvGPSR (Ptr<Socket> socket)
   Ipv4Address sender = inetSourceAddr.GetIpv4 ();
   Ipv4Address receiver = m_socketAddresses[socket].GetLocal ();
 
-  double hello_snr = 0.0;
-  SnrTag tag;
-  if (packet->PeekPacketTag(tag))
-  {
-      std::cout << "\nNode: " << receiver
-              << "\nReceived Packet with SRN = " << tag.Get() 
-              << "\nfrom " << sender;
-//      NS_LOG_DEBUG ("Received Packet with SRN = " << tag.Get());
-      hello_snr = tag.Get();
-  }
-  
+  // The snr of the hello, if the phy of the interface keeps it
+  double hello_snr = PositionTable::NoSnr ();
+  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (m_ipv4->GetInterfaceForAddress (receiver));
+  Ptr<WifiNetDevice> wifi = dev->GetObject<WifiNetDevice> ();
+  if (wifi != 0)
+    {
+      Ptr<YansWifiPhy> phy = DynamicCast<YansWifiPhy> (wifi->GetPhy ());
+      double snr;
+      if (phy != 0 && phy->GetRxSnr (packet->GetUid (), snr))
+        {
+          NS_LOG_DEBUG ("Node " << receiver << " received hello from " << sender
+                                << " with snr " << snr);
+          hello_snr = snr;
+        }
+    }
+
   UpdateRouteToNeighbor (sender, receiver, Position, Velocity, hello_snr);
 }
 
 
+void
+RoutingProtocol::RecvHelloFrame (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                                 const Address &from, const Address &to, NetDevice::PacketType packetType)
+{
+  if (packetType != NetDevice::PACKET_BROADCAST || !Mac48Address::IsMatchingType (from))
+    {
+      return;
+    }
+  Ptr<Packet> copy = packet->Copy ();
+  Ipv4Header ipHeader;
+  copy->RemoveHeader (ipHeader);
+  if (ipHeader.GetProtocol () != UdpL4Protocol::PROT_NUMBER)
+    {
+      return;
+    }
+  UdpHeader udpHeader;
+  copy->PeekHeader (udpHeader);
+  if (udpHeader.GetDestinationPort () == GPSR_PORT)
+    {
+      // Hellos are sent with a ttl of 1, the source is the sender of the frame
+      m_neighbors.SetNeighborMac (ipHeader.GetSource (), Mac48Address::ConvertFrom (from));
+    }
+}
+
+bool
+RoutingProtocol::GetNeighborKinematics (Mac48Address mac, Vector &position, Vector &velocity)
+{
+  Ipv4Address neighbor = m_neighbors.LookupNeighbor (mac);
+  if (neighbor == Ipv4Address::GetZero ())
+    {
+      return false;
+    }
+  return m_neighbors.GetKinematics (neighbor, position, velocity);
+}
+
+void
+RoutingProtocol::NotifyLinkBreak (Ipv4Address neighbor, Mac48Address mac)
+{
+  NS_LOG_FUNCTION (this << neighbor << mac);
+  // The MAC reports the failure in the middle of its own processing: take
+  // its frames back once it is done, before it starts on the next one
+  Simulator::ScheduleNow (&RoutingProtocol::RerouteQueued, this, mac);
+}
+
+void
+RoutingProtocol::RerouteQueued (Mac48Address mac)
+{
+  Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol> ();
+  for (uint32_t i = 0; i < l3->GetNInterfaces (); i++)
+    {
+      Ptr<WifiNetDevice> wifi = l3->GetNetDevice (i)->GetObject<WifiNetDevice> ();
+      if (wifi == 0)
+        {
+          continue;
+        }
+      Ptr<RegularWifiMac> wifiMac = DynamicCast<RegularWifiMac> (wifi->GetMac ());
+      if (wifiMac == 0)
+        {
+          continue;
+        }
+      // The DCF queue, and the EDCA ones if QoS is supported
+      std::vector<Ptr<WifiMacQueue> > queues;
+      PointerValue ptr;
+      wifiMac->GetAttribute ("DcaTxop", ptr);
+      queues.push_back (ptr.Get<DcaTxop> ()->GetQueue ());
+      const char *acs[] = { "VO_EdcaTxopN", "VI_EdcaTxopN", "BE_EdcaTxopN", "BK_EdcaTxopN" };
+      for (uint32_t ac = 0; ac < 4; ac++)
+        {
+          wifiMac->GetAttribute (acs[ac], ptr);
+          if (ptr.Get<EdcaTxopN> () != 0)
+            {
+              queues.push_back (ptr.Get<EdcaTxopN> ()->GetQueue ());
+            }
+        }
+
+      for (std::vector<Ptr<WifiMacQueue> >::const_iterator q = queues.begin (); q != queues.end (); ++q)
+        {
+          WifiMacHeader hdr;
+          Ptr<const Packet> frame;
+          while ((frame = (*q)->DequeueByAddress (&hdr, WifiMacHeader::ADDR1, mac)) != 0)
+            {
+              Ptr<Packet> packet = frame->Copy ();
+              LlcSnapHeader llc;
+              packet->RemoveHeader (llc);
+              if (!hdr.IsData () || llc.GetType () != Ipv4L3Protocol::PROT_NUMBER)
+                {
+                  NS_LOG_DEBUG ("Drop frame " << packet->GetUid () << " queued for " << mac);
+                  wifiMac->NotifyTxDrop (frame);
+                  continue;
+                }
+              // The packet already went through the IP layer once: only a
+              // new next hop is chosen, as in RouteInput, and it goes
+              // straight back to the interface
+              Ipv4Header ipHeader;
+              packet->RemoveHeader (ipHeader);
+              NS_LOG_DEBUG ("Reroute packet " << packet->GetUid () << " queued for " << mac);
+              m_reroutedPackets++;
+              Forwarding (packet, ipHeader, MakeCallback (&RoutingProtocol::SendRerouted, this),
+                          MakeNullCallback<void, Ptr<const Packet>, const Ipv4Header &, Socket::SocketErrno> ());
+            }
+        }
+    }
+}
+
+void
+RoutingProtocol::SendRerouted (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header)
+{
+  Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol> ();
+  int32_t interface = l3->GetInterfaceForDevice (route->GetOutputDevice ());
+  NS_ASSERT (interface >= 0);
+  Ipv4Header ipHeader = header;
+  if (Node::ChecksumEnabled ())
+    {
+      ipHeader.EnableChecksum ();
+    }
+  Ptr<Packet> packet = p->Copy ();
+  packet->AddHeader (ipHeader);
+  l3->GetInterface (interface)->Send (packet, route->GetGateway ());
+}
+
 void
 RoutingProtocol::UpdateRouteToNeighbor (Ipv4Address sender, Ipv4Address receiver, Vector Pos, Vector Vel, double snr)
 {
@@ -558,6 +766,12 @@ RoutingProtocol::NotifyInterfaceDown (uint32_t interface)
   Ptr<WifiNetDevice> wifi = dev->GetObject<WifiNetDevice> ();
   if (wifi != 0)
     {
+      GetObject<Node> ()->UnregisterProtocolHandler (MakeCallback (&RoutingProtocol::RecvHelloFrame, this));
+      Ptr<VehicularWifiManager> manager = DynamicCast<VehicularWifiManager> (wifi->GetRemoteStationManager ());
+      if (manager != 0)
+        {
+          manager->SetKinematicsCallback (MakeNullCallback<bool, Mac48Address, Vector &, Vector &> ());
+        }
       Ptr<WifiMac> mac = wifi->GetMac ()->GetObject<AdhocWifiMac> ();
       if (mac != 0)
         {
@@ -778,10 +992,24 @@ RoutingProtocol::Start ()
 {
   NS_LOG_FUNCTION (this);
   m_queuedAddresses.clear ();
+  m_neighbors.SetPlanarGraph ((PlanarGraph) PlanarGraphName);
+  m_neighbors.SetPlanarRebuildDistance (PlanarRebuildDistance);
+  m_neighbors.SetLinkEstimator (HelloInterval, LinkSnrAlpha, LinkQualityLow, LinkQualityHigh);
+  m_neighbors.SetMaxTxErrors (MaxTxErrors);
+  m_neighbors.SetNextHopCache (NextHopCacheTimeout, NextHopCacheDistance);
+  m_neighbors.SetLinkBreakCallback (MakeCallback (&RoutingProtocol::NotifyLinkBreak, this));
 
   //FIXME ajustar timer, meter valor parametrizavel
   Time tableTime ("2s");
 
+  if (m_locationService != 0)
+    {
+      NS_LOG_DEBUG ("Using location service installed by the helper");
+      // a no-op for the shared GOD service, binds a cached RLS backend to this node
+      m_locationService->SetIpv4 (m_ipv4);
+      return;
+    }
+
   switch (LocationServiceName)
     {
     case GPSR_LS_GOD:
@@ -789,7 +1017,9 @@ RoutingProtocol::Start ()
       m_locationService = CreateObject<GodLocationService> ();
       break;
     case GPSR_LS_RLS:
-      NS_LOG_UNCOND ("RLS not yet implemented");
+      NS_LOG_DEBUG ("RLS in use");
+      m_locationService = CreateObject<ReactiveLocationService> ();
+      m_locationService->SetIpv4 (m_ipv4);
       break;
     }
 
@@ -861,7 +1091,7 @@ RoutingProtocol::AddHeaders (Ptr<Packet> p, Ipv4Address source, Ipv4Address dest
     {
       Vector dstPos = m_locationService->GetPosition (destination);
       Vector dstVel = m_locationService->GetVelocity (destination);
-      nextHop = m_neighbors.BestNeighbor (dstPos, dstVel, myPos, myVel);
+      nextHop = m_neighbors.BestNeighbor (destination, dstPos, dstVel, myPos, myVel);
 //      std::cout << "---\n NextHop: " << nextHop << "---\n ";
     }
 
@@ -871,9 +1101,10 @@ RoutingProtocol::AddHeaders (Ptr<Packet> p, Ipv4Address source, Ipv4Address dest
 
   if(destination != m_ipv4->GetAddress (1, 0).GetBroadcast ())
     {
-      positionX = m_locationService->GetPosition (destination).x;
-      positionY = m_locationService->GetPosition (destination).y;
-      hdrTime = (uint32_t) m_locationService->GetEntryUpdateTime (destination).GetSeconds ();
+      Vector dstPos = m_locationService->GetPosition (destination);
+      positionX = dstPos.x;
+      positionY = dstPos.y;
+      hdrTime = (uint32_t) m_locationService->GetEntryUpdateTime (destination).GetMilliSeconds ();
     }
 
   PositionHeader posHeader (positionX, positionY,  hdrTime, (uint64_t) 0,(uint64_t) 0, (uint8_t) 0, myPos.x, myPos.y); 
@@ -910,7 +1141,7 @@ RoutingProtocol::Forwarding (Ptr<const Packet> packet, const Ipv4Header & header
   if (!tHeader.IsValid ())
     {
       NS_LOG_DEBUG ("GPSR message " << p->GetUid () << " with unknown type received: " << tHeader.Get () << ". Drop");
-      std::cout << "Drop\n";
+      NotifyDrop (p, GPSR_DROP_BAD_HEADER);
       return false;     // drop
     }
   if (tHeader.Get () == GPSRTYPE_POS)
@@ -952,11 +1183,12 @@ RoutingProtocol::Forwarding (Ptr<const Packet> packet, const Ipv4Header & header
 
 
 
-  uint32_t myUpdated = (uint32_t) m_locationService->GetEntryUpdateTime (dst).GetSeconds ();
+  uint32_t myUpdated = (uint32_t) m_locationService->GetEntryUpdateTime (dst).GetMilliSeconds ();
   if (myUpdated > updated) //check if node has an update to the position of destination
     {      
-      Position.x = m_locationService->GetPosition (dst).x;
-      Position.y = m_locationService->GetPosition (dst).y;
+      Vector dstPos = m_locationService->GetPosition (dst);
+      Position.x = dstPos.x;
+      Position.y = dstPos.y;
       dstVel = m_locationService->GetVelocity (dst);
       //      DstVelocity.x = m_locationService->GetVelocity (dst).x;
       //      DstVelocity.y = m_locationService->GetVelocity (dst).y;
@@ -979,7 +1211,7 @@ RoutingProtocol::Forwarding (Ptr<const Packet> packet, const Ipv4Header & header
 //                  << "Forwarding| dstPos " << Position << " MyPos: " << myPos << "\n";  
 //      }
 //      if (dstVel.x == 0.0) std::cout << "We have an issue here!!\n";
-      nextHop = m_neighbors.BestNeighbor (Position, dstVel, myPos, myVel);
+      nextHop = m_neighbors.BestNeighbor (dst, Position, dstVel, myPos, myVel);
 //      if (p->GetSize() > 1000) std::cout << "Forwarding| Next hop is " << nextHop << "\n";
 //      std::cout << "---\n F Node: [" << m_ipv4->GetObject<Node> ()->GetId () << "] -> NextHop: " << nextHop 
 //              << " Packet size: " << p->GetSize() << "---\n ";
@@ -1009,6 +1241,7 @@ RoutingProtocol::Forwarding (Ptr<const Packet> packet, const Ipv4Header & header
         NS_LOG_LOGIC (route->GetOutputDevice () << " forwarding to " << dst << " from " << origin << " through " << route->GetGateway () << " packet " << p->GetUid ());
 //        std::cout << "\n*Node"<< route->GetOutputDevice ()->GetNode()->GetId() << " forwarding to " << dst << " from " << origin << " through " << route->GetGateway () << " packet " << p->GetUid ();
 
+        m_forwardTrace (p, nextHop, myPos, 0);
         ucb (route, p, header);
         return true;
       }
@@ -1018,6 +1251,10 @@ RoutingProtocol::Forwarding (Ptr<const Packet> packet, const Ipv4Header & header
   hdr.SetRecPosy (myPos.y); 
   hdr.SetLastPosx (Position.x); //when entering Recovery, the first edge is the Dst
   hdr.SetLastPosy (Position.y); 
+  hdr.SetFacePosx (myPos.x);
+  hdr.SetFacePosy (myPos.y);
+  hdr.SetFirstEdgeFrom (Ipv4Address::GetZero ());
+  hdr.SetFirstEdgeTo (Ipv4Address::GetZero ());
 
 
   p->AddHeader (hdr);
@@ -1030,6 +1267,20 @@ RoutingProtocol::Forwarding (Ptr<const Packet> packet, const Ipv4Header & header
 
 
 
+bool
+RoutingProtocol::IsDataPacket (Ptr<const Packet> p) const
+{
+  LocationServiceTag tag;
+  return !p->PeekPacketTag (tag);
+}
+
+void
+RoutingProtocol::NotifyDrop (Ptr<const Packet> p, uint8_t reason)
+{
+  NS_LOG_FUNCTION (this << p->GetUid () << (uint16_t) reason);
+  m_dropTrace (p, reason);
+}
+
 void
 RoutingProtocol::SetDownTarget (IpL4Protocol::DownTargetCallback callback)
 {
@@ -1075,6 +1326,10 @@ RoutingProtocol::RouteOutput (Ptr<Packet> p, const Ipv4Header &header,
   
   if (!(dst == m_ipv4->GetAddress (1, 0).GetBroadcast ()))
     {
+      if (IsDataPacket (p))
+        {
+          m_txTrace (p, dst);
+        }
       dstPos = m_locationService->GetPosition (dst);
       dstVel = m_locationService->GetVelocity (dst);
     }
@@ -1089,6 +1344,11 @@ RoutingProtocol::RouteOutput (Ptr<Packet> p, const Ipv4Header &header,
 //  if (CalculateDistance (dstPos, m_locationService->GetInvalidPosition ()) == 0 && m_locationService->IsInSearch (dst))
   if (CalculateDistance (dstPos, m_locationService->GetInvalidPosition ()) == 0)
     {
+      if (!(dst == m_ipv4->GetAddress (1, 0).GetBroadcast ()))
+        {
+          // The packet waits in the deferred queue until the search ends
+          m_locationService->StartSearch (dst);
+        }
       DeferredRouteOutputTag tag;
       if (!p->PeekPacketTag (tag))
         {
@@ -1119,7 +1379,7 @@ RoutingProtocol::RouteOutput (Ptr<Packet> p, const Ipv4Header &header,
 //                  << "Route Output| dstPos " << dstPos << " MyPos: " << myPos << "\n";  
 //      }
 //      std::cout << "DstPos" << dstPos << "\n";
-      nextHop = m_neighbors.BestNeighbor (dstPos, dstVel, myPos, myVel);      
+      nextHop = m_neighbors.BestNeighbor (dst, dstPos, dstVel, myPos, myVel);
 //      if (p->GetSize() > 1000) std::cout << "Route Output| Next hop is " << nextHop << "\n";
 //      std::cout << "---\n RouteOutput Node: [" << m_ipv4->GetObject<Node> ()->GetId () << "] -> NextHop: " << nextHop 
 //              << " Packet size: " << p->GetSize() << "---\n ";
@@ -1152,6 +1412,7 @@ RoutingProtocol::RouteOutput (Ptr<Packet> p, const Ipv4Header &header,
           sockerr = Socket::ERROR_NOROUTETOHOST;
           return Ptr<Ipv4Route> ();
         }
+      m_forwardTrace (p, nextHop, myPos, 0);
       return route;
     }
   else
@@ -1176,9 +1437,69 @@ RoutingProtocol::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
   std::ostream* os = stream->GetStream ();
   *os << "Node: " << m_ipv4->GetObject<Node> ()->GetId ()
           << " Pos: " << m_ipv4->GetObject<MobilityModel> ()->GetPosition()
-          << " Vel: " << m_ipv4->GetObject<MobilityModel> ()->GetVelocity() << "\n";
+          << " Vel: " << m_ipv4->GetObject<MobilityModel> ()->GetVelocity()
+          << " NextHopCache hits/misses: " << GetNextHopCacheHits () << "/" << GetNextHopCacheMisses ()
+          << " Tx errors/link breaks/rerouted: " << GetTxErrors () << "/" << GetLinkBreaks ()
+          << "/" << m_reroutedPackets << "\n";
   m_neighbors.PrintPositionTable(stream);  
 }
 
+void
+RoutingProtocol::SaveState (std::ostream &os) const
+{
+  // Keep the hello phase, so that nodes do not all send hellos together
+  if (HelloIntervalTimer.IsRunning ())
+    {
+      os << "hello " << HelloIntervalTimer.GetDelayLeft ().GetNanoSeconds () << std::endl;
+    }
+  m_neighbors.SaveState (os);
+  if (m_locationService)
+    {
+      m_locationService->SaveState (os);
+    }
+  os << "end" << std::endl;
+}
+
+void
+RoutingProtocol::RestoreState (std::istream &is)
+{
+  NS_ASSERT_MSG (m_locationService, "RestoreState called before Start");
+  std::string line;
+  while (std::getline (is, line))
+    {
+      std::istringstream record (line);
+      std::string keyword;
+      if (!(record >> keyword))
+        {
+          continue;
+        }
+      if (keyword == "end")
+        {
+          return;
+        }
+      else if (keyword == "hello")
+        {
+          int64_t delay;
+          if (record >> delay)
+            {
+              HelloIntervalTimer.Cancel ();
+              HelloIntervalTimer.Schedule (NanoSeconds (delay));
+            }
+        }
+      else if (keyword == "neighbor")
+        {
+          m_neighbors.RestoreState (record);
+        }
+      else if (keyword == "ls")
+        {
+          m_locationService->RestoreState (record);
+        }
+      else
+        {
+          NS_LOG_WARN ("Unknown record in saved state: " << keyword);
+        }
+    }
+}
+
 }
 }
\ No newline at end of file
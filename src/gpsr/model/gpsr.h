@@ -18,13 +18,18 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-route.h"
+#include "ns3/traced-callback.h"
 #include "ns3/location-service.h"
 #include "ns3/god.h"
-#include "src/wifi/model/snr-tag.h"
+#include "ns3/rls.h"
 
 #include <map>
 #include <complex>
 
+#define GPSR_LS_GOD 0
+
+#define GPSR_LS_RLS 1
+
 namespace ns3 {
 namespace gpsr {
 /**
@@ -70,6 +75,7 @@ public:
   Ptr<NetDevice> m_lo;
 
   Ptr<LocationService> GetLS ();
+  /// Use locationService instead of creating one in Start (e.g. a service shared by all nodes)
   void SetLS (Ptr<LocationService> locationService);
 
   /// Broadcast ID
@@ -87,6 +93,42 @@ public:
   IpL4Protocol::DownTargetCallback GetDownTarget (void) const;
 
   virtual void PrintRoutingTable (ns3::Ptr<ns3::OutputStreamWrapper>) const;
+
+  /**
+   * \brief Writes the converged state (hello phase, neighbours, location
+   * service entries) for a warm start, terminated by an "end" line
+   */
+  void SaveState (std::ostream &os) const;
+  /**
+   * \brief Restores the state written by SaveState, up to its "end" line
+   *
+   * Must run after Start, i.e. once the location service exists.
+   */
+  void RestoreState (std::istream &is);
+
+  uint32_t GetNextHopCacheHits () const
+  {
+    return m_neighbors.GetNextHopCacheHits ();
+  }
+  uint32_t GetNextHopCacheMisses () const
+  {
+    return m_neighbors.GetNextHopCacheMisses ();
+  }
+  /// Data frames the MAC failed to send to a next hop
+  uint32_t GetTxErrors () const
+  {
+    return m_neighbors.GetTxErrors ();
+  }
+  /// Neighbours dropped after MAC tx failures
+  uint32_t GetLinkBreaks () const
+  {
+    return m_neighbors.GetLinkBreaks ();
+  }
+  /// Packets taken back from the MAC queues of a broken link and routed again
+  uint32_t GetReroutedPackets () const
+  {
+    return m_reroutedPackets;
+  }
   //  std::string PrintPositionTable ();
 
 
@@ -104,6 +146,17 @@ private:
   /// If route exists and valid, forward packet.
   bool Forwarding (Ptr<const Packet> p, const Ipv4Header & header, UnicastForwardCallback ucb, ErrorCallback ecb);
 
+  /// Records the MAC address of the sender of each hello frame
+  void RecvHelloFrame (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                       const Address &from, const Address &to, NetDevice::PacketType packetType);
+
+  /**
+   * \brief Position and velocity, now, of the neighbour with a MAC address
+   *
+   * Feeds VehicularWifiManager from the position table.
+   */
+  bool GetNeighborKinematics (Mac48Address mac, Vector &position, Vector &velocity);
+
   /// Find socket with local interface address iface
   Ptr<Socket> FindSocketWithInterfaceAddress (Ipv4InterfaceAddress iface) const;
 
@@ -115,7 +168,20 @@ private:
   void CheckQueue ();
 
   void RecoveryMode(Ipv4Address dst, Ptr<Packet> p, UnicastForwardCallback ucb, Ipv4Header header);
-  
+
+  /// False for the packets of the location service, which the Tx and Deliver traces skip
+  bool IsDataPacket (Ptr<const Packet> p) const;
+
+  /// Fire the Drop trace source; also called by m_queue
+  void NotifyDrop (Ptr<const Packet> p, uint8_t reason);
+
+  /// Called by m_neighbors when a neighbour is dropped after MAC tx failures
+  void NotifyLinkBreak (Ipv4Address neighbor, Mac48Address mac);
+  /// Routes again the packets the MACs still hold for the neighbour with address mac
+  void RerouteQueued (Mac48Address mac);
+  /// Unicast callback of RerouteQueued: sends a rerouted packet without going through the IP layer again
+  void SendRerouted (Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header &header);
+
   uint32_t MaxQueueLen;                  ///< The maximum number of packets that we allow a routing protocol to buffer.
   Time MaxQueueTime;                     ///< The maximum period of time that a routing protocol is allowed to buffer a packet for.
   RequestQueue m_queue;
@@ -125,11 +191,32 @@ private:
   uint8_t LocationServiceName;
   PositionTable m_neighbors;
   bool PerimeterMode;
+  uint8_t PlanarGraphName;
+  double PlanarRebuildDistance;          ///< Distance this node moves before its planar graph is rebuilt, m
   std::list<Ipv4Address> m_queuedAddresses;
   Ptr<LocationService> m_locationService;
 
+  Time NextHopCacheTimeout;              ///< Lifetime of a cached next hop, zero disables the cache
+  double NextHopCacheDistance;           ///< Cached next hop is dropped when this node or dst moved further, m
+  double LinkSnrAlpha;                   ///< Weight of the latest hello in the smoothed link snr
+  double LinkQualityLow;                 ///< A neighbour is no longer a greedy next hop below this link quality
+  double LinkQualityHigh;                ///< and is one again above this one
+  uint32_t MaxTxErrors;                  ///< MAC tx failures after which a neighbour is dropped, 0 never
+  uint32_t m_reroutedPackets;
+
   IpL4Protocol::DownTargetCallback m_downTarget;
 
+  /// Data packet sent by this node: packet, destination
+  TracedCallback<Ptr<const Packet>, Ipv4Address> m_txTrace;
+  /// Data packet given to a next hop: packet, next hop, own position, 0 greedy / 1 perimeter
+  TracedCallback<Ptr<const Packet>, Ipv4Address, Vector, uint8_t> m_forwardTrace;
+  /// Data packet taken out of the request queue: packet, time it waited
+  TracedCallback<Ptr<const Packet>, Time> m_dequeueTrace;
+  /// Data packet delivered to this node
+  TracedCallback<Ptr<const Packet> > m_deliverTrace;
+  /// Data packet dropped: packet, DropReason
+  TracedCallback<Ptr<const Packet>, uint8_t> m_dropTrace;
+
 
 
 };
@@ -21,7 +21,23 @@
 #include "ns3/gpsr-packet.h"
 #include "ns3/gpsr-rqueue.h"
 #include "ns3/gpsr-ptable.h"
+#include "ns3/gpsr.h"
+#include "ns3/gpsr-helper.h"
 #include "ns3/ipv4-route.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/mobility-model.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/nqos-wifi-mac-helper.h"
+#include "ns3/wifi-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/string.h"
+#include <sstream>
 
 namespace ns3
 {
@@ -39,20 +55,24 @@ void
 NeighborTest::DoRun ()
 {
   PositionTable nb  = PositionTable ();
+  Vector still (0, 0, 0);
+  Vector pos, vel;
 
 
-  nb.AddEntry (Ipv4Address ("1.2.3.4"), Vector (10, 20, 0));
+  nb.AddEntry (Ipv4Address ("1.2.3.4"), Vector (10, 20, 0), still, 0);
   NS_TEST_EXPECT_MSG_EQ (nb.isNeighbour (Ipv4Address ("1.2.3.4")), true, "Neighbor exists");
   NS_TEST_EXPECT_MSG_EQ (nb.isNeighbour (Ipv4Address ("4.3.2.1")), false, "Neighbor doesn't exist");
 
   //test update neighbour
-  NS_TEST_EXPECT_MSG_EQ (nb.GetPosition (Ipv4Address ("1.2.3.4")).x, 10, "Correct X position in table");
-  NS_TEST_EXPECT_MSG_EQ (nb.GetPosition (Ipv4Address ("1.2.3.4")).y, 20, "Correct Y position in table");
-  nb.AddEntry (Ipv4Address ("1.2.3.4"), Vector (30, 40, 0));
-  NS_TEST_EXPECT_MSG_EQ (nb.GetPosition (Ipv4Address ("1.2.3.4")).x, 30, "X Position correctly updated");
-  NS_TEST_EXPECT_MSG_EQ (nb.GetPosition (Ipv4Address ("1.2.3.4")).y, 40, "Y Position correctly updated");
-
-  nb.AddEntry (Ipv4Address ("4.3.2.1"), Vector (10, 10, 0));
+  nb.GetKinematics (Ipv4Address ("1.2.3.4"), pos, vel);
+  NS_TEST_EXPECT_MSG_EQ (pos.x, 10, "Correct X position in table");
+  NS_TEST_EXPECT_MSG_EQ (pos.y, 20, "Correct Y position in table");
+  nb.AddEntry (Ipv4Address ("1.2.3.4"), Vector (30, 40, 0), still, 0);
+  nb.GetKinematics (Ipv4Address ("1.2.3.4"), pos, vel);
+  NS_TEST_EXPECT_MSG_EQ (pos.x, 30, "X Position correctly updated");
+  NS_TEST_EXPECT_MSG_EQ (pos.y, 40, "Y Position correctly updated");
+
+  nb.AddEntry (Ipv4Address ("4.3.2.1"), Vector (10, 10, 0), still, 0);
   NS_TEST_EXPECT_MSG_EQ (nb.isNeighbour (Ipv4Address ("1.2.3.4")), true, "Neighbor exists");
   NS_TEST_EXPECT_MSG_EQ (nb.isNeighbour (Ipv4Address ("4.3.2.1")), true, "Neighbor exists");
 
@@ -62,21 +82,205 @@ NeighborTest::DoRun ()
 
 
   //test to select correct neighbour
-  nb.AddEntry (Ipv4Address ("1.2.3.4"), Vector (10, 20, 0));
-  nb.AddEntry (Ipv4Address ("1.2.3.10"), Vector (30, 30, 0));
-  NS_TEST_EXPECT_MSG_EQ (nb.BestNeighbor (Vector (20, 10, 0), Vector (0, 0, 0)), Ipv4Address ("4.3.2.1"), "Found correct neighbour in greedy");
-  NS_TEST_EXPECT_MSG_EQ (nb.BestNeighbor (Vector (40, 30, 0), Vector (0, 0, 0)), Ipv4Address ("1.2.3.10"), "Found correct neighbour in greedy");
+  nb.AddEntry (Ipv4Address ("1.2.3.4"), Vector (10, 20, 0), still, 0);
+  nb.AddEntry (Ipv4Address ("1.2.3.10"), Vector (30, 30, 0), still, 0);
+  NS_TEST_EXPECT_MSG_EQ (nb.BestNeighbor (Vector (20, 10, 0), still, Vector (0, 0, 0), still), Ipv4Address ("4.3.2.1"), "Found correct neighbour in greedy");
+  NS_TEST_EXPECT_MSG_EQ (nb.BestNeighbor (Vector (40, 30, 0), still, Vector (0, 0, 0), still), Ipv4Address ("1.2.3.10"), "Found correct neighbour in greedy");
 
   //test not to select any neighbour further away from destination
-  NS_TEST_EXPECT_MSG_EQ (nb.BestNeighbor (Vector (50, 20, 0), Vector (40, 20, 0)), Ipv4Address::GetZero (), "No neighbour further away to destination selected");
+  NS_TEST_EXPECT_MSG_EQ (nb.BestNeighbor (Vector (50, 20, 0), still, Vector (40, 20, 0), still), Ipv4Address::GetZero (), "No neighbour further away to destination selected");
   
 
-  //test selection of correct neighbour in recovery mode
+  //test selection of correct neighbour in recovery mode, on all the neighbours
+  nb.SetPlanarGraph (GPSR_PLANAR_NONE);
   NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (Vector (30, 30, 0), Vector (20, 30, 0)), Ipv4Address ("4.3.2.1"), "Found correct neighbour in recovery");
   NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (Vector (10, 20, 0), Vector (30, 30, 0)), Ipv4Address ("1.2.3.10"), "Found correct neighbour in recovery");
 
 }
 //-----------------------------------------------------------------------------
+/// Unit test for the planarization of the neighbours used in recovery mode
+struct PlanarGraphTest : public TestCase
+{
+  PlanarGraphTest () : TestCase ("GPSR planar graph") { }
+  virtual void DoRun ();
+  void CheckExpired ();
+
+  PositionTable nb;
+};
+
+void
+PlanarGraphTest::DoRun ()
+{
+  Vector still (0, 0, 0);
+  Vector centre (100, 100, 0);
+  // Right before (clockwise) the reference direction comes v, then w
+  Vector ref (200, 117, 0);
+  Ipv4Address v ("10.0.0.1");
+  Ipv4Address w ("10.0.0.2");
+
+  nb.AddEntry (v, Vector (120, 100, 0), still, 0);
+  nb.AddEntry (w, Vector (110, 112, 0), still, 0);
+
+  // w is outside the circle of diameter centre-v, but closer to both ends
+  nb.SetPlanarGraph (GPSR_PLANAR_NONE);
+  NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (ref, centre), v, "All edges are kept without planarization");
+  nb.SetPlanarGraph (GPSR_PLANAR_GG);
+  NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (ref, centre), v, "Edge to v kept in the GG");
+  nb.SetPlanarGraph (GPSR_PLANAR_RNG);
+  NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (ref, centre), w, "Edge to v removed from the RNG");
+
+  // w moves into the circle of diameter centre-v
+  nb.SetPlanarGraph (GPSR_PLANAR_GG);
+  NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (ref, centre), v, "Edge to v kept in the GG");
+  nb.AddEntry (w, Vector (110, 103, 0), still, 0);
+  NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (ref, centre), w, "Edge to v removed when w moves in");
+  nb.AddEntry (w, Vector (110, 130, 0), still, 0);
+  NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (ref, centre), v, "Edge to v back when w moves out");
+  nb.AddEntry (w, Vector (110, 103, 0), still, 0);
+  NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (ref, centre), w, "Edge to v removed when w moves in");
+  nb.DeleteEntry (w);
+  NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (ref, centre), v, "Edge to v back when w is removed");
+
+  // v is added after w
+  nb.DeleteEntry (v);
+  nb.AddEntry (w, Vector (110, 103, 0), still, 0);
+  NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (ref, centre), w, "Only w left");
+  nb.AddEntry (v, Vector (120, 100, 0), still, 0);
+  NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (ref, centre), w, "Edge to a new v removed by w");
+
+  // The graph is only rebuilt once the centre moved more than the rebuild distance
+  PositionTable moving;
+  Vector ref2 (10, 3.64, 0);
+  moving.SetPlanarGraph (GPSR_PLANAR_GG);
+  moving.AddEntry (v, Vector (10, 0, 0), still, 0);
+  moving.AddEntry (w, Vector (5, 4.9, 0), still, 0);
+  NS_TEST_EXPECT_MSG_EQ (moving.BestAngle (ref2, Vector (0, 0, 0)), w, "Edge to v removed by w");
+  NS_TEST_EXPECT_MSG_EQ (moving.BestAngle (ref2, Vector (0, -0.5, 0)), w, "Graph kept after a small move");
+  moving.SetPlanarRebuildDistance (0.1);
+  NS_TEST_EXPECT_MSG_EQ (moving.BestAngle (ref2, Vector (0, -0.5, 0)), v, "Edge to v kept around the new centre");
+
+  // w expires while v is refreshed
+  Simulator::Schedule (Seconds (1.5), &PositionTable::AddEntry, &nb, v, Vector (120, 100, 0), still, 0.0);
+  Simulator::Schedule (Seconds (2.5), &PlanarGraphTest::CheckExpired, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+PlanarGraphTest::CheckExpired ()
+{
+  NS_TEST_EXPECT_MSG_EQ (nb.BestAngle (Vector (200, 117, 0), Vector (100, 100, 0)), Ipv4Address ("10.0.0.1"),
+                         "Edge to v back when w expires");
+}
+//-----------------------------------------------------------------------------
+/// Unit test for the face routing of the recovery mode
+struct FaceRoutingTest : public TestCase
+{
+  FaceRoutingTest () : TestCase ("GPSR face routing") { }
+  virtual void DoRun ();
+};
+
+void
+FaceRoutingTest::DoRun ()
+{
+  Vector still (0, 0, 0);
+  Ipv4Address a ("10.0.0.1");
+  Ipv4Address b ("10.0.0.2");
+  Ipv4Address x ("10.0.0.3");
+  Ipv4Address y ("10.0.0.4");
+  bool loop;
+
+  // Face change: a enters recovery towards (200, 100), its only
+  // neighbour b then takes the edge to x which crosses the line from a
+  // to the destination
+  PositionTable nbB;
+  nbB.AddEntry (a, Vector (100, 100, 0), still, 0);
+  nbB.AddEntry (x, Vector (125, 105, 0), still, 0);
+  nbB.AddEntry (y, Vector (110, 75, 0), still, 0);
+
+  PositionHeader h (/*dstPosx*/ 200, /*dstPosy*/ 100, /*updated*/ 0, /*recPosx*/ 100, /*recPosy*/ 100, /*inRec*/ 1, /*lastPosx*/ 100, /*lastPosy*/ 100);
+  h.SetFirstEdgeFrom (a);
+  h.SetFirstEdgeTo (b);
+  NS_TEST_EXPECT_MSG_EQ (nbB.FaceNextHop (b, Vector (105, 90, 0), h, loop), y, "Next edge of the new face");
+  NS_TEST_EXPECT_MSG_EQ (loop, false, "No loop");
+  NS_TEST_EXPECT_MSG_EQ (h.GetFacePosx (), 118, "Face entered where b-x crosses the line to the destination");
+  NS_TEST_EXPECT_MSG_EQ (h.GetFacePosy (), 100, "Face entered where b-x crosses the line to the destination");
+  NS_TEST_EXPECT_MSG_EQ (h.GetFirstEdgeFrom (), b, "First edge of the new face");
+  NS_TEST_EXPECT_MSG_EQ (h.GetFirstEdgeTo (), y, "First edge of the new face");
+  NS_TEST_EXPECT_MSG_EQ (h.GetLastPosx (), 105, "Previous hop updated");
+
+  // Perimeter loop: the destination (0, 100) is behind a, whose only
+  // neighbour is b, whose only neighbour is a
+  PositionTable nbA;
+  nbA.AddEntry (b, Vector (110, 100, 0), still, 0);
+  PositionTable nbB2;
+  nbB2.AddEntry (a, Vector (100, 100, 0), still, 0);
+
+  PositionHeader p (/*dstPosx*/ 0, /*dstPosy*/ 100, /*updated*/ 0, /*recPosx*/ 100, /*recPosy*/ 100, /*inRec*/ 1, /*lastPosx*/ 0, /*lastPosy*/ 100);
+  NS_TEST_EXPECT_MSG_EQ (nbA.FaceNextHop (a, Vector (100, 100, 0), p, loop), b, "a sends to b");
+  NS_TEST_EXPECT_MSG_EQ (p.GetFirstEdgeFrom (), a, "First edge is a-b");
+  NS_TEST_EXPECT_MSG_EQ (p.GetFirstEdgeTo (), b, "First edge is a-b");
+  NS_TEST_EXPECT_MSG_EQ (nbB2.FaceNextHop (b, Vector (110, 100, 0), p, loop), a, "b sends back to a");
+  NS_TEST_EXPECT_MSG_EQ (loop, false, "No loop yet");
+  NS_TEST_EXPECT_MSG_EQ (nbA.FaceNextHop (a, Vector (100, 100, 0), p, loop), Ipv4Address::GetZero (), "Dropped on a-b again");
+  NS_TEST_EXPECT_MSG_EQ (loop, true, "Perimeter loop");
+}
+//-----------------------------------------------------------------------------
+/// Unit test for the cache of greedy next hops
+struct NextHopCacheTest : public TestCase
+{
+  NextHopCacheTest () : TestCase ("GPSR next hop cache") { }
+  virtual void DoRun ();
+  void Check (Ipv4Address expected, uint32_t hits, uint32_t misses);
+
+  PositionTable nb;
+};
+
+void
+NextHopCacheTest::Check (Ipv4Address expected, uint32_t hits, uint32_t misses)
+{
+  Vector still (0, 0, 0);
+  NS_TEST_EXPECT_MSG_EQ (nb.BestNeighbor (Ipv4Address ("10.0.0.100"), Vector (100, 0, 0), still, Vector (0, 0, 0), still),
+                         expected, "Best neighbour at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ (nb.GetNextHopCacheHits (), hits, "Cache hits at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ (nb.GetNextHopCacheMisses (), misses, "Cache misses at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+NextHopCacheTest::DoRun ()
+{
+  Vector still (0, 0, 0);
+  Ipv4Address near ("10.0.0.1");
+  Ipv4Address far ("10.0.0.2");
+  Ipv4Address dst ("10.0.0.100");
+
+  nb.SetNextHopCache (Seconds (0.5), 10);
+  nb.AddEntry (near, Vector (50, 0, 0), still, 0);
+  nb.AddEntry (far, Vector (30, 0, 0), still, 0);
+  Check (near, 0, 1);
+  Check (near, 1, 1);
+
+  // A hello moving the cached next hop away is only seen at the timeout
+  nb.AddEntry (near, Vector (10, 0, 0), still, 0);
+  Check (near, 2, 1);
+
+  // The destination moves
+  NS_TEST_EXPECT_MSG_EQ (nb.BestNeighbor (dst, Vector (120, 0, 0), still, Vector (0, 0, 0), still),
+                         far, "Best neighbour for a moved destination");
+  NS_TEST_EXPECT_MSG_EQ (nb.GetNextHopCacheMisses (), 2, "Destination movement recomputes the next hop");
+
+  // The cached next hop times out, then expires: near is heard at 0 s only, far at 1.5 s too
+  nb.AddEntry (near, Vector (50, 0, 0), still, 0);
+  Simulator::Schedule (Seconds (0.2), &NextHopCacheTest::Check, this, near, 2, 3);
+  Simulator::Schedule (Seconds (0.3), &NextHopCacheTest::Check, this, near, 3, 3);
+  Simulator::Schedule (Seconds (1.5), &PositionTable::AddEntry, &nb, far, Vector (30, 0, 0), still, 0.0);
+  Simulator::Schedule (Seconds (1.6), &NextHopCacheTest::Check, this, near, 3, 4);
+  Simulator::Schedule (Seconds (1.7), &NextHopCacheTest::Check, this, near, 4, 4);
+  Simulator::Schedule (Seconds (2.5), &NextHopCacheTest::Check, this, far, 4, 5);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+//-----------------------------------------------------------------------------
 struct TypeHeaderTest : public TestCase
 {
   TypeHeaderTest () : TestCase ("GPSR TypeHeader") 
@@ -162,7 +366,13 @@ struct PositionHeaderTest : public TestCase
     p->AddHeader (h);
     PositionHeader h2;
     uint32_t bytes = p->RemoveHeader (h2);
-    NS_TEST_EXPECT_MSG_EQ (bytes, 53, "POS is 53 bytes long");
+    NS_TEST_EXPECT_MSG_EQ (bytes, 77, "POS in recovery mode is 77 bytes long");
+    NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
+
+    h.SetInRec (0);
+    p->AddHeader (h);
+    bytes = p->RemoveHeader (h2);
+    NS_TEST_EXPECT_MSG_EQ (bytes, 53, "POS in greedy mode is 53 bytes long");
     NS_TEST_EXPECT_MSG_EQ (h, h2, "Round trip serialization works");
   }
 };
@@ -263,16 +473,327 @@ GpsrRqueueTest::CheckTimeout ()
   NS_TEST_EXPECT_MSG_EQ (q.GetSize (), 0, "Must be empty now");
 }
 //-----------------------------------------------------------------------------
+/// Unit test for the hello-ratio link estimator, its hysteresis and its saved state
+struct LinkEstimatorTest : public TestCase
+{
+  LinkEstimatorTest () : TestCase ("Link estimator"), m_neighbor ("10.0.0.2") {}
+  virtual void DoRun ();
+  void Hello ();
+  void Check (double quality, bool usable);
+  void CheckSaved ();
+
+  PositionTable m_table;
+  Ipv4Address m_neighbor;
+};
+
+void
+LinkEstimatorTest::Hello ()
+{
+  m_table.AddEntry (m_neighbor, Vector (10, 0, 0), Vector (0, 0, 0), 0);
+}
+
+void
+LinkEstimatorTest::Check (double quality, bool usable)
+{
+  Vector still (0, 0, 0);
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_table.GetLinkQuality (m_neighbor), quality, 1e-9,
+                             "Quality at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ (m_table.BestNeighbor (Vector (100, 0, 0), still, Vector (0, 0, 0), still),
+                         usable ? m_neighbor : Ipv4Address::GetZero (),
+                         "Greedy next hop at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+LinkEstimatorTest::CheckSaved ()
+{
+  std::stringstream state;
+  m_table.SaveState (state);
+  std::string tag;
+  state >> tag;
+  NS_TEST_ASSERT_MSG_EQ (tag, "neighbor", "One neighbour line");
+
+  PositionTable restored;
+  restored.RestoreState (state);
+  NS_TEST_EXPECT_MSG_EQ (restored.isNeighbour (m_neighbor), true, "Neighbour restored");
+  NS_TEST_EXPECT_MSG_EQ_TOL (restored.GetLinkQuality (m_neighbor), m_table.GetLinkQuality (m_neighbor), 1e-9,
+                             "Hellos, intervals and tx errors restored");
+  Vector still (0, 0, 0);
+  NS_TEST_EXPECT_MSG_EQ (restored.BestNeighbor (Vector (100, 0, 0), still, Vector (0, 0, 0), still),
+                         Ipv4Address::GetZero (), "Unusable link restored");
+
+  // Lines saved before the link estimator existed start as a fresh link
+  std::stringstream old ("10.0.0.3 20 0 0 0 0 0 0 0");
+  restored.RestoreState (old);
+  NS_TEST_EXPECT_MSG_EQ_TOL (restored.GetLinkQuality (Ipv4Address ("10.0.0.3")), 1, 1e-9, "Fresh link");
+}
+
+void
+LinkEstimatorTest::DoRun ()
+{
+  // Short hello interval, so that hellos can be lost within the entry lifetime
+  m_table.SetLinkEstimator (Seconds (0.1), 0.25, 0.5, 0.75);
+
+  // 0 - 0.7 s: every hello received, the window is full
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      Simulator::Schedule (Seconds (0.1 * i), &LinkEstimatorTest::Hello, this);
+    }
+  Simulator::Schedule (Seconds (0.75), &LinkEstimatorTest::Check, this, 1, true);
+  // 1 - 1.6 s: two hellos in three lost
+  Simulator::Schedule (Seconds (1.0), &LinkEstimatorTest::Hello, this);
+  Simulator::Schedule (Seconds (1.05), &LinkEstimatorTest::Check, this, 6 / 8.0, true);
+  Simulator::Schedule (Seconds (1.3), &LinkEstimatorTest::Hello, this);
+  Simulator::Schedule (Seconds (1.35), &LinkEstimatorTest::Check, this, 4 / 8.0, true);
+  Simulator::Schedule (Seconds (1.6), &LinkEstimatorTest::Hello, this);
+  Simulator::Schedule (Seconds (1.65), &LinkEstimatorTest::Check, this, 3 / 8.0, false);
+  // 1.7 s on: every hello received, usable again only above the high threshold
+  Simulator::Schedule (Seconds (1.7), &LinkEstimatorTest::Hello, this);
+  Simulator::Schedule (Seconds (1.75), &LinkEstimatorTest::Check, this, 4 / 8.0, false);
+  Simulator::Schedule (Seconds (1.8), &LinkEstimatorTest::Hello, this);
+  Simulator::Schedule (Seconds (1.9), &LinkEstimatorTest::Hello, this);
+  Simulator::Schedule (Seconds (1.95), &LinkEstimatorTest::Check, this, 5 / 8.0, false);
+  Simulator::Schedule (Seconds (1.96), &LinkEstimatorTest::CheckSaved, this);
+  Simulator::Schedule (Seconds (2.0), &LinkEstimatorTest::Hello, this);
+  Simulator::Schedule (Seconds (2.05), &LinkEstimatorTest::Check, this, 6 / 8.0, true);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+//-----------------------------------------------------------------------------
+/// Unit test for hellos without an snr measurement
+struct HelloSnrTest : public TestCase
+{
+  HelloSnrTest () : TestCase ("GPSR hello snr") {}
+  virtual void DoRun ();
+};
+
+void
+HelloSnrTest::DoRun ()
+{
+  PositionTable nb;
+  Vector still (0, 0, 0);
+  Ipv4Address a ("10.0.0.1");
+  Ipv4Address b ("10.0.0.2");
+
+  nb.AddEntry (a, Vector (50, 0, 0), still, PositionTable::NoSnr ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (nb.GetSnr (a), 0, 1e-9, "No snr measured yet");
+  nb.AddEntry (a, Vector (50, 0, 0), still, 20);
+  NS_TEST_EXPECT_MSG_EQ_TOL (nb.GetSnr (a), 20, 1e-9, "First measurement taken as is");
+  nb.AddEntry (a, Vector (50, 0, 0), still, PositionTable::NoSnr ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (nb.GetSnr (a), 20, 1e-9, "Missing measurement leaves the snr");
+  nb.AddEntry (a, Vector (50, 0, 0), still, 10);
+  NS_TEST_EXPECT_MSG_EQ_TOL (nb.GetSnr (a), 17.5, 1e-9, "Measurement smoothed with weight 0.25");
+
+  // Whether the snr was measured survives a save and restore
+  nb.AddEntry (b, Vector (60, 0, 0), still, PositionTable::NoSnr ());
+  std::stringstream state;
+  nb.SaveState (state);
+  PositionTable restored;
+  std::string tag;
+  while (state >> tag)
+    {
+      restored.RestoreState (state);
+    }
+  restored.AddEntry (b, Vector (60, 0, 0), still, 8);
+  NS_TEST_EXPECT_MSG_EQ_TOL (restored.GetSnr (b), 8, 1e-9, "First measurement after a restore");
+  restored.AddEntry (a, Vector (50, 0, 0), still, PositionTable::NoSnr ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (restored.GetSnr (a), 17.5, 1e-9, "Smoothed snr restored");
+
+  Simulator::Destroy ();
+}
+//-----------------------------------------------------------------------------
+/// Unit test for dropping neighbours on MAC tx failures
+struct LinkBreakTest : public TestCase
+{
+  LinkBreakTest () : TestCase ("Link break"), m_breaks (0) {}
+  virtual void DoRun ();
+  void LinkBreak (Ipv4Address neighbor, Mac48Address mac);
+
+  uint32_t m_breaks;
+  Ipv4Address m_neighbor;
+  Mac48Address m_mac;
+};
+
+void
+LinkBreakTest::LinkBreak (Ipv4Address neighbor, Mac48Address mac)
+{
+  m_breaks++;
+  m_neighbor = neighbor;
+  m_mac = mac;
+}
+
+void
+LinkBreakTest::DoRun ()
+{
+  // Not copied: the table hands out callbacks bound to itself
+  PositionTable nb;
+  Vector still (0, 0, 0);
+  Ipv4Address b ("10.0.0.2");
+  Mac48Address bMac ("00:00:00:00:00:02");
+
+  // The MAC reports frames by MAC address, recorded from the frame of the hello
+  nb.SetNeighborMac (b, bMac);
+  NS_TEST_EXPECT_MSG_EQ (nb.LookupNeighbor (bMac), Ipv4Address::GetZero (), "No neighbour before the hello");
+  nb.SetMaxTxErrors (2);
+  nb.SetLinkBreakCallback (MakeCallback (&LinkBreakTest::LinkBreak, this));
+  nb.AddEntry (b, Vector (50, 0, 0), still, 0);
+  NS_TEST_EXPECT_MSG_EQ (nb.LookupNeighbor (bMac), b, "Neighbour found by MAC address");
+  Callback<void, WifiMacHeader const &> txError = nb.GetTxErrorCallback ();
+
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_MGT_PROBE_REQUEST);
+  hdr.SetAddr1 (bMac);
+  txError (hdr);
+  NS_TEST_EXPECT_MSG_EQ (nb.GetTxErrors (), 0, "Only data frames count");
+
+  hdr.SetType (WIFI_MAC_DATA);
+  txError (hdr);
+  NS_TEST_EXPECT_MSG_EQ (nb.GetTxErrors (), 1, "Data frame counted");
+  NS_TEST_EXPECT_MSG_EQ (nb.isNeighbour (b), true, "Kept below MaxTxErrors");
+  NS_TEST_EXPECT_MSG_EQ (m_breaks, 0, "No link break yet");
+
+  txError (hdr);
+  NS_TEST_EXPECT_MSG_EQ (nb.GetTxErrors (), 2, "Data frame counted");
+  NS_TEST_EXPECT_MSG_EQ (nb.isNeighbour (b), false, "Dropped at MaxTxErrors");
+  NS_TEST_EXPECT_MSG_EQ (nb.GetLinkBreaks (), 1, "Link break counted");
+  NS_TEST_EXPECT_MSG_EQ (m_breaks, 1, "Link break notified");
+  NS_TEST_EXPECT_MSG_EQ (m_neighbor, b, "Address of the dropped neighbour");
+  NS_TEST_EXPECT_MSG_EQ (m_mac, bMac, "MAC address of the dropped neighbour");
+  NS_TEST_EXPECT_MSG_EQ (nb.LookupNeighbor (bMac), Ipv4Address::GetZero (), "MAC address forgotten with the neighbour");
+
+  // Frames to a station that is no neighbour are only counted
+  hdr.SetAddr1 (Mac48Address ("00:00:00:00:00:09"));
+  txError (hdr);
+  NS_TEST_EXPECT_MSG_EQ (nb.GetTxErrors (), 3, "Data frame counted");
+  NS_TEST_EXPECT_MSG_EQ (nb.GetLinkBreaks (), 1, "No neighbour to drop");
+  NS_TEST_EXPECT_MSG_EQ (m_breaks, 1, "No neighbour to drop");
+
+  Simulator::Destroy ();
+}
+//-----------------------------------------------------------------------------
+/**
+ * Node a sends to its neighbour b right after b left: the first frame
+ * fails, b is dropped and the frames still queued for it in the MAC go
+ * back into the IP input of a, and so through RouteInput.
+ */
+struct RerouteTest : public TestCase
+{
+  RerouteTest () : TestCase ("Reroute frames queued for a broken link"), m_rx (0), m_noNeighbor (0) {}
+  virtual void DoRun ();
+  void Send (Ptr<Socket> socket, uint32_t count);
+  void Rx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface);
+  void Drop (Ptr<const Packet> packet, uint8_t reason);
+  void Move (Ptr<Node> node, Vector position);
+  void Check (Ptr<RoutingProtocol> gpsr);
+
+  /// IP packets received by a once b left
+  uint32_t m_rx;
+  /// Packets dropped by a for lack of a neighbour
+  uint32_t m_noNeighbor;
+};
+
+void
+RerouteTest::Send (Ptr<Socket> socket, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++)
+    {
+      socket->SendTo (Create<Packet> (100), 0, InetSocketAddress (Ipv4Address ("10.0.0.2"), 9));
+    }
+}
+
+void
+RerouteTest::Rx (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  if (Simulator::Now () >= Seconds (2))
+    {
+      m_rx++;
+    }
+}
+
+void
+RerouteTest::Drop (Ptr<const Packet> packet, uint8_t reason)
+{
+  if (reason == GPSR_DROP_NO_NEIGHBOR)
+    {
+      m_noNeighbor++;
+    }
+}
+
+void
+RerouteTest::Move (Ptr<Node> node, Vector position)
+{
+  node->GetObject<MobilityModel> ()->SetPosition (position);
+}
+
+void
+RerouteTest::Check (Ptr<RoutingProtocol> gpsr)
+{
+  NS_TEST_EXPECT_MSG_EQ (gpsr->GetLinkBreaks (), 1, "b dropped after its first failed frame");
+  NS_TEST_EXPECT_MSG_EQ (gpsr->GetReroutedPackets (), 4, "The frames behind the failed one are rerouted");
+  NS_TEST_EXPECT_MSG_EQ (m_rx, 0, "Rerouted packets do not go through the IP input again");
+  NS_TEST_EXPECT_MSG_EQ (m_noNeighbor, 4, "a has no neighbour left for the rerouted packets");
+}
+
+void
+RerouteTest::DoRun ()
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+  nodes.Get (1)->GetObject<MobilityModel> ()->SetPosition (Vector (50, 0, 0));
+
+  NqosWifiMacHelper wifiMac = NqosWifiMacHelper::Default ();
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  YansWifiPhyHelper wifiPhy = YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel = YansWifiChannelHelper::Default ();
+  wifiPhy.SetChannel (wifiChannel.Create ());
+  WifiHelper wifi = WifiHelper::Default ();
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager", "DataMode", StringValue ("OfdmRate6Mbps"));
+  NetDeviceContainer devices = wifi.Install (wifiPhy, wifiMac, nodes);
+
+  GpsrHelper gpsrHelper;
+  InternetStackHelper stack;
+  stack.SetRoutingHelper (gpsrHelper);
+  stack.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.255.0.0");
+  address.Assign (devices);
+  gpsrHelper.Install ();
+
+  Ptr<Socket> source = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  Ptr<Socket> sink = Socket::CreateSocket (nodes.Get (1), UdpSocketFactory::GetTypeId ());
+  sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+  nodes.Get (0)->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext ("Rx", MakeCallback (&RerouteTest::Rx, this));
+  nodes.Get (0)->GetObject<RoutingProtocol> ()->TraceConnectWithoutContext ("Drop", MakeCallback (&RerouteTest::Drop, this));
+
+  // One packet while b is in range resolves its MAC address, after the hellos
+  Simulator::Schedule (Seconds (1.5), &RerouteTest::Send, this, source, 1);
+  Simulator::Schedule (Seconds (1.6), &RerouteTest::Move, this, nodes.Get (1), Vector (5000, 0, 0));
+  Simulator::Schedule (Seconds (2), &RerouteTest::Send, this, source, 5);
+  Simulator::Schedule (Seconds (2.5), &RerouteTest::Check, this, nodes.Get (0)->GetObject<RoutingProtocol> ());
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+//-----------------------------------------------------------------------------
 class GpsrTestSuite : public TestSuite
 {
 public:
   GpsrTestSuite () : TestSuite ("routing-gpsr", UNIT)
   {
     AddTestCase (new NeighborTest);
+    AddTestCase (new PlanarGraphTest);
+    AddTestCase (new FaceRoutingTest);
+    AddTestCase (new NextHopCacheTest);
     AddTestCase (new TypeHeaderTest);
     AddTestCase (new HelloHeaderTest);
     AddTestCase (new PositionHeaderTest);
     AddTestCase (new GpsrRqueueTest);
+    AddTestCase (new LinkEstimatorTest);
+    AddTestCase (new HelloSnrTest);
+    AddTestCase (new LinkBreakTest);
+    AddTestCase (new RerouteTest);
   }
 } g_gpsrTestSuite;
 
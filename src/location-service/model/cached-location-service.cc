@@ -0,0 +1,208 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include "cached-location-service.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("CachedLocationService");
+
+namespace ns3
+{
+NS_OBJECT_ENSURE_REGISTERED (CachedLocationService);
+
+TypeId
+CachedLocationService::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CachedLocationService")
+    .SetParent<LocationService> ()
+    .AddConstructor<CachedLocationService> ()
+    .AddAttribute ("EntryLifeTime", "Time a cached position is served before asking the backend again.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&CachedLocationService::m_entryLifeTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("Predict", "Extrapolate cached positions with the cached velocity.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&CachedLocationService::m_predict),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxPredictionAge", "Positions are not extrapolated further than this from their fix.",
+                   TimeValue (Seconds (2)),
+                   MakeTimeAccessor (&CachedLocationService::m_maxPredictionAge),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+CachedLocationService::CachedLocationService ()
+  : m_entryLifeTime (MilliSeconds (100)),
+    m_predict (true),
+    m_maxPredictionAge (Seconds (2))
+{
+}
+
+CachedLocationService::~CachedLocationService ()
+{
+}
+
+void
+CachedLocationService::DoDispose ()
+{
+  m_cache.clear ();
+  m_backend = 0;
+  LocationService::DoDispose ();
+}
+
+void
+CachedLocationService::SetBackend (Ptr<LocationService> backend)
+{
+  m_backend = backend;
+  m_cache.clear ();
+}
+
+Ptr<LocationService>
+CachedLocationService::GetBackend () const
+{
+  return m_backend;
+}
+
+const CachedLocationService::CacheEntry &
+CachedLocationService::Refresh (Ipv4Address adr)
+{
+  NS_ASSERT (m_backend != 0);
+  std::map<Ipv4Address, CacheEntry>::iterator i = m_cache.find (adr);
+  // an invalid position is never served from the cache, so a lookup that
+  // completes in the backend is seen at once instead of after EntryLifeTime
+  if (i != m_cache.end () && i->second.fetched + m_entryLifeTime > Simulator::Now ()
+      && !IsInvalid (i->second.pos))
+    {
+      return i->second;
+    }
+  CacheEntry entry;
+  entry.pos = m_backend->GetPosition (adr);
+  entry.vel = m_backend->GetVelocity (adr);
+  entry.updated = std::min (m_backend->GetEntryUpdateTime (adr), Simulator::Now ());
+  entry.fetched = Simulator::Now ();
+  CacheEntry &slot = m_cache[adr];
+  slot = entry;
+  return slot;
+}
+
+bool
+CachedLocationService::IsInvalid (const Vector &pos)
+{
+  Vector invalid = GetInvalidPosition ();
+  return pos.x == invalid.x && pos.y == invalid.y;
+}
+
+Vector
+CachedLocationService::GetPosition (Ipv4Address adr)
+{
+  const CacheEntry &entry = Refresh (adr);
+  if (!m_predict || IsInvalid (entry.pos))
+    {
+      return entry.pos;
+    }
+  double age = std::min (Simulator::Now () - entry.updated, m_maxPredictionAge).GetSeconds ();
+  return Vector (entry.pos.x + entry.vel.x * age,
+                 entry.pos.y + entry.vel.y * age,
+                 entry.pos.z + entry.vel.z * age);
+}
+
+Vector
+CachedLocationService::GetVelocity (Ipv4Address adr)
+{
+  return Refresh (adr).vel;
+}
+
+bool
+CachedLocationService::HasPosition (Ipv4Address adr)
+{
+  return m_backend->HasPosition (adr);
+}
+
+bool
+CachedLocationService::IsInSearch (Ipv4Address adr)
+{
+  return m_backend->IsInSearch (adr);
+}
+
+void
+CachedLocationService::StartSearch (Ipv4Address adr)
+{
+  m_backend->StartSearch (adr);
+}
+
+void
+CachedLocationService::SetIpv4 (Ptr<Ipv4> ipv4)
+{
+  NS_ASSERT (m_backend != 0);
+  m_backend->SetIpv4 (ipv4);
+}
+
+Vector
+CachedLocationService::GetInvalidPosition ()
+{
+  return m_backend->GetInvalidPosition ();
+}
+
+Time
+CachedLocationService::GetEntryUpdateTime (Ipv4Address id)
+{
+  return Refresh (id).updated;
+}
+
+void
+CachedLocationService::AddEntry (Ipv4Address id, Vector position)
+{
+  CacheEntry &entry = m_cache[id];
+  entry.pos = position;
+  entry.vel = m_backend != 0 ? m_backend->GetVelocity (id) : Vector ();
+  entry.updated = Simulator::Now ();
+  entry.fetched = Simulator::Now ();
+}
+
+void
+CachedLocationService::DeleteEntry (Ipv4Address id)
+{
+  m_cache.erase (id);
+}
+
+void
+CachedLocationService::Purge ()
+{
+  std::map<Ipv4Address, CacheEntry>::iterator i = m_cache.begin ();
+  while (i != m_cache.end ())
+    {
+      if (i->second.fetched + m_entryLifeTime <= Simulator::Now ())
+        {
+          m_cache.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+void
+CachedLocationService::Clear ()
+{
+  m_cache.clear ();
+}
+
+void
+CachedLocationService::SaveState (std::ostream &os) const
+{
+  NS_ASSERT (m_backend != 0);
+  m_backend->SaveState (os);
+}
+
+void
+CachedLocationService::RestoreState (std::istream &is)
+{
+  NS_ASSERT (m_backend != 0);
+  m_backend->RestoreState (is);
+}
+
+}
@@ -0,0 +1,83 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+#ifndef CACHED_LOCATION_SERVICE_H
+#define CACHED_LOCATION_SERVICE_H
+
+#include "ns3/location-service.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+#include <map>
+
+namespace ns3
+{
+/**
+ * \ingroup godLS
+ *
+ * \brief Per-node caching front for a (possibly shared) location service
+ *
+ * Position and velocity of a destination are fetched together from the
+ * backend and kept for EntryLifeTime, so the repeated GetPosition /
+ * GetVelocity / GetEntryUpdateTime calls made per packet are served from a
+ * local map instead of the backend.
+ *
+ * With Predict enabled the cached fix is dead-reckoned: GetPosition returns
+ * position + velocity * age, where age is the time since the backend's fix
+ * (GetEntryUpdateTime of the backend), capped at MaxPredictionAge.
+ */
+class CachedLocationService : public LocationService
+{
+public:
+  static TypeId GetTypeId (void);
+
+  /// c-tor
+  CachedLocationService ();
+  virtual ~CachedLocationService ();
+  virtual void DoDispose ();
+
+  /// Set the location service queried on a cache miss
+  void SetBackend (Ptr<LocationService> backend);
+  Ptr<LocationService> GetBackend () const;
+
+  Vector GetPosition (Ipv4Address adr);
+  Vector GetVelocity (Ipv4Address adr);
+  bool HasPosition (Ipv4Address adr);
+  bool IsInSearch (Ipv4Address adr);
+  virtual void StartSearch (Ipv4Address adr);
+
+  /// Forwarded to the backend, which may need it to send lookups
+  void SetIpv4 (Ptr<Ipv4> ipv4);
+  Vector GetInvalidPosition ();
+  Time GetEntryUpdateTime (Ipv4Address id);
+  void AddEntry (Ipv4Address id, Vector position);
+  void DeleteEntry (Ipv4Address id);
+
+  void Purge ();
+  virtual void Clear ();
+
+  /// Save the state of the backend; the cache refills from it
+  virtual void SaveState (std::ostream &os) const;
+  virtual void RestoreState (std::istream &is);
+
+private:
+  struct CacheEntry
+  {
+    Vector pos;
+    Vector vel;
+    /// Time of the position fix, as reported by the backend
+    Time updated;
+    /// Time the entry was read from the backend
+    Time fetched;
+  };
+
+  /// Return a fresh entry for adr, refreshing it from the backend if needed
+  const CacheEntry & Refresh (Ipv4Address adr);
+  /// True if pos is the backend's invalid position
+  bool IsInvalid (const Vector &pos);
+
+  Ptr<LocationService> m_backend;
+  std::map<Ipv4Address, CacheEntry> m_cache;
+  Time m_entryLifeTime;
+  bool m_predict;
+  Time m_maxPredictionAge;
+};
+}
+#endif /* CACHED_LOCATION_SERVICE_H */
@@ -15,10 +15,22 @@ namespace ns3
 NS_OBJECT_ENSURE_REGISTERED (GodLocationService);
 
 
+TypeId
+GodLocationService::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::GodLocationService")
+    .SetParent<LocationService> ()
+    .AddConstructor<GodLocationService> ()
+  ;
+  return tid;
+}
+
 GodLocationService::GodLocationService (Time tableLifeTime)
+  : m_indexedNodes (0)
 {}
 
 GodLocationService::GodLocationService ()
+  : m_indexedNodes (0)
 {}
 
 
@@ -28,7 +40,9 @@ GodLocationService::~GodLocationService ()
 void
 GodLocationService::DoDispose ()
 {
-  return;
+  m_index.clear ();
+  m_indexedNodes = 0;
+  LocationService::DoDispose ();
 }
 
 void
@@ -38,54 +52,60 @@ GodLocationService::Start ()
 }
 
 
-//FIX THIS
+void
+GodLocationService::BuildIndex ()
+{
+  m_index.clear ();
+  m_indexedNodes = NodeList::GetNNodes ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+      Ptr<MobilityModel> mm = (*i)->GetObject<MobilityModel> ();
+      if (ipv4 == 0 || mm == 0 || ipv4->GetNInterfaces () < 2)
+        {
+          continue;
+        }
+      m_index[ipv4->GetAddress (1, 0).GetLocal ()] = mm;
+    }
+}
+
+Ptr<MobilityModel>
+GodLocationService::Lookup (Ipv4Address adr)
+{
+  std::map<Ipv4Address, Ptr<MobilityModel> >::const_iterator i = m_index.find (adr);
+  if (i == m_index.end () && m_indexedNodes != NodeList::GetNNodes ())
+    {
+      BuildIndex ();
+      i = m_index.find (adr);
+    }
+  if (i == m_index.end ())
+    {
+      return 0;
+    }
+  return i->second;
+}
+
 Vector
-GodLocationService::GetPosition(Ipv4Address adr)
+GodLocationService::GetPosition (Ipv4Address adr)
 {
-  uint32_t n = NodeList().GetNNodes ();
-  uint32_t i;
-  Ptr<Node> node;
-  
-  //NS_LOG_UNCOND("Position of " << adr);
-  
-  for(i = 0; i < n; i++)
+  Ptr<MobilityModel> mm = Lookup (adr);
+  if (mm == 0)
     {
-      node = NodeList().GetNode (i);
-      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-
-      //NS_LOG_UNCOND("Have " << ipv4->GetAddress (1, 0).GetLocal ());     
-      if(ipv4->GetAddress (1, 0).GetLocal () == adr)
-	{
-	  return (*node->GetObject<MobilityModel>()).GetPosition ();
-	}
+      return GetInvalidPosition ();
     }
-  return GetInvalidPosition ();
-//  Vector v;
-//  return v;
+  return mm->GetPosition ();
 }
 
 Vector
-GodLocationService::GetVelocity(Ipv4Address adr)
+GodLocationService::GetVelocity (Ipv4Address adr)
 {
-  uint32_t n = NodeList().GetNNodes ();
-  uint32_t i;
-  Ptr<Node> node;
-  
-  //NS_LOG_UNCOND("Velocity of " << adr);
-  
-  for(i = 0; i < n; i++)
+  Ptr<MobilityModel> mm = Lookup (adr);
+  if (mm == 0)
     {
-      node = NodeList().GetNode (i);
-      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-
-      //NS_LOG_UNCOND("Have " << ipv4->GetAddress (1, 0).GetLocal ());     
-      if(ipv4->GetAddress (1, 0).GetLocal () == adr)
-	{
-	  return (*node->GetObject<MobilityModel>()).GetVelocity();
-	}
+      Vector v;
+      return v;
     }
-  Vector v;
-  return v;
+  return mm->GetVelocity ();
 }
 
   
@@ -9,6 +9,7 @@
 #include "god.h"
 #include "ns3/location-service.h"
 #include "ns3/vector.h"
+#include "ns3/mobility-model.h"
 #include <map>
 
 namespace ns3
@@ -17,11 +18,17 @@ namespace ns3
  * \ingroup godLS
  * 
  * \brief God Location Service
+ *
+ * The god service keeps no per-node state, so a single instance can be
+ * shared by every node (see GpsrHelper). Lookups go through an index of
+ * address -> mobility model that is built from the NodeList on first use
+ * and rebuilt whenever an address is not found and nodes were added since.
  */
 class GodLocationService : public LocationService
 {
 public:
-  
+  static TypeId GetTypeId (void);
+
   /// c-tor
   GodLocationService (Time tableLifeTime);
   GodLocationService ();
@@ -44,6 +51,15 @@ public:
 private:
   /// Start protocol operation
   void Start ();
+  /// Find the mobility model of the node owning adr, 0 if unknown
+  Ptr<MobilityModel> Lookup (Ipv4Address adr);
+  /// Rebuild the address index from the NodeList
+  void BuildIndex ();
+
+  /// Address of interface 1 -> mobility model of the node
+  std::map<Ipv4Address, Ptr<MobilityModel> > m_index;
+  /// Number of nodes in the NodeList when the index was built
+  uint32_t m_indexedNodes;
 };
 }
 #endif /* GodLocationService_H */
@@ -25,5 +25,29 @@ NS_LOG_COMPONENT_DEFINE ("LocationService");
 namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (LocationService);
+
+TypeId
+LocationService::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LocationService")
+    .SetParent<Object> ()
+  ;
+  return tid;
+}
+
+void
+LocationService::StartSearch (Ipv4Address adr)
+{
+}
+
+void
+LocationService::SaveState (std::ostream &os) const
+{
+}
+
+void
+LocationService::RestoreState (std::istream &is)
+{
+}
  
 }
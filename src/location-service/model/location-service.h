@@ -28,18 +28,30 @@
 #include "ns3/ipv4.h"
 #include "ns3/location-service.h"
 #include "ns3/vector.h"
+#include "ns3/tag.h"
 #include "ns3/log.h"
 #include <map>
+#include <iostream>
 
 namespace ns3 {
 
 class LocationService : public Object{
 
 public:
+  static TypeId GetTypeId (void);
+
   virtual Vector GetPosition (Ipv4Address adr) = 0;
   virtual Vector GetVelocity (Ipv4Address adr) = 0;
   virtual bool HasPosition (Ipv4Address adr) = 0;
   virtual bool IsInSearch (Ipv4Address adr) = 0;
+  /**
+   * \brief Start looking for the position of adr, if the service has to search for it
+   *
+   * Called by the routing protocol when a packet it originates has no
+   * destination position. The Get and Has methods never start a search.
+   * Services that know every position do nothing.
+   */
+  virtual void StartSearch (Ipv4Address adr);
 
   virtual void SetIpv4 (Ptr<Ipv4> ipv4) = 0;
   virtual Vector GetInvalidPosition () = 0;
@@ -50,9 +62,60 @@ public:
   virtual void Purge () = 0;
   virtual void Clear () = 0;
 
+  /**
+   * \brief Write the known positions, for a warm start of a later run
+   *
+   * One "ls ..." line per entry, with the entry age instead of its time.
+   * Services without state write nothing.
+   */
+  virtual void SaveState (std::ostream &os) const;
+  /**
+   * \brief Restore one entry written by SaveState
+   * \param is the rest of the line after "ls"; entry ages are counted back from now
+   */
+  virtual void RestoreState (std::istream &is);
+
 private:
   void Start ();
 };
+
+/**
+ * \brief Marks the packets sent by a location service
+ *
+ * Routing protocols carry them like any other packet, but do not count
+ * them as data in their traces.
+ */
+struct LocationServiceTag : public Tag
+{
+  static TypeId GetTypeId ()
+  {
+    static TypeId tid = TypeId ("ns3::LocationServiceTag").SetParent<Tag> ();
+    return tid;
+  }
+
+  TypeId  GetInstanceTypeId () const
+  {
+    return GetTypeId ();
+  }
+
+  uint32_t GetSerializedSize () const
+  {
+    return 0;
+  }
+
+  void  Serialize (TagBuffer i) const
+  {
+  }
+
+  void  Deserialize (TagBuffer i)
+  {
+  }
+
+  void  Print (std::ostream &os) const
+  {
+    os << "LocationServiceTag";
+  }
+};
 }
 #endif
 
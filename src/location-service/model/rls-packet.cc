@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "rls-packet.h"
+#include "ns3/address-utils.h"
+#include "ns3/packet.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("RlsPacket");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (RlsHeader);
+
+RlsHeader::RlsHeader (RlsMessageType type, uint32_t requestId, Ipv4Address origin,
+                      Ipv4Address target, uint8_t ttl, Vector position, Vector velocity,
+                      uint64_t timestamp)
+  : m_type (type),
+    m_valid (true),
+    m_requestId (requestId),
+    m_origin (origin),
+    m_target (target),
+    m_ttl (ttl),
+    m_position (position),
+    m_velocity (velocity),
+    m_timestamp (timestamp)
+{
+}
+
+TypeId
+RlsHeader::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::RlsHeader")
+    .SetParent<Header> ()
+    .AddConstructor<RlsHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+RlsHeader::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+RlsHeader::GetSerializedSize () const
+{
+  return 54;
+}
+
+void
+RlsHeader::Serialize (Buffer::Iterator i) const
+{
+  i.WriteU8 ((uint8_t) m_type);
+  i.WriteU8 (m_ttl);
+  i.WriteHtonU32 (m_requestId);
+  WriteTo (i, m_origin);
+  WriteTo (i, m_target);
+  i.WriteHtonU64 ((int64_t) m_position.x);
+  i.WriteHtonU64 ((int64_t) m_position.y);
+  i.WriteHtonU64 ((int64_t) m_velocity.x);
+  i.WriteHtonU64 ((int64_t) m_velocity.y);
+  i.WriteHtonU64 (m_timestamp);
+}
+
+uint32_t
+RlsHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint8_t type = i.ReadU8 ();
+  m_valid = true;
+  switch (type)
+    {
+    case RLSTYPE_REQUEST:
+    case RLSTYPE_REPLY:
+      {
+        m_type = (RlsMessageType) type;
+        break;
+      }
+    default:
+      m_valid = false;
+    }
+  m_ttl = i.ReadU8 ();
+  m_requestId = i.ReadNtohU32 ();
+  ReadFrom (i, m_origin);
+  ReadFrom (i, m_target);
+  m_position.x = (int64_t) i.ReadNtohU64 ();
+  m_position.y = (int64_t) i.ReadNtohU64 ();
+  m_velocity.x = (int64_t) i.ReadNtohU64 ();
+  m_velocity.y = (int64_t) i.ReadNtohU64 ();
+  m_position.z = 0;
+  m_velocity.z = 0;
+  m_timestamp = i.ReadNtohU64 ();
+
+  uint32_t dist = i.GetDistanceFrom (start);
+  NS_ASSERT (dist == GetSerializedSize ());
+  return dist;
+}
+
+void
+RlsHeader::Print (std::ostream &os) const
+{
+  os << (m_type == RLSTYPE_REQUEST ? "RLS-REQUEST" : "RLS-REPLY")
+     << " id: " << m_requestId
+     << " origin: " << m_origin
+     << " target: " << m_target
+     << " ttl: " << (uint16_t) m_ttl
+     << " position: " << m_position
+     << " velocity: " << m_velocity
+     << " timestamp: " << m_timestamp;
+}
+
+std::ostream &
+operator<< (std::ostream & os, RlsHeader const & h)
+{
+  h.Print (os);
+  return os;
+}
+
+bool
+RlsHeader::operator== (RlsHeader const & o) const
+{
+  return (m_type == o.m_type && m_requestId == o.m_requestId
+          && m_origin == o.m_origin && m_target == o.m_target && m_ttl == o.m_ttl
+          && m_position.x == o.m_position.x && m_position.y == o.m_position.y
+          && m_velocity.x == o.m_velocity.x && m_velocity.y == o.m_velocity.y
+          && m_timestamp == o.m_timestamp);
+}
+
+}
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef RLS_PACKET_H
+#define RLS_PACKET_H
+
+#include <iostream>
+#include "ns3/header.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+enum RlsMessageType
+{
+  RLSTYPE_REQUEST = 1,         //!< RLSTYPE_REQUEST
+  RLSTYPE_REPLY = 2,           //!< RLSTYPE_REPLY
+};
+
+/**
+ * \ingroup rls
+ * \brief Reactive Location Service request/reply header
+ *
+ * A request carries the position of its origin, so that every node on the
+ * flooding path learns it and the target can route the reply back. A reply
+ * carries the position of the target.
+ */
+class RlsHeader : public Header
+{
+public:
+  /// c-tor
+  RlsHeader (RlsMessageType type = RLSTYPE_REQUEST, uint32_t requestId = 0,
+             Ipv4Address origin = Ipv4Address (), Ipv4Address target = Ipv4Address (),
+             uint8_t ttl = 0, Vector position = Vector (), Vector velocity = Vector (),
+             uint64_t timestamp = 0);
+
+  ///\name Header serialization/deserialization
+  //\{
+  static TypeId GetTypeId ();
+  TypeId GetInstanceTypeId () const;
+  uint32_t GetSerializedSize () const;
+  void Serialize (Buffer::Iterator start) const;
+  uint32_t Deserialize (Buffer::Iterator start);
+  void Print (std::ostream &os) const;
+  //\}
+
+  ///\name Fields
+  //\{
+  void SetType (RlsMessageType type)
+  {
+    m_type = type;
+  }
+  RlsMessageType GetType () const
+  {
+    return m_type;
+  }
+  bool IsValid () const
+  {
+    return m_valid;
+  }
+  void SetRequestId (uint32_t id)
+  {
+    m_requestId = id;
+  }
+  uint32_t GetRequestId () const
+  {
+    return m_requestId;
+  }
+  void SetOrigin (Ipv4Address origin)
+  {
+    m_origin = origin;
+  }
+  Ipv4Address GetOrigin () const
+  {
+    return m_origin;
+  }
+  void SetTarget (Ipv4Address target)
+  {
+    m_target = target;
+  }
+  Ipv4Address GetTarget () const
+  {
+    return m_target;
+  }
+  void SetTtl (uint8_t ttl)
+  {
+    m_ttl = ttl;
+  }
+  uint8_t GetTtl () const
+  {
+    return m_ttl;
+  }
+  void SetPosition (Vector position)
+  {
+    m_position = position;
+  }
+  Vector GetPosition () const
+  {
+    return m_position;
+  }
+  void SetVelocity (Vector velocity)
+  {
+    m_velocity = velocity;
+  }
+  Vector GetVelocity () const
+  {
+    return m_velocity;
+  }
+  void SetTimestamp (uint64_t timestamp)
+  {
+    m_timestamp = timestamp;
+  }
+  uint64_t GetTimestamp () const
+  {
+    return m_timestamp;
+  }
+  //\}
+
+  bool operator== (RlsHeader const & o) const;
+private:
+  RlsMessageType   m_type;             ///< Request or reply
+  bool             m_valid;            ///< False if an unknown type was deserialized
+  uint32_t         m_requestId;        ///< Request id, unique per origin
+  Ipv4Address      m_origin;           ///< Node looking for the target
+  Ipv4Address      m_target;           ///< Node whose position is looked up
+  uint8_t          m_ttl;              ///< Remaining flooding hops
+  Vector           m_position;         ///< Origin position (request) or target position (reply)
+  Vector           m_velocity;         ///< Velocity matching m_position
+  uint64_t         m_timestamp;        ///< Time m_position was sampled, ms
+};
+
+std::ostream & operator<< (std::ostream & os, RlsHeader const &);
+
+}
+#endif /* RLS_PACKET_H */
@@ -0,0 +1,518 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#define NS_LOG_APPEND_CONTEXT                                   \
+  if (m_ipv4) { std::clog << "[node " << m_ipv4->GetObject<Node> ()->GetId () << "] "; }
+
+#include "rls.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/random-variable.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/trace-source-accessor.h"
+
+NS_LOG_COMPONENT_DEFINE ("ReactiveLocationService");
+
+namespace ns3
+{
+NS_OBJECT_ENSURE_REGISTERED (ReactiveLocationService);
+
+/// UDP Port for RLS control traffic, not defined by IANA yet
+const uint32_t ReactiveLocationService::RLS_PORT = 667;
+
+TypeId
+ReactiveLocationService::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ReactiveLocationService")
+    .SetParent<LocationService> ()
+    .AddConstructor<ReactiveLocationService> ()
+    .AddAttribute ("EntryLifeTime", "Time a learnt position is considered valid.",
+                   TimeValue (Seconds (5)),
+                   MakeTimeAccessor (&ReactiveLocationService::m_entryLifeTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("RequestTimeout", "Time to wait for a reply before repeating a request.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&ReactiveLocationService::m_requestTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxRetries", "Number of times a request is repeated before the search is given up.",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&ReactiveLocationService::m_maxRetries),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxHops", "Maximum number of hops a request is flooded.",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&ReactiveLocationService::m_maxHops),
+                   MakeUintegerChecker<uint8_t> (1))
+    .AddAttribute ("MaxJitter", "Maximum random delay before a request is rebroadcast.",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&ReactiveLocationService::m_maxJitter),
+                   MakeTimeChecker ())
+    .AddTraceSource ("LookupSuccess",
+                     "A position reply arrived; target and lookup latency",
+                     MakeTraceSourceAccessor (&ReactiveLocationService::m_lookupSuccessTrace))
+    .AddTraceSource ("LookupFailure",
+                     "A search was given up without reply",
+                     MakeTraceSourceAccessor (&ReactiveLocationService::m_lookupFailureTrace))
+  ;
+  return tid;
+}
+
+ReactiveLocationService::ReactiveLocationService ()
+  : m_requestId (0),
+    m_entryLifeTime (Seconds (5)),
+    m_requestTimeout (Seconds (1)),
+    m_maxRetries (2),
+    m_maxHops (16),
+    m_maxJitter (MilliSeconds (10))
+{
+}
+
+ReactiveLocationService::~ReactiveLocationService ()
+{
+}
+
+void
+ReactiveLocationService::DoDispose ()
+{
+  m_purgeEvent.Cancel ();
+  Clear ();
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::iterator i = m_socketAddresses.begin ();
+       i != m_socketAddresses.end (); ++i)
+    {
+      i->first->Close ();
+    }
+  m_socketAddresses.clear ();
+  m_mobility = 0;
+  m_ipv4 = 0;
+  LocationService::DoDispose ();
+}
+
+void
+ReactiveLocationService::SetIpv4 (Ptr<Ipv4> ipv4)
+{
+  NS_ASSERT (ipv4 != 0);
+  NS_ASSERT (m_ipv4 == 0);
+  m_ipv4 = ipv4;
+  m_mobility = m_ipv4->GetObject<MobilityModel> ();
+  Start ();
+}
+
+void
+ReactiveLocationService::Start ()
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t interface = 0; interface < m_ipv4->GetNInterfaces (); interface++)
+    {
+      if (!m_ipv4->IsUp (interface) || m_ipv4->GetNAddresses (interface) == 0)
+        {
+          continue;
+        }
+      Ipv4InterfaceAddress iface = m_ipv4->GetAddress (interface, 0);
+      if (iface.GetLocal () == Ipv4Address::GetLoopback ())
+        {
+          continue;
+        }
+      // Create a socket to listen only on this interface
+      Ptr<Socket> socket = Socket::CreateSocket (m_ipv4->GetObject<Node> (),
+                                                 UdpSocketFactory::GetTypeId ());
+      NS_ASSERT (socket != 0);
+      socket->SetRecvCallback (MakeCallback (&ReactiveLocationService::Recv, this));
+      socket->BindToNetDevice (m_ipv4->GetNetDevice (interface));
+      socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), RLS_PORT));
+      socket->SetAllowBroadcast (true);
+      m_socketAddresses.insert (std::make_pair (socket, iface));
+    }
+  m_purgeEvent = Simulator::Schedule (m_entryLifeTime, &ReactiveLocationService::PurgeTimerExpire, this);
+}
+
+void
+ReactiveLocationService::PurgeTimerExpire ()
+{
+  Purge ();
+  m_purgeEvent = Simulator::Schedule (m_entryLifeTime, &ReactiveLocationService::PurgeTimerExpire, this);
+}
+
+bool
+ReactiveLocationService::IsMyOwnAddress (Ipv4Address adr) const
+{
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
+         m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+    {
+      if (adr == j->second.GetLocal ())
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+ReactiveLocationService::IsSearchable (Ipv4Address adr) const
+{
+  if (m_ipv4 == 0 || adr.IsBroadcast () || adr.IsMulticast ()
+      || adr == Ipv4Address::GetZero () || adr == Ipv4Address::GetLoopback ())
+    {
+      return false;
+    }
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
+         m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+    {
+      if (adr == j->second.GetLocal () || adr == j->second.GetBroadcast ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+const ReactiveLocationService::Entry *
+ReactiveLocationService::FindValid (Ipv4Address adr) const
+{
+  std::map<Ipv4Address, Entry>::const_iterator i = m_table.find (adr);
+  if (i == m_table.end () || i->second.updated + m_entryLifeTime <= Simulator::Now ())
+    {
+      return 0;
+    }
+  return &i->second;
+}
+
+Vector
+ReactiveLocationService::GetPosition (Ipv4Address adr)
+{
+  if (IsMyOwnAddress (adr))
+    {
+      return m_mobility->GetPosition ();
+    }
+  const Entry *entry = FindValid (adr);
+  if (entry != 0)
+    {
+      return entry->pos;
+    }
+  return GetInvalidPosition ();
+}
+
+Vector
+ReactiveLocationService::GetVelocity (Ipv4Address adr)
+{
+  if (IsMyOwnAddress (adr))
+    {
+      return m_mobility->GetVelocity ();
+    }
+  const Entry *entry = FindValid (adr);
+  if (entry != 0)
+    {
+      return entry->vel;
+    }
+  return Vector ();
+}
+
+bool
+ReactiveLocationService::HasPosition (Ipv4Address adr)
+{
+  return FindValid (adr) != 0;
+}
+
+bool
+ReactiveLocationService::IsInSearch (Ipv4Address adr)
+{
+  return m_searches.find (adr) != m_searches.end ();
+}
+
+Vector
+ReactiveLocationService::GetInvalidPosition ()
+{
+  return Vector (-1, -1, 0);
+}
+
+Time
+ReactiveLocationService::GetEntryUpdateTime (Ipv4Address id)
+{
+  std::map<Ipv4Address, Entry>::const_iterator i = m_table.find (id);
+  if (i == m_table.end ())
+    {
+      return Time (Seconds (0));
+    }
+  return i->second.updated;
+}
+
+void
+ReactiveLocationService::UpdateEntry (Ipv4Address id, Vector position, Vector velocity, Time updated)
+{
+  std::map<Ipv4Address, Entry>::iterator i = m_table.find (id);
+  if (i != m_table.end () && i->second.updated > updated)
+    {
+      return; // we already know a newer position
+    }
+  Entry &entry = m_table[id];
+  entry.pos = position;
+  entry.vel = velocity;
+  entry.updated = updated;
+}
+
+void
+ReactiveLocationService::AddEntry (Ipv4Address id, Vector position)
+{
+  UpdateEntry (id, position, GetVelocity (id), Simulator::Now ());
+}
+
+void
+ReactiveLocationService::DeleteEntry (Ipv4Address id)
+{
+  m_table.erase (id);
+}
+
+void
+ReactiveLocationService::Purge ()
+{
+  Time now = Simulator::Now ();
+  for (std::map<Ipv4Address, Entry>::iterator i = m_table.begin (); i != m_table.end (); )
+    {
+      if (i->second.updated + m_entryLifeTime <= now)
+        {
+          m_table.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+  // A request can not be seen again once all of its retries are over
+  Time seenLifeTime = m_requestTimeout * (m_maxRetries + 1);
+  for (std::map<std::pair<Ipv4Address, uint32_t>, Time>::iterator i = m_seenRequests.begin ();
+       i != m_seenRequests.end (); )
+    {
+      if (i->second + seenLifeTime <= now)
+        {
+          m_seenRequests.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+}
+
+void
+ReactiveLocationService::Clear ()
+{
+  for (std::map<Ipv4Address, Search>::iterator i = m_searches.begin (); i != m_searches.end (); ++i)
+    {
+      i->second.timeout.Cancel ();
+    }
+  m_searches.clear ();
+  m_seenRequests.clear ();
+  m_table.clear ();
+}
+
+void
+ReactiveLocationService::SaveState (std::ostream &os) const
+{
+  Time now = Simulator::Now ();
+  for (std::map<Ipv4Address, Entry>::const_iterator i = m_table.begin (); i != m_table.end (); ++i)
+    {
+      const Entry &e = i->second;
+      os << "ls " << i->first
+         << " " << e.pos.x << " " << e.pos.y << " " << e.pos.z
+         << " " << e.vel.x << " " << e.vel.y << " " << e.vel.z
+         << " " << (now - e.updated).GetNanoSeconds () << std::endl;
+    }
+}
+
+void
+ReactiveLocationService::RestoreState (std::istream &is)
+{
+  std::string addr;
+  Vector pos, vel;
+  int64_t age;
+  if (!(is >> addr >> pos.x >> pos.y >> pos.z >> vel.x >> vel.y >> vel.z >> age))
+    {
+      NS_LOG_WARN ("Malformed location entry in saved state");
+      return;
+    }
+  UpdateEntry (Ipv4Address (addr.c_str ()), pos, vel, Simulator::Now () - NanoSeconds (age));
+}
+
+void
+ReactiveLocationService::StartSearch (Ipv4Address adr)
+{
+  if (!IsSearchable (adr) || IsInSearch (adr) || FindValid (adr) != 0)
+    {
+      return;
+    }
+  NS_LOG_LOGIC ("Start search for " << adr);
+  Purge ();
+  Search search;
+  search.retries = 0;
+  search.started = Simulator::Now ();
+  m_searches[adr] = search;
+  SendRequest (adr);
+}
+
+void
+ReactiveLocationService::SendRequest (Ipv4Address adr)
+{
+  Search &search = m_searches[adr];
+  search.requestId = ++m_requestId;
+  // One request per interface, so that the reply comes back to the interface it was asked from
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
+         m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+    {
+      Ipv4Address origin = j->second.GetLocal ();
+      m_seenRequests[std::make_pair (origin, search.requestId)] = Simulator::Now ();
+
+      RlsHeader header (RLSTYPE_REQUEST, search.requestId, origin, adr, m_maxHops,
+                        m_mobility->GetPosition (), m_mobility->GetVelocity (),
+                        Simulator::Now ().GetMilliSeconds ());
+      Ptr<Packet> packet = Create<Packet> ();
+      packet->AddHeader (header);
+      SendBroadcast (j->first, packet);
+    }
+
+  search.timeout = Simulator::Schedule (m_requestTimeout, &ReactiveLocationService::RequestTimerExpire, this, adr);
+}
+
+void
+ReactiveLocationService::RequestTimerExpire (Ipv4Address adr)
+{
+  std::map<Ipv4Address, Search>::iterator i = m_searches.find (adr);
+  if (i == m_searches.end ())
+    {
+      return;
+    }
+  if (i->second.retries < m_maxRetries)
+    {
+      i->second.retries++;
+      NS_LOG_LOGIC ("Retry " << i->second.retries << " of search for " << adr);
+      SendRequest (adr);
+      return;
+    }
+  NS_LOG_LOGIC ("Search for " << adr << " failed");
+  m_searches.erase (i);
+  m_lookupFailureTrace (adr);
+}
+
+void
+ReactiveLocationService::Broadcast (Ptr<Packet> packet)
+{
+  for (std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j =
+         m_socketAddresses.begin (); j != m_socketAddresses.end (); ++j)
+    {
+      SendBroadcast (j->first, packet->Copy ());
+    }
+}
+
+void
+ReactiveLocationService::SendBroadcast (Ptr<Socket> socket, Ptr<Packet> packet)
+{
+  std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator j = m_socketAddresses.find (socket);
+  NS_ASSERT (j != m_socketAddresses.end ());
+  Ipv4InterfaceAddress iface = j->second;
+  // Send to all-hosts broadcast if on /32 addr, subnet-directed otherwise
+  Ipv4Address destination;
+  if (iface.GetMask () == Ipv4Mask::GetOnes ())
+    {
+      destination = Ipv4Address ("255.255.255.255");
+    }
+  else
+    {
+      destination = iface.GetBroadcast ();
+    }
+  // Forwarded requests keep the tag of the origin
+  LocationServiceTag tag;
+  if (!packet->PeekPacketTag (tag))
+    {
+      packet->AddPacketTag (tag);
+    }
+  socket->SendTo (packet, 0, InetSocketAddress (destination, RLS_PORT));
+}
+
+void
+ReactiveLocationService::SendReply (Ptr<Socket> socket, RlsHeader const & request)
+{
+  NS_LOG_LOGIC ("Reply to " << request.GetOrigin () << " request " << request.GetRequestId ());
+  RlsHeader header (RLSTYPE_REPLY, request.GetRequestId (), request.GetOrigin (), request.GetTarget (), 0,
+                    m_mobility->GetPosition (), m_mobility->GetVelocity (),
+                    Simulator::Now ().GetMilliSeconds ());
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (header);
+  packet->AddPacketTag (LocationServiceTag ());
+  socket->SendTo (packet, 0, InetSocketAddress (request.GetOrigin (), RLS_PORT));
+}
+
+void
+ReactiveLocationService::Recv (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  Address sourceAddress;
+  Ptr<Packet> packet = socket->RecvFrom (sourceAddress);
+
+  RlsHeader header;
+  packet->RemoveHeader (header);
+  if (!header.IsValid ())
+    {
+      NS_LOG_DEBUG ("RLS message " << packet->GetUid () << " with unknown type received. Ignored");
+      return;
+    }
+  switch (header.GetType ())
+    {
+    case RLSTYPE_REQUEST:
+      RecvRequest (socket, header);
+      break;
+    case RLSTYPE_REPLY:
+      RecvReply (header);
+      break;
+    }
+}
+
+void
+ReactiveLocationService::RecvRequest (Ptr<Socket> socket, RlsHeader request)
+{
+  std::pair<Ipv4Address, uint32_t> key = std::make_pair (request.GetOrigin (), request.GetRequestId ());
+  if (m_seenRequests.find (key) != m_seenRequests.end ())
+    {
+      return;
+    }
+  m_seenRequests[key] = Simulator::Now ();
+
+  // Every node on the flooding path learns where the origin is, the target needs it to reply
+  UpdateEntry (request.GetOrigin (), request.GetPosition (), request.GetVelocity (),
+               MilliSeconds (request.GetTimestamp ()));
+
+  if (IsMyOwnAddress (request.GetTarget ()))
+    {
+      SendReply (socket, request);
+      return;
+    }
+  if (request.GetTtl () <= 1)
+    {
+      return;
+    }
+  request.SetTtl (request.GetTtl () - 1);
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (request);
+  Time jitter = Seconds (UniformVariable ().GetValue (0, m_maxJitter.GetSeconds ()));
+  Simulator::Schedule (jitter, &ReactiveLocationService::Broadcast, this, packet);
+}
+
+void
+ReactiveLocationService::RecvReply (RlsHeader const & reply)
+{
+  if (!IsMyOwnAddress (reply.GetOrigin ()))
+    {
+      return;
+    }
+  UpdateEntry (reply.GetTarget (), reply.GetPosition (), reply.GetVelocity (),
+               MilliSeconds (reply.GetTimestamp ()));
+
+  std::map<Ipv4Address, Search>::iterator i = m_searches.find (reply.GetTarget ());
+  if (i == m_searches.end ())
+    {
+      return; // reply to a request that was already answered
+    }
+  Time latency = Simulator::Now () - i->second.started;
+  NS_LOG_LOGIC ("Found " << reply.GetTarget () << " at " << reply.GetPosition () << " after " << latency.GetSeconds () << " s");
+  i->second.timeout.Cancel ();
+  m_searches.erase (i);
+  m_lookupSuccessTrace (reply.GetTarget (), latency);
+}
+
+}
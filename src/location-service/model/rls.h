@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef REACTIVE_LOCATION_SERVICE_H
+#define REACTIVE_LOCATION_SERVICE_H
+
+#include "ns3/location-service.h"
+#include "ns3/rls-packet.h"
+#include "ns3/socket.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
+#include "ns3/mobility-model.h"
+#include <map>
+
+namespace ns3
+{
+/**
+ * \ingroup rls
+ *
+ * \brief Reactive Location Service
+ *
+ * Each node keeps a cache of known positions. When the routing protocol
+ * starts a search for a position that is not (or no longer) cached, a
+ * request carrying the position of the asking node is flooded up to MaxHops
+ * hops on every interface. The target answers with a unicast reply, routed
+ * by the position learnt from the request, from the interface the request
+ * arrived on. Requests are retried MaxRetries times, RequestTimeout apart,
+ * before the search is given up. While a search runs IsInSearch is true, so
+ * GPSR keeps the packets in its deferred queue. Expired entries and handled
+ * requests are purged every EntryLifeTime.
+ */
+class ReactiveLocationService : public LocationService
+{
+public:
+  static TypeId GetTypeId (void);
+  /// UDP port of the location service messages
+  static const uint32_t RLS_PORT;
+
+  /// c-tor
+  ReactiveLocationService ();
+  virtual ~ReactiveLocationService ();
+  virtual void DoDispose ();
+  Vector GetPosition (Ipv4Address adr);
+  Vector GetVelocity (Ipv4Address adr);
+  bool HasPosition (Ipv4Address adr);
+  bool IsInSearch (Ipv4Address adr);
+  virtual void StartSearch (Ipv4Address adr);
+
+  void SetIpv4 (Ptr<Ipv4> ipv4);
+  Vector GetInvalidPosition ();
+  Time GetEntryUpdateTime (Ipv4Address id);
+  void AddEntry (Ipv4Address id, Vector position);
+  void DeleteEntry (Ipv4Address id);
+
+  void Purge ();
+  virtual void Clear ();
+
+  virtual void SaveState (std::ostream &os) const;
+  virtual void RestoreState (std::istream &is);
+
+private:
+  struct Entry
+  {
+    Vector pos;
+    Vector vel;
+    Time updated;
+  };
+
+  struct Search
+  {
+    uint32_t requestId;
+    uint32_t retries;
+    Time started;
+    EventId timeout;
+  };
+
+  /// Start protocol operation
+  void Start ();
+  /// Purge the tables and schedule the next purge
+  void PurgeTimerExpire ();
+  /// Returns false for addresses that can not be looked up (broadcast, own, ...)
+  bool IsSearchable (Ipv4Address adr) const;
+  /// Returns the cache entry of adr if it is still fresh, 0 otherwise
+  const Entry * FindValid (Ipv4Address adr) const;
+  void UpdateEntry (Ipv4Address id, Vector position, Vector velocity, Time updated);
+  void SendRequest (Ipv4Address adr);
+  void RequestTimerExpire (Ipv4Address adr);
+  void SendReply (Ptr<Socket> socket, RlsHeader const & request);
+  /// Send packet to the broadcast address of every interface
+  void Broadcast (Ptr<Packet> packet);
+  void SendBroadcast (Ptr<Socket> socket, Ptr<Packet> packet);
+  void Recv (Ptr<Socket> socket);
+  void RecvRequest (Ptr<Socket> socket, RlsHeader request);
+  void RecvReply (RlsHeader const & reply);
+  /// Returns true if adr is the address of one of the interfaces of this node
+  bool IsMyOwnAddress (Ipv4Address adr) const;
+
+  Ptr<Ipv4> m_ipv4;
+  /// Raw socket per each IP interface, map socket -> iface address (IP + mask)
+  std::map<Ptr<Socket>, Ipv4InterfaceAddress> m_socketAddresses;
+  Ptr<MobilityModel> m_mobility;
+
+  std::map<Ipv4Address, Entry> m_table;
+  std::map<Ipv4Address, Search> m_searches;
+  /// (origin, request id) of requests already handled -> time seen
+  std::map<std::pair<Ipv4Address, uint32_t>, Time> m_seenRequests;
+  uint32_t m_requestId;
+  EventId m_purgeEvent;
+
+  Time m_entryLifeTime;
+  Time m_requestTimeout;
+  uint32_t m_maxRetries;
+  uint8_t m_maxHops;
+  Time m_maxJitter;
+
+  /// Fired with the target and the time since the first request when a reply arrives
+  TracedCallback<Ipv4Address, Time> m_lookupSuccessTrace;
+  /// Fired with the target when the last retry of a search times out
+  TracedCallback<Ipv4Address> m_lookupFailureTrace;
+};
+}
+#endif /* REACTIVE_LOCATION_SERVICE_H */
@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/cached-location-service.h"
+#include "ns3/simulator.h"
+#include "ns3/nstime.h"
+
+using namespace ns3;
+
+/// Backend with one fixed entry whose fix can be changed by the test
+class FixedLocationService : public LocationService
+{
+public:
+  FixedLocationService ()
+    : m_lookups (0)
+  {
+  }
+
+  void Set (Vector pos, Vector vel, Time updated)
+  {
+    m_pos = pos;
+    m_vel = vel;
+    m_updated = updated;
+  }
+
+  Vector GetPosition (Ipv4Address adr)
+  {
+    m_lookups++;
+    return m_pos;
+  }
+  Vector GetVelocity (Ipv4Address adr)
+  {
+    return m_vel;
+  }
+  bool HasPosition (Ipv4Address adr)
+  {
+    return true;
+  }
+  bool IsInSearch (Ipv4Address adr)
+  {
+    return false;
+  }
+  void SetIpv4 (Ptr<Ipv4> ipv4)
+  {
+  }
+  Vector GetInvalidPosition ()
+  {
+    return Vector (-1, -1, 0);
+  }
+  Time GetEntryUpdateTime (Ipv4Address id)
+  {
+    return m_updated;
+  }
+  void AddEntry (Ipv4Address id, Vector position)
+  {
+  }
+  void DeleteEntry (Ipv4Address id)
+  {
+  }
+  void Purge ()
+  {
+  }
+  void Clear ()
+  {
+  }
+
+  /// Number of GetPosition calls, i.e. cache misses
+  uint32_t m_lookups;
+
+private:
+  Vector m_pos;
+  Vector m_vel;
+  Time m_updated;
+};
+
+/// Cached positions are dead-reckoned from the backend fix and refetched once stale
+class CachedPredictionTest : public TestCase
+{
+public:
+  CachedPredictionTest ();
+  virtual void DoRun (void);
+
+private:
+  void Check (double x, uint32_t lookups);
+
+  Ptr<FixedLocationService> m_backend;
+  Ptr<CachedLocationService> m_cache;
+  Ipv4Address m_target;
+};
+
+CachedPredictionTest::CachedPredictionTest ()
+  : TestCase ("Cached location service prediction and refresh"),
+    m_target ("10.1.1.2")
+{
+}
+
+void
+CachedPredictionTest::Check (double x, uint32_t lookups)
+{
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_cache->GetPosition (m_target).x, x, 1e-9,
+                             "Predicted position at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ (m_backend->m_lookups, lookups, "Backend lookups at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+CachedPredictionTest::DoRun (void)
+{
+  m_backend = CreateObject<FixedLocationService> ();
+  m_backend->Set (Vector (0, 0, 0), Vector (10, 0, 0), Seconds (0));
+  m_cache = CreateObject<CachedLocationService> ();
+  m_cache->SetAttribute ("EntryLifeTime", TimeValue (Seconds (1)));
+  m_cache->SetAttribute ("MaxPredictionAge", TimeValue (Seconds (2)));
+  m_cache->SetBackend (m_backend);
+
+  // fetched at 0.5 s, extrapolated from the fix at 0 s
+  Simulator::Schedule (Seconds (0.5), &CachedPredictionTest::Check, this, 5, 1);
+  Simulator::Schedule (Seconds (0.9), &CachedPredictionTest::Check, this, 9, 1);
+  // the backend gets a new fix, the cache keeps serving the old one until 1.5 s
+  Simulator::Schedule (Seconds (0.95), &FixedLocationService::Set, m_backend,
+                       Vector (100, 0, 0), Vector (10, 0, 0), Seconds (0.9));
+  Simulator::Schedule (Seconds (1.2), &CachedPredictionTest::Check, this, 12, 1);
+  Simulator::Schedule (Seconds (1.6), &CachedPredictionTest::Check, this, 107, 2);
+  // refetched again, the extrapolation stops after MaxPredictionAge
+  Simulator::Schedule (Seconds (4), &CachedPredictionTest::Check, this, 120, 3);
+  // a local entry takes its velocity from the backend
+  Simulator::Schedule (Seconds (4.1), &CachedLocationService::AddEntry, m_cache, m_target, Vector (50, 0, 0));
+  Simulator::Schedule (Seconds (4.6), &CachedPredictionTest::Check, this, 55, 3);
+  Simulator::Run ();
+
+  m_cache->Dispose ();
+  m_cache = 0;
+  m_backend = 0;
+  Simulator::Destroy ();
+}
+
+class CachedLocationServiceTestSuite : public TestSuite
+{
+public:
+  CachedLocationServiceTestSuite ();
+};
+
+CachedLocationServiceTestSuite::CachedLocationServiceTestSuite ()
+  : TestSuite ("location-service-cache", UNIT)
+{
+  AddTestCase (new CachedPredictionTest, TestCase::QUICK);
+}
+
+static CachedLocationServiceTestSuite g_cachedLocationServiceTestSuite;
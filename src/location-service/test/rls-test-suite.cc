@@ -0,0 +1,305 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/rls.h"
+#include "ns3/rls-packet.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/uinteger.h"
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+/// n nodes 100 m apart on one shared channel, addressed 10.1.1.1, 10.1.1.2, ...
+static NodeContainer
+CreateLan (uint32_t n)
+{
+  NodeContainer nodes;
+  nodes.Create (n);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes.Get (i)->AddDevice (device);
+      devices.Add (device);
+
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (100 * i, 0, 0));
+      nodes.Get (i)->AggregateObject (mobility);
+    }
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (devices);
+  return nodes;
+}
+
+static Ptr<ReactiveLocationService>
+CreateRls (Ptr<Node> node)
+{
+  Ptr<ReactiveLocationService> rls = CreateObject<ReactiveLocationService> ();
+  rls->SetAttribute ("RequestTimeout", TimeValue (Seconds (1)));
+  rls->SetAttribute ("MaxRetries", UintegerValue (2));
+  rls->SetAttribute ("EntryLifeTime", TimeValue (Seconds (2)));
+  rls->SetIpv4 (node->GetObject<Ipv4> ());
+  return rls;
+}
+
+/// A request is flooded, the target replies and the origin caches its position
+class RlsRequestReplyTest : public TestCase
+{
+public:
+  RlsRequestReplyTest ();
+  virtual void DoRun (void);
+
+private:
+  void LookupSuccess (Ipv4Address target, Time latency);
+  void LookupFailure (Ipv4Address target);
+
+  uint32_t m_successes;
+  uint32_t m_failures;
+  Ipv4Address m_found;
+};
+
+RlsRequestReplyTest::RlsRequestReplyTest ()
+  : TestCase ("RLS request and reply"),
+    m_successes (0),
+    m_failures (0)
+{
+}
+
+void
+RlsRequestReplyTest::LookupSuccess (Ipv4Address target, Time latency)
+{
+  m_successes++;
+  m_found = target;
+  NS_TEST_EXPECT_MSG_LT (latency, Seconds (1), "Reply before the first retry");
+}
+
+void
+RlsRequestReplyTest::LookupFailure (Ipv4Address target)
+{
+  m_failures++;
+}
+
+void
+RlsRequestReplyTest::DoRun (void)
+{
+  NodeContainer nodes = CreateLan (3);
+  Ptr<ReactiveLocationService> origin = CreateRls (nodes.Get (0));
+  Ptr<ReactiveLocationService> relay = CreateRls (nodes.Get (1));
+  Ptr<ReactiveLocationService> target = CreateRls (nodes.Get (2));
+  origin->TraceConnectWithoutContext ("LookupSuccess", MakeCallback (&RlsRequestReplyTest::LookupSuccess, this));
+  origin->TraceConnectWithoutContext ("LookupFailure", MakeCallback (&RlsRequestReplyTest::LookupFailure, this));
+
+  Ipv4Address originAddress ("10.1.1.1");
+  Ipv4Address targetAddress ("10.1.1.3");
+  NS_TEST_EXPECT_MSG_EQ_TOL (origin->GetPosition (originAddress).x, 0, 1e-9, "Own position");
+  NS_TEST_EXPECT_MSG_EQ_TOL (origin->GetPosition (targetAddress).x, -1, 1e-9, "Unknown position");
+  NS_TEST_EXPECT_MSG_EQ (origin->IsInSearch (targetAddress), false, "GetPosition does not search");
+  origin->StartSearch (Ipv4Address ("10.1.1.255"));
+  origin->StartSearch (originAddress);
+  NS_TEST_EXPECT_MSG_EQ (origin->IsInSearch (Ipv4Address ("10.1.1.255")), false, "Broadcast is not searched");
+  NS_TEST_EXPECT_MSG_EQ (origin->IsInSearch (originAddress), false, "Own address is not searched");
+
+  Simulator::Schedule (Seconds (1), &ReactiveLocationService::StartSearch, origin, targetAddress);
+  Simulator::Stop (Seconds (1.5));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_successes, 1, "One reply");
+  NS_TEST_EXPECT_MSG_EQ (m_failures, 0, "No failure");
+  NS_TEST_EXPECT_MSG_EQ (m_found, targetAddress, "Reply from the target");
+  NS_TEST_EXPECT_MSG_EQ (origin->IsInSearch (targetAddress), false, "Search over");
+  NS_TEST_EXPECT_MSG_EQ (origin->HasPosition (targetAddress), true, "Target cached");
+  NS_TEST_EXPECT_MSG_EQ_TOL (origin->GetPosition (targetAddress).x, 200, 1e-9, "Target position");
+  NS_TEST_EXPECT_MSG_EQ (relay->HasPosition (originAddress), true, "Relay learnt the origin");
+  NS_TEST_EXPECT_MSG_EQ (target->HasPosition (originAddress), true, "Target learnt the origin");
+  NS_TEST_EXPECT_MSG_EQ (relay->HasPosition (targetAddress), false, "Reply is unicast");
+
+  origin->Dispose ();
+  relay->Dispose ();
+  target->Dispose ();
+  Simulator::Destroy ();
+}
+
+/// An unanswered request is repeated MaxRetries times, RequestTimeout apart, then given up
+class RlsRetryTest : public TestCase
+{
+public:
+  RlsRetryTest ();
+  virtual void DoRun (void);
+
+private:
+  void Receive (Ptr<Socket> socket);
+  void LookupFailure (Ipv4Address target);
+  void CheckInSearch (bool inSearch);
+
+  Ptr<ReactiveLocationService> m_rls;
+  std::vector<Time> m_requests;
+  std::vector<Time> m_failures;
+};
+
+RlsRetryTest::RlsRetryTest ()
+  : TestCase ("RLS request retries")
+{
+}
+
+void
+RlsRetryTest::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> packet;
+  while ((packet = socket->Recv ()))
+    {
+      RlsHeader header;
+      packet->RemoveHeader (header);
+      NS_TEST_EXPECT_MSG_EQ (header.GetType (), RLSTYPE_REQUEST, "Only requests");
+      NS_TEST_EXPECT_MSG_EQ (header.GetOrigin (), Ipv4Address ("10.1.1.1"), "Origin from the sending interface");
+      NS_TEST_EXPECT_MSG_EQ (header.GetTarget (), Ipv4Address ("10.1.1.9"), "Target");
+      NS_TEST_EXPECT_MSG_EQ (header.GetRequestId (), m_requests.size () + 1, "A new id per retry");
+      m_requests.push_back (Simulator::Now ());
+    }
+}
+
+void
+RlsRetryTest::LookupFailure (Ipv4Address target)
+{
+  m_failures.push_back (Simulator::Now ());
+}
+
+void
+RlsRetryTest::CheckInSearch (bool inSearch)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_rls->IsInSearch (Ipv4Address ("10.1.1.9")), inSearch,
+                         "In search at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+RlsRetryTest::DoRun (void)
+{
+  NodeContainer nodes = CreateLan (2);
+  m_rls = CreateRls (nodes.Get (0));
+  m_rls->TraceConnectWithoutContext ("LookupFailure", MakeCallback (&RlsRetryTest::LookupFailure, this));
+
+  // The second node only listens
+  Ptr<Socket> listener = Socket::CreateSocket (nodes.Get (1), UdpSocketFactory::GetTypeId ());
+  listener->Bind (InetSocketAddress (Ipv4Address::GetAny (), ReactiveLocationService::RLS_PORT));
+  listener->SetRecvCallback (MakeCallback (&RlsRetryTest::Receive, this));
+
+  Ipv4Address missing ("10.1.1.9");
+  Simulator::Schedule (Seconds (0.5), &ReactiveLocationService::StartSearch, m_rls, missing);
+  // Already in search, no new request
+  Simulator::Schedule (Seconds (1), &ReactiveLocationService::StartSearch, m_rls, missing);
+  Simulator::Schedule (Seconds (3.4), &RlsRetryTest::CheckInSearch, this, true);
+  Simulator::Schedule (Seconds (3.6), &RlsRetryTest::CheckInSearch, this, false);
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_requests.size (), 3, "First request and two retries");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_requests[0].GetSeconds (), 0.5, 0.01, "First request");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_requests[1].GetSeconds (), 1.5, 0.01, "First retry");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_requests[2].GetSeconds (), 2.5, 0.01, "Second retry");
+  NS_TEST_ASSERT_MSG_EQ (m_failures.size (), 1, "Search given up once");
+  NS_TEST_EXPECT_MSG_EQ (m_failures[0], Seconds (3.5), "After the last timeout");
+  NS_TEST_EXPECT_MSG_EQ (m_rls->HasPosition (missing), false, "Nothing learnt");
+
+  listener->Close ();
+  m_rls->Dispose ();
+  m_rls = 0;
+  Simulator::Destroy ();
+}
+
+/// Cached positions are valid for EntryLifeTime, reading them never starts a search
+class RlsCacheTest : public TestCase
+{
+public:
+  RlsCacheTest ();
+  virtual void DoRun (void);
+
+private:
+  void Restore ();
+  void Check (bool valid);
+  void CheckSearch (bool started);
+
+  Ptr<ReactiveLocationService> m_rls;
+  Ipv4Address m_known;
+};
+
+RlsCacheTest::RlsCacheTest ()
+  : TestCase ("RLS cache entry lifetime"),
+    m_known ("10.1.1.7")
+{
+}
+
+void
+RlsCacheTest::Restore ()
+{
+  std::istringstream is ("10.1.1.7 30 40 0 5 0 0 0");
+  m_rls->RestoreState (is);
+}
+
+void
+RlsCacheTest::Check (bool valid)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_rls->HasPosition (m_known), valid, "Valid at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_rls->GetPosition (m_known).x, valid ? 30 : -1, 1e-9,
+                             "Position at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_rls->GetVelocity (m_known).x, valid ? 5 : 0, 1e-9,
+                             "Velocity at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ (m_rls->GetEntryUpdateTime (m_known), Seconds (1), "Update time");
+  NS_TEST_EXPECT_MSG_EQ (m_rls->IsInSearch (m_known), false, "No search at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+RlsCacheTest::CheckSearch (bool started)
+{
+  m_rls->StartSearch (m_known);
+  NS_TEST_EXPECT_MSG_EQ (m_rls->IsInSearch (m_known), started, "Search at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+RlsCacheTest::DoRun (void)
+{
+  NodeContainer nodes = CreateLan (1);
+  m_rls = CreateRls (nodes.Get (0));
+
+  Simulator::Schedule (Seconds (1), &RlsCacheTest::Restore, this);
+  Simulator::Schedule (Seconds (2.9), &RlsCacheTest::Check, this, true);
+  Simulator::Schedule (Seconds (2.95), &RlsCacheTest::CheckSearch, this, false);
+  Simulator::Schedule (Seconds (3.1), &RlsCacheTest::Check, this, false);
+  Simulator::Schedule (Seconds (3.2), &RlsCacheTest::CheckSearch, this, true);
+  Simulator::Stop (Seconds (4));
+  Simulator::Run ();
+
+  m_rls->Dispose ();
+  m_rls = 0;
+  Simulator::Destroy ();
+}
+
+class RlsTestSuite : public TestSuite
+{
+public:
+  RlsTestSuite ();
+};
+
+RlsTestSuite::RlsTestSuite ()
+  : TestSuite ("location-service-rls", UNIT)
+{
+  AddTestCase (new RlsRequestReplyTest, TestCase::QUICK);
+  AddTestCase (new RlsRetryTest, TestCase::QUICK);
+  AddTestCase (new RlsCacheTest, TestCase::QUICK);
+}
+
+static RlsTestSuite g_rlsTestSuite;
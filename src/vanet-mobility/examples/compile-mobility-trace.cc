@@ -0,0 +1,63 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Converts an ns-2 movement trace or a SUMO floating car data file into a
+ * compiled mobility trace, to be used with CompiledTraceMobilityHelper:
+ *
+ *   ./waf --run "compile-mobility-trace --input=mob.ns2 --output=mob.vmt"
+ *   ./waf --run "compile-mobility-trace --format=fcd --input=fcd.xml --output=mob.vmt"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/compiled-trace.h"
+#include <iostream>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+  std::string format = "ns2";
+
+  CommandLine cmd;
+  cmd.AddValue ("input", "ns-2 or SUMO FCD trace", input);
+  cmd.AddValue ("output", "Compiled trace to write", output);
+  cmd.AddValue ("format", "Format of the input: ns2 or fcd", format);
+  cmd.Parse (argc, argv);
+
+  if (input.empty () || output.empty ())
+    {
+      std::cerr << "Both --input and --output are required" << std::endl;
+      return 1;
+    }
+
+  CompiledTraceWriter writer;
+  bool loaded;
+  if (format == "ns2")
+    {
+      loaded = writer.LoadNs2 (input);
+    }
+  else if (format == "fcd")
+    {
+      loaded = writer.LoadSumoFcd (input);
+    }
+  else
+    {
+      std::cerr << "Unknown format " << format << std::endl;
+      return 1;
+    }
+  if (!loaded)
+    {
+      std::cerr << "Could not read " << input << std::endl;
+      return 1;
+    }
+  if (!writer.Write (output))
+    {
+      std::cerr << "Could not write " << output << std::endl;
+      return 1;
+    }
+  std::cout << output << ": " << writer.GetNNodes () << " nodes, "
+            << writer.GetNRecords () << " waypoints" << std::endl;
+  return 0;
+}
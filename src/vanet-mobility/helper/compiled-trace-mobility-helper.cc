@@ -0,0 +1,49 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "compiled-trace-mobility-helper.h"
+#include "ns3/compiled-trace-mobility-model.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("CompiledTraceMobilityHelper");
+
+namespace ns3 {
+
+CompiledTraceMobilityHelper::CompiledTraceMobilityHelper (std::string filename)
+  : m_trace (Create<CompiledTrace> (filename))
+{
+}
+
+void
+CompiledTraceMobilityHelper::Install (void) const
+{
+  Install (NodeContainer::GetGlobal ());
+}
+
+void
+CompiledTraceMobilityHelper::Install (NodeContainer nodes) const
+{
+  if (m_trace->GetNNodes () > nodes.GetN ())
+    {
+      NS_LOG_WARN ("Trace has " << m_trace->GetNNodes ()
+                                << " nodes, only the first " << nodes.GetN () << " are used");
+    }
+  uint32_t n = std::min (m_trace->GetNNodes (), nodes.GetN ());
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Node> node = nodes.Get (i);
+      Ptr<CompiledTraceMobilityModel> model = node->GetObject<CompiledTraceMobilityModel> ();
+      if (model == 0)
+        {
+          if (node->GetObject<MobilityModel> () != 0)
+            {
+              NS_FATAL_ERROR ("Node " << node->GetId () << " already has a mobility model");
+            }
+          model = CreateObject<CompiledTraceMobilityModel> ();
+          node->AggregateObject (model);
+        }
+      model->SetTrace (m_trace, i);
+    }
+}
+
+} // namespace ns3
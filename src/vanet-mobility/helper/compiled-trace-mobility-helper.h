@@ -0,0 +1,43 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef COMPILED_TRACE_MOBILITY_HELPER_H
+#define COMPILED_TRACE_MOBILITY_HELPER_H
+
+#include <string>
+#include "ns3/node-container.h"
+#include "ns3/compiled-trace.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup vanet-mobility
+ * \brief Installs a CompiledTraceMobilityModel on nodes
+ *
+ * The trace is produced once by the compile-mobility-trace program from an
+ * ns-2 or SUMO FCD trace; loading it only maps the file. The mapping is
+ * shared by all the nodes driven by this helper.
+ */
+class CompiledTraceMobilityHelper
+{
+public:
+  /**
+   * \param filename name of the compiled trace file
+   */
+  CompiledTraceMobilityHelper (std::string filename);
+
+  /**
+   * Node i of the trace drives node i of the NodeList.
+   */
+  void Install (void) const;
+
+  /**
+   * \param nodes node i of the trace drives nodes.Get (i)
+   */
+  void Install (NodeContainer nodes) const;
+
+private:
+  Ptr<const CompiledTrace> m_trace;
+};
+
+} // namespace ns3
+
+#endif /* COMPILED_TRACE_MOBILITY_HELPER_H */
@@ -0,0 +1,382 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns2-streaming-mobility-helper.h"
+#include "ns3/ns2-trace-parser.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node-list.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+NS_LOG_COMPONENT_DEFINE ("Ns2StreamingMobilityHelper");
+
+namespace ns3 {
+
+/**
+ * Memory-mapped trace read forward one time window at a time, with a
+ * per-node queue of the timed lines read ahead. Scheduled events hold a
+ * reference, so the mapping lives as long as the simulation needs it.
+ */
+class Ns2TraceStream : public SimpleRefCount<Ns2TraceStream>
+{
+public:
+  Ns2TraceStream (std::string filename, Time window);
+  ~Ns2TraceStream ();
+
+  /// Let trace node i drive nodes.Get (i), and start reading the trace
+  void Install (NodeContainer nodes);
+
+private:
+  struct NodeCursor
+  {
+    /// time and start of the timed lines of this node read ahead, by time
+    std::deque<std::pair<double, uint64_t> > waypoints;
+    bool waiting;                   ///< no waypoint pending, scheduled by the next read
+    bool seeded;                    ///< initial position taken from the first line of the node
+    Ns2Command pending;
+    Ptr<ConstantVelocityMobilityModel> model;
+    EventId arrival;
+  };
+
+  void Read ();
+  bool ParseAt (uint64_t offset, Ns2Command &cmd) const;
+  void Seed (NodeCursor &cursor, const Ns2Command &cmd);
+  void SetInitial (const Ns2Command &cmd);
+  void ScheduleNext (uint32_t i);
+  void Execute (uint32_t i);
+  void Arrive (uint32_t i, Vector destination);
+  NodeCursor * GetCursor (uint32_t i);
+
+  std::string m_filename;
+  Time m_window;
+  const char *m_data;
+  uint64_t m_size;
+  uint64_t m_read;                  ///< start of the first line not read yet
+  NodeContainer m_targets;
+  std::vector<NodeCursor> m_nodes;
+  std::vector<uint32_t> m_waiting;  ///< nodes waiting for the next read
+  bool m_warned;
+};
+
+Ns2TraceStream::Ns2TraceStream (std::string filename, Time window)
+  : m_filename (filename),
+    m_window (window),
+    m_data (0),
+    m_size (0),
+    m_read (0),
+    m_warned (false)
+{
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_FATAL_ERROR ("Could not open trace file " << filename);
+    }
+  struct stat st;
+  if (fstat (fd, &st) < 0)
+    {
+      close (fd);
+      NS_FATAL_ERROR ("Could not stat trace file " << filename);
+    }
+  m_size = st.st_size;
+  if (m_size > 0)
+    {
+      void *data = mmap (0, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED)
+        {
+          close (fd);
+          NS_FATAL_ERROR ("Could not map trace file " << filename);
+        }
+      madvise (data, m_size, MADV_SEQUENTIAL);
+      m_data = static_cast<const char *> (data);
+    }
+  close (fd);
+}
+
+Ns2TraceStream::~Ns2TraceStream ()
+{
+  if (m_data != 0)
+    {
+      munmap (const_cast<char *> (m_data), m_size);
+    }
+}
+
+Ns2TraceStream::NodeCursor *
+Ns2TraceStream::GetCursor (uint32_t i)
+{
+  if (i >= m_targets.GetN ())
+    {
+      if (!m_warned)
+        {
+          NS_LOG_WARN ("Trace " << m_filename << " has more nodes than the "
+                                << m_targets.GetN () << " installed, the others are ignored");
+          m_warned = true;
+        }
+      return 0;
+    }
+  while (i >= m_nodes.size ())
+    {
+      // Nodes are driven from the first time they show up in the trace
+      NodeCursor cursor;
+      cursor.waiting = false;
+      cursor.seeded = false;
+      Ptr<Node> node = m_targets.Get (m_nodes.size ());
+      cursor.model = node->GetObject<ConstantVelocityMobilityModel> ();
+      if (cursor.model == 0)
+        {
+          cursor.model = CreateObject<ConstantVelocityMobilityModel> ();
+          node->AggregateObject (cursor.model);
+        }
+      m_nodes.push_back (cursor);
+      // A node first seen after the end of its window waits for the next read
+      m_nodes.back ().waiting = true;
+      m_waiting.push_back (m_nodes.size () - 1);
+    }
+  return &m_nodes[i];
+}
+
+bool
+Ns2TraceStream::ParseAt (uint64_t offset, Ns2Command &cmd) const
+{
+  // The whole line, however long: the trace is mapped, so it is copied out rather than read with getline
+  const char *eol = static_cast<const char *> (std::memchr (m_data + offset, '\n', m_size - offset));
+  std::string line (m_data + offset, (eol == 0) ? m_data + m_size : eol);
+  return ParseNs2Line (line.c_str (), cmd);
+}
+
+void
+Ns2TraceStream::Install (NodeContainer nodes)
+{
+  m_targets = nodes;
+  Read ();
+}
+
+void
+Ns2TraceStream::Seed (NodeCursor &cursor, const Ns2Command &cmd)
+{
+  // A node first seen in a setdest starts at its destination rather than
+  // crossing the map from the origin
+  Vector position;
+  switch (cmd.type)
+    {
+    case Ns2Command::SETDEST:
+      position = Vector (cmd.x, cmd.y, 0);
+      break;
+    case Ns2Command::SET_X:
+      position.x = cmd.x;
+      break;
+    case Ns2Command::SET_Y:
+      position.y = cmd.x;
+      break;
+    case Ns2Command::SET_Z:
+      position.z = cmd.x;
+      break;
+    }
+  cursor.model->SetPosition (position);
+  cursor.seeded = true;
+}
+
+void
+Ns2TraceStream::SetInitial (const Ns2Command &cmd)
+{
+  NodeCursor *cursor = GetCursor (cmd.node);
+  if (cursor == 0)
+    {
+      return;
+    }
+  if (!cursor->seeded)
+    {
+      Seed (*cursor, cmd);
+      return;
+    }
+  Vector position = cursor->model->GetPosition ();
+  switch (cmd.type)
+    {
+    case Ns2Command::SET_X:
+      position.x = cmd.x;
+      break;
+    case Ns2Command::SET_Y:
+      position.y = cmd.x;
+      break;
+    case Ns2Command::SET_Z:
+      position.z = cmd.x;
+      break;
+    default:
+      return;
+    }
+  cursor->model->SetPosition (position);
+}
+
+void
+Ns2TraceStream::Read ()
+{
+  double horizon = (Simulator::Now () + m_window).GetSeconds ();
+  double nextTime = -1;
+  uint64_t lines = 0;
+  while (m_read < m_size)
+    {
+      const char *eol = static_cast<const char *> (std::memchr (m_data + m_read, '\n', m_size - m_read));
+      uint64_t next = (eol == 0) ? m_size : (eol - m_data) + 1;
+      Ns2Command cmd;
+      if (ParseAt (m_read, cmd))
+        {
+          if (!cmd.hasTime)
+            {
+              SetInitial (cmd);
+            }
+          else if (cmd.time > horizon)
+            {
+              // Left for the read of its window
+              nextTime = cmd.time;
+              break;
+            }
+          else
+            {
+              NodeCursor *cursor = GetCursor (cmd.node);
+              if (cursor != 0)
+                {
+                  if (!cursor->seeded)
+                    {
+                      Seed (*cursor, cmd);
+                    }
+                  if (cmd.time < Simulator::Now ().GetSeconds ())
+                    {
+                      NS_LOG_WARN ("Line at " << cmd.time << " s of node " << cmd.node
+                                              << " read after its time in " << m_filename);
+                    }
+                  // Traces are normally sorted by time, so this is an append
+                  std::deque<std::pair<double, uint64_t> >::iterator j = cursor->waypoints.end ();
+                  while (j != cursor->waypoints.begin () && (j - 1)->first > cmd.time)
+                    {
+                      --j;
+                    }
+                  cursor->waypoints.insert (j, std::make_pair (cmd.time, m_read));
+                  lines++;
+                }
+            }
+        }
+      m_read = next;
+    }
+  NS_LOG_DEBUG ("Read " << lines << " waypoints up to " << horizon << " s from " << m_filename);
+
+  std::vector<uint32_t> waiting;
+  waiting.swap (m_waiting);
+  for (std::vector<uint32_t>::const_iterator i = waiting.begin (); i != waiting.end (); ++i)
+    {
+      m_nodes[*i].waiting = false;
+      ScheduleNext (*i);
+    }
+
+  if (nextTime >= 0)
+    {
+      // The next read runs one window before the first line it has to index
+      Time delay = Seconds (nextTime) - m_window - Simulator::Now ();
+      Simulator::Schedule (Max (delay, Seconds (0)), &Ns2TraceStream::Read, Ptr<Ns2TraceStream> (this));
+    }
+}
+
+void
+Ns2TraceStream::ScheduleNext (uint32_t i)
+{
+  NodeCursor &cursor = m_nodes[i];
+  if (cursor.waypoints.empty ())
+    {
+      if (m_read < m_size && !cursor.waiting)
+        {
+          cursor.waiting = true;
+          m_waiting.push_back (i);
+        }
+      return;
+    }
+  ParseAt (cursor.waypoints.front ().second, cursor.pending);
+  cursor.waypoints.pop_front ();
+  Time delay = Seconds (std::max (0.0, cursor.pending.time - Simulator::Now ().GetSeconds ()));
+  Simulator::Schedule (delay, &Ns2TraceStream::Execute, Ptr<Ns2TraceStream> (this), i);
+}
+
+void
+Ns2TraceStream::Execute (uint32_t i)
+{
+  NodeCursor &cursor = m_nodes[i];
+  const Ns2Command &cmd = cursor.pending;
+  cursor.arrival.Cancel ();
+  Vector position = cursor.model->GetPosition ();
+  switch (cmd.type)
+    {
+    case Ns2Command::SETDEST:
+      {
+        Vector destination (cmd.x, cmd.y, position.z);
+        double distance = CalculateDistance (position, destination);
+        if (cmd.speed > 0 && distance > 0)
+          {
+            double k = cmd.speed / distance;
+            cursor.model->SetVelocity (Vector (k * (destination.x - position.x),
+                                               k * (destination.y - position.y), 0));
+            cursor.arrival = Simulator::Schedule (Seconds (distance / cmd.speed),
+                                                  &Ns2TraceStream::Arrive, Ptr<Ns2TraceStream> (this),
+                                                  i, destination);
+          }
+        else
+          {
+            cursor.model->SetVelocity (Vector (0, 0, 0));
+          }
+        break;
+      }
+    case Ns2Command::SET_X:
+      position.x = cmd.x;
+      cursor.model->SetPosition (position);
+      cursor.model->SetVelocity (Vector (0, 0, 0));
+      break;
+    case Ns2Command::SET_Y:
+      position.y = cmd.x;
+      cursor.model->SetPosition (position);
+      cursor.model->SetVelocity (Vector (0, 0, 0));
+      break;
+    case Ns2Command::SET_Z:
+      position.z = cmd.x;
+      cursor.model->SetPosition (position);
+      cursor.model->SetVelocity (Vector (0, 0, 0));
+      break;
+    }
+  ScheduleNext (i);
+}
+
+void
+Ns2TraceStream::Arrive (uint32_t i, Vector destination)
+{
+  NodeCursor &cursor = m_nodes[i];
+  cursor.model->SetPosition (destination);
+  cursor.model->SetVelocity (Vector (0, 0, 0));
+}
+
+
+Ns2StreamingMobilityHelper::Ns2StreamingMobilityHelper (std::string filename, Time window)
+  : m_filename (filename),
+    m_window (window)
+{
+}
+
+void
+Ns2StreamingMobilityHelper::Install (void) const
+{
+  Install (NodeContainer::GetGlobal ());
+}
+
+void
+Ns2StreamingMobilityHelper::Install (NodeContainer nodes) const
+{
+  Ptr<Ns2TraceStream> stream = Create<Ns2TraceStream> (m_filename, m_window);
+  stream->Install (nodes);
+}
+
+} // namespace ns3
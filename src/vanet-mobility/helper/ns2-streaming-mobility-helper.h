@@ -0,0 +1,66 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef NS2_STREAMING_MOBILITY_HELPER_H
+#define NS2_STREAMING_MOBILITY_HELPER_H
+
+#include <string>
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup vanet-mobility
+ * \brief Feeds an ns-2 movement trace (e.g. a SUMO export) to the nodes
+ * while the simulation runs.
+ *
+ * Unlike Ns2MobilityHelper, the trace is not parsed and scheduled up front.
+ * The file is memory-mapped and read forward one time window at a time: a
+ * read at time t indexes the timed lines up to t + window, and the next
+ * read runs when those are used up. At any time each node has a single
+ * pending waypoint event: when it fires, the next indexed line of that node
+ * is parsed and scheduled. The event queue thus holds one event per node
+ * (plus one arrival event per moving node and the next read), and memory is
+ * bounded by the lines of one window, whatever the length of the trace.
+ *
+ * The untimed "set X_/Y_/Z_" lines give the initial positions and are
+ * expected before the timed ones, as ns-2 and SUMO write them. Timed lines
+ * need only be sorted by time across windows: a line read after its time
+ * is run at once, with a warning. A node without initial position starts
+ * where its first line puts it: the destination of a first setdest.
+ *
+ * Supported lines:
+ * \code
+ * $node_(0) set X_ 150.0
+ * $ns_ at 2.0 "$node_(0) setdest 20.0 30.0 5.0"
+ * $ns_ at 2.0 "$node_(0) set X_ 150.0"
+ * \endcode
+ *
+ * The nodes get a ConstantVelocityMobilityModel, created if needed.
+ */
+class Ns2StreamingMobilityHelper
+{
+public:
+  /**
+   * \param filename name of the ns-2 trace file
+   * \param window span of trace time read ahead at once
+   */
+  Ns2StreamingMobilityHelper (std::string filename, Time window = Seconds (10));
+
+  /**
+   * Node i of the trace drives node i of the NodeList.
+   */
+  void Install (void) const;
+
+  /**
+   * \param nodes node i of the trace drives nodes.Get (i)
+   */
+  void Install (NodeContainer nodes) const;
+
+private:
+  std::string m_filename;
+  Time m_window;
+};
+
+} // namespace ns3
+
+#endif /* NS2_STREAMING_MOBILITY_HELPER_H */
@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "compiled-trace-mobility-model.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("CompiledTraceMobilityModel");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (CompiledTraceMobilityModel);
+
+TypeId
+CompiledTraceMobilityModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CompiledTraceMobilityModel")
+    .SetParent<MobilityModel> ()
+    .AddConstructor<CompiledTraceMobilityModel> ()
+  ;
+  return tid;
+}
+
+CompiledTraceMobilityModel::CompiledTraceMobilityModel ()
+  : m_node (0),
+    m_cursor (0)
+{
+}
+
+void
+CompiledTraceMobilityModel::DoDispose (void)
+{
+  m_trace = 0;
+  MobilityModel::DoDispose ();
+}
+
+void
+CompiledTraceMobilityModel::SetTrace (Ptr<const CompiledTrace> trace, uint32_t node)
+{
+  NS_ASSERT (node < trace->GetNNodes ());
+  if (trace->GetNRecords (node) == 0)
+    {
+      NS_LOG_WARN ("Node " << node << " has no waypoints in the trace");
+      m_trace = 0;
+      return;
+    }
+  m_trace = trace;
+  m_node = node;
+  m_cursor = 0;
+  NotifyCourseChange ();
+}
+
+const CompiledTraceRecord &
+CompiledTraceMobilityModel::Seek (void) const
+{
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  uint64_t n = m_trace->GetNRecords (m_node);
+  uint64_t cursor = m_cursor;
+  // Time only moves forward, so this is amortised O(1)
+  if (m_trace->GetRecord (m_node, m_cursor).time > now)
+    {
+      m_cursor = 0;
+    }
+  while (m_cursor + 1 < n && m_trace->GetRecord (m_node, m_cursor + 1).time <= now)
+    {
+      m_cursor++;
+    }
+  const CompiledTraceRecord &record = m_trace->GetRecord (m_node, m_cursor);
+  if (m_cursor != cursor)
+    {
+      // The cursor is already moved, so listeners querying the position
+      // from the notification do not notify again
+      NotifyCourseChange ();
+    }
+  return record;
+}
+
+Vector
+CompiledTraceMobilityModel::DoGetPosition (void) const
+{
+  if (m_trace == 0)
+    {
+      return m_position;
+    }
+  const CompiledTraceRecord &record = Seek ();
+  Vector position = CompiledTrace::GetPosition (record);
+  double dt = (Simulator::Now () - CompiledTrace::GetTime (record)).GetSeconds ();
+  if (dt <= 0)
+    {
+      return position;
+    }
+  Vector velocity = CompiledTrace::GetVelocity (record);
+  return Vector (position.x + velocity.x * dt,
+                 position.y + velocity.y * dt,
+                 position.z + velocity.z * dt);
+}
+
+void
+CompiledTraceMobilityModel::DoSetPosition (const Vector &position)
+{
+  m_trace = 0;
+  m_position = position;
+  NotifyCourseChange ();
+}
+
+Vector
+CompiledTraceMobilityModel::DoGetVelocity (void) const
+{
+  if (m_trace == 0)
+    {
+      return Vector (0, 0, 0);
+    }
+  const CompiledTraceRecord &record = Seek ();
+  if (CompiledTrace::GetTime (record) > Simulator::Now ())
+    {
+      return Vector (0, 0, 0);
+    }
+  return CompiledTrace::GetVelocity (record);
+}
+
+} // namespace ns3
@@ -0,0 +1,51 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef COMPILED_TRACE_MOBILITY_MODEL_H
+#define COMPILED_TRACE_MOBILITY_MODEL_H
+
+#include "ns3/mobility-model.h"
+#include "ns3/ptr.h"
+#include "compiled-trace.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup vanet-mobility
+ * \brief Moves a node along its waypoints in a compiled mobility trace
+ *
+ * The position is computed when asked for, from the last record not later
+ * than now; no events are scheduled. Before its first record the node stays
+ * at the first position. Calling SetPosition detaches the model from the
+ * trace and leaves the node there.
+ *
+ * Since nothing happens between queries, the course change of a waypoint
+ * is notified by the first query of the position or velocity at or after
+ * its time; when several waypoints were passed since the last query, it is
+ * notified once. SetTrace and SetPosition notify it at once.
+ */
+class CompiledTraceMobilityModel : public MobilityModel
+{
+public:
+  static TypeId GetTypeId (void);
+  CompiledTraceMobilityModel ();
+
+  /// Follow the records of node in trace
+  void SetTrace (Ptr<const CompiledTrace> trace, uint32_t node);
+
+private:
+  virtual void DoDispose (void);
+  virtual Vector DoGetPosition (void) const;
+  virtual void DoSetPosition (const Vector &position);
+  virtual Vector DoGetVelocity (void) const;
+
+  /// Record that drives the node at the current time, notifies the course change if it is a new one
+  const CompiledTraceRecord & Seek (void) const;
+
+  Ptr<const CompiledTrace> m_trace;
+  uint32_t m_node;
+  mutable uint64_t m_cursor;
+  Vector m_position;   ///< used when detached from the trace
+};
+
+} // namespace ns3
+
+#endif /* COMPILED_TRACE_MOBILITY_MODEL_H */
@@ -0,0 +1,451 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "compiled-trace.h"
+#include "ns2-trace-parser.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+NS_LOG_COMPONENT_DEFINE ("CompiledTrace");
+
+namespace ns3 {
+
+static const char g_magic[4] = { 'V', 'M', 'T', 'R' };
+
+/// File header of a compiled trace
+struct CompiledTraceHeader
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t nodes;
+  uint32_t reserved;
+  uint64_t records;
+};
+
+static int32_t
+ToFixed (double value)
+{
+  return static_cast<int32_t> (std::floor (value * 1000.0 + 0.5));
+}
+
+static bool
+RecordTimeLess (const CompiledTraceRecord &a, const CompiledTraceRecord &b)
+{
+  return a.time < b.time;
+}
+
+static bool
+RecordTimeLessPair (const std::pair<double, Ns2Command> &a, const std::pair<double, Ns2Command> &b)
+{
+  return a.first < b.first;
+}
+
+CompiledTrace::CompiledTrace (std::string filename)
+  : m_filename (filename),
+    m_data (0),
+    m_size (0),
+    m_nNodes (0),
+    m_index (0),
+    m_records (0)
+{
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_FATAL_ERROR ("Could not open compiled trace " << filename);
+    }
+  struct stat st;
+  if (fstat (fd, &st) < 0 || (uint64_t)st.st_size < sizeof (CompiledTraceHeader))
+    {
+      close (fd);
+      NS_FATAL_ERROR ("Not a compiled trace: " << filename);
+    }
+  m_size = st.st_size;
+  void *data = mmap (0, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (data == MAP_FAILED)
+    {
+      NS_FATAL_ERROR ("Could not map compiled trace " << filename);
+    }
+  m_data = static_cast<const char *> (data);
+
+  const CompiledTraceHeader *header = reinterpret_cast<const CompiledTraceHeader *> (m_data);
+  if (std::memcmp (header->magic, g_magic, sizeof (g_magic)) != 0)
+    {
+      NS_FATAL_ERROR ("Not a compiled trace: " << filename);
+    }
+  if (header->version != VERSION)
+    {
+      NS_FATAL_ERROR ("Compiled trace " << filename << " has version " << header->version
+                                        << ", expected " << VERSION);
+    }
+  m_nNodes = header->nodes;
+  uint64_t records = header->records;
+  // Compare the counts with the file size first, so that the products below can not overflow
+  if (m_nNodes > m_size / sizeof (IndexEntry) || records > m_size / sizeof (CompiledTraceRecord))
+    {
+      NS_FATAL_ERROR ("Compiled trace " << filename << " is truncated or corrupt");
+    }
+  uint64_t expected = sizeof (CompiledTraceHeader) + (uint64_t)m_nNodes * sizeof (IndexEntry)
+    + records * sizeof (CompiledTraceRecord);
+  if (m_size != expected)
+    {
+      NS_FATAL_ERROR ("Compiled trace " << filename << " has " << m_size << " bytes, its header announces "
+                                        << expected);
+    }
+  m_index = reinterpret_cast<const IndexEntry *> (m_data + sizeof (CompiledTraceHeader));
+  m_records = reinterpret_cast<const CompiledTraceRecord *> (m_data + sizeof (CompiledTraceHeader)
+                                                             + m_nNodes * sizeof (IndexEntry));
+  for (uint32_t i = 0; i < m_nNodes; i++)
+    {
+      // first + count <= records, written so that it can not wrap around
+      if (m_index[i].count > records || m_index[i].first > records - m_index[i].count)
+        {
+          NS_FATAL_ERROR ("Compiled trace " << filename << ": waypoints " << m_index[i].first
+                                            << " + " << m_index[i].count << " of node " << i
+                                            << " are past the " << records << " records");
+        }
+    }
+  NS_LOG_DEBUG ("Mapped " << header->records << " waypoints of " << m_nNodes << " nodes from " << filename);
+}
+
+CompiledTrace::~CompiledTrace ()
+{
+  munmap (const_cast<char *> (m_data), m_size);
+}
+
+uint32_t
+CompiledTrace::GetNNodes (void) const
+{
+  return m_nNodes;
+}
+
+uint64_t
+CompiledTrace::GetNRecords (uint32_t node) const
+{
+  NS_ASSERT (node < m_nNodes);
+  return m_index[node].count;
+}
+
+const CompiledTraceRecord &
+CompiledTrace::GetRecord (uint32_t node, uint64_t i) const
+{
+  NS_ASSERT (node < m_nNodes && i < m_index[node].count);
+  return m_records[m_index[node].first + i];
+}
+
+Time
+CompiledTrace::GetTime (const CompiledTraceRecord &record)
+{
+  return NanoSeconds (record.time);
+}
+
+Vector
+CompiledTrace::GetPosition (const CompiledTraceRecord &record)
+{
+  return Vector (record.x / 1000.0, record.y / 1000.0, record.z / 1000.0);
+}
+
+Vector
+CompiledTrace::GetVelocity (const CompiledTraceRecord &record)
+{
+  return Vector (record.vx / 1000.0, record.vy / 1000.0, record.vz / 1000.0);
+}
+
+
+CompiledTraceWriter::CompiledTraceWriter ()
+{
+}
+
+void
+CompiledTraceWriter::AddWaypoint (uint32_t node, Time time, Vector position, Vector velocity)
+{
+  if (node >= m_nodes.size ())
+    {
+      m_nodes.resize (node + 1);
+    }
+  CompiledTraceRecord record;
+  record.time = time.GetNanoSeconds ();
+  record.x = ToFixed (position.x);
+  record.y = ToFixed (position.y);
+  record.z = ToFixed (position.z);
+  record.vx = ToFixed (velocity.x);
+  record.vy = ToFixed (velocity.y);
+  record.vz = ToFixed (velocity.z);
+  m_nodes[node].push_back (record);
+}
+
+bool
+CompiledTraceWriter::LoadNs2 (std::string filename)
+{
+  std::ifstream file (filename.c_str ());
+  if (!file.is_open ())
+    {
+      return false;
+    }
+  std::vector<Vector> initial;
+  std::vector<std::vector<std::pair<double, Ns2Command> > > commands;
+  std::string line;
+  while (std::getline (file, line))
+    {
+      Ns2Command cmd;
+      if (!ParseNs2Line (line.c_str (), cmd))
+        {
+          continue;
+        }
+      if (cmd.node >= initial.size ())
+        {
+          initial.resize (cmd.node + 1);
+          commands.resize (cmd.node + 1);
+        }
+      if (cmd.hasTime)
+        {
+          commands[cmd.node].push_back (std::make_pair (cmd.time, cmd));
+          continue;
+        }
+      switch (cmd.type)
+        {
+        case Ns2Command::SET_X:
+          initial[cmd.node].x = cmd.x;
+          break;
+        case Ns2Command::SET_Y:
+          initial[cmd.node].y = cmd.x;
+          break;
+        case Ns2Command::SET_Z:
+          initial[cmd.node].z = cmd.x;
+          break;
+        default:
+          break;
+        }
+    }
+
+  // Replay the commands of every node as Ns2MobilityHelper would, so that
+  // each record holds the exact position at which a new leg starts
+  for (uint32_t i = 0; i < commands.size (); i++)
+    {
+      std::vector<std::pair<double, Ns2Command> > &node = commands[i];
+      std::stable_sort (node.begin (), node.end (), RecordTimeLessPair);
+      Vector position = initial[i];
+      Vector velocity;
+      double start = 0;
+      bool moving = false;
+      double arrival = 0;
+      Vector destination;
+      AddWaypoint (i, Seconds (0), position, velocity);
+      for (std::vector<std::pair<double, Ns2Command> >::const_iterator j = node.begin (); j != node.end (); ++j)
+        {
+          const Ns2Command &cmd = j->second;
+          if (moving && arrival <= cmd.time)
+            {
+              AddWaypoint (i, Seconds (arrival), destination, Vector ());
+              position = destination;
+              velocity = Vector ();
+              start = arrival;
+              moving = false;
+            }
+          double dt = cmd.time - start;
+          position = Vector (position.x + velocity.x * dt,
+                             position.y + velocity.y * dt,
+                             position.z + velocity.z * dt);
+          velocity = Vector ();
+          moving = false;
+          start = cmd.time;
+          switch (cmd.type)
+            {
+            case Ns2Command::SETDEST:
+              {
+                destination = Vector (cmd.x, cmd.y, position.z);
+                double distance = CalculateDistance (position, destination);
+                if (cmd.speed > 0 && distance > 0)
+                  {
+                    double k = cmd.speed / distance;
+                    velocity = Vector (k * (destination.x - position.x),
+                                       k * (destination.y - position.y), 0);
+                    arrival = cmd.time + distance / cmd.speed;
+                    moving = true;
+                  }
+                break;
+              }
+            case Ns2Command::SET_X:
+              position.x = cmd.x;
+              break;
+            case Ns2Command::SET_Y:
+              position.y = cmd.x;
+              break;
+            case Ns2Command::SET_Z:
+              position.z = cmd.x;
+              break;
+            }
+          AddWaypoint (i, Seconds (cmd.time), position, velocity);
+        }
+      if (moving)
+        {
+          AddWaypoint (i, Seconds (arrival), destination, Vector ());
+        }
+    }
+  NS_LOG_DEBUG ("Loaded " << commands.size () << " nodes from " << filename);
+  return true;
+}
+
+/// Value of attribute name in an XML element, or false if it is missing
+static bool
+GetXmlAttribute (const std::string &line, const char *name, std::string &value)
+{
+  std::string key = std::string (" ") + name + "=\"";
+  std::string::size_type begin = line.find (key);
+  if (begin == std::string::npos)
+    {
+      return false;
+    }
+  begin += key.size ();
+  std::string::size_type end = line.find ('"', begin);
+  if (end == std::string::npos)
+    {
+      return false;
+    }
+  value = line.substr (begin, end - begin);
+  return true;
+}
+
+bool
+CompiledTraceWriter::LoadSumoFcd (std::string filename)
+{
+  std::ifstream file (filename.c_str ());
+  if (!file.is_open ())
+    {
+      return false;
+    }
+  uint32_t base = m_nodes.size ();
+  std::map<std::string, uint32_t> ids;
+  std::vector<std::vector<std::pair<double, Vector> > > samples;
+  double now = 0;
+  std::string line;
+  std::string value;
+  while (std::getline (file, line))
+    {
+      if (line.find ("<timestep") != std::string::npos)
+        {
+          if (GetXmlAttribute (line, "time", value))
+            {
+              now = std::atof (value.c_str ());
+            }
+          continue;
+        }
+      if (line.find ("<vehicle") == std::string::npos || !GetXmlAttribute (line, "id", value))
+        {
+          continue;
+        }
+      std::map<std::string, uint32_t>::const_iterator id = ids.find (value);
+      uint32_t node;
+      if (id == ids.end ())
+        {
+          node = samples.size ();
+          ids[value] = node;
+          samples.resize (node + 1);
+        }
+      else
+        {
+          node = id->second;
+        }
+      Vector position;
+      if (GetXmlAttribute (line, "x", value))
+        {
+          position.x = std::atof (value.c_str ());
+        }
+      if (GetXmlAttribute (line, "y", value))
+        {
+          position.y = std::atof (value.c_str ());
+        }
+      if (GetXmlAttribute (line, "z", value))
+        {
+          position.z = std::atof (value.c_str ());
+        }
+      samples[node].push_back (std::make_pair (now, position));
+    }
+
+  // Move in a straight line between consecutive samples
+  for (uint32_t i = 0; i < samples.size (); i++)
+    {
+      const std::vector<std::pair<double, Vector> > &node = samples[i];
+      for (uint32_t j = 0; j < node.size (); j++)
+        {
+          Vector velocity;
+          if (j + 1 < node.size () && node[j + 1].first > node[j].first)
+            {
+              double dt = node[j + 1].first - node[j].first;
+              velocity = Vector ((node[j + 1].second.x - node[j].second.x) / dt,
+                                 (node[j + 1].second.y - node[j].second.y) / dt,
+                                 (node[j + 1].second.z - node[j].second.z) / dt);
+            }
+          AddWaypoint (base + i, Seconds (node[j].first), node[j].second, velocity);
+        }
+    }
+  NS_LOG_DEBUG ("Loaded " << samples.size () << " vehicles from " << filename);
+  return true;
+}
+
+uint32_t
+CompiledTraceWriter::GetNNodes (void) const
+{
+  return m_nodes.size ();
+}
+
+uint64_t
+CompiledTraceWriter::GetNRecords (void) const
+{
+  uint64_t records = 0;
+  for (uint32_t i = 0; i < m_nodes.size (); i++)
+    {
+      records += m_nodes[i].size ();
+    }
+  return records;
+}
+
+bool
+CompiledTraceWriter::Write (std::string filename)
+{
+  FILE *file = std::fopen (filename.c_str (), "wb");
+  if (file == 0)
+    {
+      return false;
+    }
+  CompiledTraceHeader header;
+  std::memcpy (header.magic, g_magic, sizeof (g_magic));
+  header.version = CompiledTrace::VERSION;
+  header.nodes = m_nodes.size ();
+  header.reserved = 0;
+  header.records = GetNRecords ();
+  bool ok = std::fwrite (&header, sizeof (header), 1, file) == 1;
+
+  uint64_t first = 0;
+  for (uint32_t i = 0; ok && i < m_nodes.size (); i++)
+    {
+      std::stable_sort (m_nodes[i].begin (), m_nodes[i].end (), RecordTimeLess);
+      uint64_t entry[2] = { first, m_nodes[i].size () };
+      ok = std::fwrite (entry, sizeof (entry), 1, file) == 1;
+      first += m_nodes[i].size ();
+    }
+  for (uint32_t i = 0; ok && i < m_nodes.size (); i++)
+    {
+      if (!m_nodes[i].empty ())
+        {
+          ok = std::fwrite (&m_nodes[i][0], sizeof (CompiledTraceRecord), m_nodes[i].size (), file)
+            == m_nodes[i].size ();
+        }
+    }
+  if (std::fclose (file) != 0)
+    {
+      ok = false;
+    }
+  return ok;
+}
+
+} // namespace ns3
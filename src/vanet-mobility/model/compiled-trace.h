@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef COMPILED_TRACE_H
+#define COMPILED_TRACE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+#include "ns3/simple-ref-count.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup vanet-mobility
+ * \brief One waypoint of a compiled mobility trace
+ *
+ * From time on, the node is at position + velocity * (t - time), until the
+ * next record of the same node. Fixed point: ns, mm and mm/s.
+ */
+struct CompiledTraceRecord
+{
+  int64_t time;
+  int32_t x, y, z;
+  int32_t vx, vy, vz;
+};
+
+/**
+ * \ingroup vanet-mobility
+ * \brief Read-only, memory-mapped compiled mobility trace
+ *
+ * Layout of the file (host byte order):
+ * \verbatim
+   header   "VMTR" | version (u32) | nodes (u32) | reserved (u32) | records (u64)
+   index    per node: first record (u64) | record count (u64)
+   records  CompiledTraceRecord, grouped by node, sorted by time
+   \endverbatim
+ * Loading a trace is a single mmap; records are paged in on first use.
+ * The file size and the index are checked against the header on load,
+ * a mismatch is a fatal error.
+ */
+class CompiledTrace : public SimpleRefCount<CompiledTrace>
+{
+public:
+  static const uint32_t VERSION = 1;
+
+  CompiledTrace (std::string filename);
+  ~CompiledTrace ();
+
+  uint32_t GetNNodes (void) const;
+  /// Number of records of node
+  uint64_t GetNRecords (uint32_t node) const;
+  /// i-th record of node
+  const CompiledTraceRecord & GetRecord (uint32_t node, uint64_t i) const;
+
+  static Time GetTime (const CompiledTraceRecord &record);
+  static Vector GetPosition (const CompiledTraceRecord &record);
+  static Vector GetVelocity (const CompiledTraceRecord &record);
+
+private:
+  struct IndexEntry
+  {
+    uint64_t first;
+    uint64_t count;
+  };
+
+  std::string m_filename;
+  const char *m_data;
+  uint64_t m_size;
+  uint32_t m_nNodes;
+  const IndexEntry *m_index;
+  const CompiledTraceRecord *m_records;
+};
+
+/**
+ * \ingroup vanet-mobility
+ * \brief Builds a compiled mobility trace from ns-2 or SUMO FCD traces
+ */
+class CompiledTraceWriter
+{
+public:
+  CompiledTraceWriter ();
+
+  /// From time on, node moves from position with velocity
+  void AddWaypoint (uint32_t node, Time time, Vector position, Vector velocity);
+
+  /**
+   * Add the movements of an ns-2 trace ("setdest" and "set X_/Y_/Z_")
+   * \return false if the file cannot be read
+   */
+  bool LoadNs2 (std::string filename);
+  /**
+   * Add the movements of a SUMO floating car data (--fcd-output) file.
+   * Vehicles are numbered in order of first appearance after the nodes
+   * already added, and stop where they leave the simulation.
+   * \return false if the file cannot be read
+   */
+  bool LoadSumoFcd (std::string filename);
+
+  uint32_t GetNNodes (void) const;
+  uint64_t GetNRecords (void) const;
+
+  /// \return false if the file cannot be written
+  bool Write (std::string filename);
+
+private:
+  std::vector<std::vector<CompiledTraceRecord> > m_nodes;
+};
+
+} // namespace ns3
+
+#endif /* COMPILED_TRACE_H */
@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns2-trace-parser.h"
+#include <cstring>
+#include <cstdlib>
+
+namespace ns3 {
+
+bool
+ParseNs2Line (const char *line, Ns2Command &cmd)
+{
+  const char *p = line;
+  char *end;
+  while (*p == ' ' || *p == '\t')
+    {
+      p++;
+    }
+  cmd.hasTime = false;
+  if (std::strncmp (p, "$ns_", 4) == 0)
+    {
+      p = std::strstr (p, " at ");
+      if (p == 0)
+        {
+          return false;
+        }
+      cmd.time = std::strtod (p + 4, &end);
+      if (end == p + 4)
+        {
+          return false;
+        }
+      cmd.hasTime = true;
+      p = end;
+    }
+  p = std::strstr (p, "$node_(");
+  if (p == 0)
+    {
+      return false;
+    }
+  cmd.node = std::strtoul (p + 7, &end, 10);
+  p = std::strchr (end, ')');
+  if (p == 0)
+    {
+      return false;
+    }
+  p++;
+  while (*p == ' ' || *p == '\t')
+    {
+      p++;
+    }
+  if (std::strncmp (p, "setdest", 7) == 0)
+    {
+      cmd.type = Ns2Command::SETDEST;
+      cmd.x = std::strtod (p + 7, &end);
+      cmd.y = std::strtod (end, &end);
+      cmd.speed = std::strtod (end, &end);
+      return true;
+    }
+  if (std::strncmp (p, "set ", 4) == 0)
+    {
+      p += 4;
+      while (*p == ' ')
+        {
+          p++;
+        }
+      switch (p[0])
+        {
+        case 'X':
+          cmd.type = Ns2Command::SET_X;
+          break;
+        case 'Y':
+          cmd.type = Ns2Command::SET_Y;
+          break;
+        case 'Z':
+          cmd.type = Ns2Command::SET_Z;
+          break;
+        default:
+          return false;
+        }
+      if (p[1] != '_')
+        {
+          return false;
+        }
+      cmd.x = std::strtod (p + 2, &end);
+      return true;
+    }
+  return false;
+}
+
+} // namespace ns3
@@ -0,0 +1,37 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef NS2_TRACE_PARSER_H
+#define NS2_TRACE_PARSER_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup vanet-mobility
+ * \brief One parsed line of an ns-2 movement trace
+ */
+struct Ns2Command
+{
+  enum Type
+  {
+    SET_X,
+    SET_Y,
+    SET_Z,
+    SETDEST,
+  };
+  Type type;
+  bool hasTime;
+  double time;
+  uint32_t node;
+  double x, y, speed;   ///< setdest arguments; x holds the value of set X_/Y_/Z_
+};
+
+/**
+ * Parse one NUL-terminated line of an ns-2 movement trace
+ * \return false if the line is not a movement command
+ */
+bool ParseNs2Line (const char *line, Ns2Command &cmd);
+
+} // namespace ns3
+
+#endif /* NS2_TRACE_PARSER_H */
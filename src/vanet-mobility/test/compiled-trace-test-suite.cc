@@ -0,0 +1,135 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/compiled-trace.h"
+#include "ns3/compiled-trace-mobility-model.h"
+#include "ns3/simulator.h"
+#include "ns3/callback.h"
+
+using namespace ns3;
+
+/// A trace written by CompiledTraceWriter is read back unchanged by CompiledTrace
+class CompiledTraceRoundTripTest : public TestCase
+{
+public:
+  CompiledTraceRoundTripTest ();
+  virtual void DoRun (void);
+};
+
+CompiledTraceRoundTripTest::CompiledTraceRoundTripTest ()
+  : TestCase ("VMTR write and load round trip")
+{
+}
+
+void
+CompiledTraceRoundTripTest::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("round-trip.vmt");
+  CompiledTraceWriter writer;
+  // Out of order on purpose, the writer sorts each node by time
+  writer.AddWaypoint (0, Seconds (5), Vector (6.5, 2, 0), Vector (0, -2.25, 0));
+  writer.AddWaypoint (0, Seconds (0), Vector (1, 2, 0), Vector (1.1, 0, 0));
+  writer.AddWaypoint (2, MilliSeconds (1500), Vector (-3.25, 4.001, 1), Vector (0, 0, 0));
+  NS_TEST_ASSERT_MSG_EQ (writer.GetNNodes (), 3, "Nodes up to the highest one");
+  NS_TEST_ASSERT_MSG_EQ (writer.GetNRecords (), 3, "All the waypoints");
+  NS_TEST_ASSERT_MSG_EQ (writer.Write (filename), true, "Trace written");
+
+  Ptr<CompiledTrace> trace = Create<CompiledTrace> (filename);
+  NS_TEST_ASSERT_MSG_EQ (trace->GetNNodes (), 3, "Nodes read back");
+  NS_TEST_ASSERT_MSG_EQ (trace->GetNRecords (0), 2, "Waypoints of node 0");
+  NS_TEST_ASSERT_MSG_EQ (trace->GetNRecords (1), 0, "Node 1 has no waypoints");
+  NS_TEST_ASSERT_MSG_EQ (trace->GetNRecords (2), 1, "Waypoints of node 2");
+
+  const CompiledTraceRecord &first = trace->GetRecord (0, 0);
+  NS_TEST_EXPECT_MSG_EQ (CompiledTrace::GetTime (first), Seconds (0), "Sorted by time");
+  NS_TEST_EXPECT_MSG_EQ_TOL (CompiledTrace::GetPosition (first).x, 1, 1e-9, "Position x");
+  NS_TEST_EXPECT_MSG_EQ_TOL (CompiledTrace::GetVelocity (first).x, 1.1, 1e-9, "Velocity x");
+
+  const CompiledTraceRecord &second = trace->GetRecord (0, 1);
+  NS_TEST_EXPECT_MSG_EQ (CompiledTrace::GetTime (second), Seconds (5), "Sorted by time");
+  NS_TEST_EXPECT_MSG_EQ_TOL (CompiledTrace::GetPosition (second).x, 6.5, 1e-9, "Position x");
+  NS_TEST_EXPECT_MSG_EQ_TOL (CompiledTrace::GetVelocity (second).y, -2.25, 1e-9, "Velocity y");
+
+  const CompiledTraceRecord &other = trace->GetRecord (2, 0);
+  NS_TEST_EXPECT_MSG_EQ (CompiledTrace::GetTime (other), MilliSeconds (1500), "Time in ns");
+  NS_TEST_EXPECT_MSG_EQ_TOL (CompiledTrace::GetPosition (other).x, -3.25, 1e-9, "Negative position");
+  NS_TEST_EXPECT_MSG_EQ_TOL (CompiledTrace::GetPosition (other).y, 4.001, 1e-9, "Position in mm");
+  NS_TEST_EXPECT_MSG_EQ_TOL (CompiledTrace::GetPosition (other).z, 1, 1e-9, "Position z");
+}
+
+/// CompiledTraceMobilityModel follows the waypoints and notifies their course changes
+class CompiledTraceMobilityModelTest : public TestCase
+{
+public:
+  CompiledTraceMobilityModelTest ();
+  virtual void DoRun (void);
+
+private:
+  void CourseChange (Ptr<const MobilityModel> model);
+  void Check (Vector position, uint32_t courseChanges);
+
+  Ptr<CompiledTraceMobilityModel> m_model;
+  uint32_t m_courseChanges;
+};
+
+CompiledTraceMobilityModelTest::CompiledTraceMobilityModelTest ()
+  : TestCase ("Compiled trace mobility model"),
+    m_courseChanges (0)
+{
+}
+
+void
+CompiledTraceMobilityModelTest::CourseChange (Ptr<const MobilityModel> model)
+{
+  m_courseChanges++;
+  // Querying the model from the notification must not notify again
+  model->GetPosition ();
+}
+
+void
+CompiledTraceMobilityModelTest::Check (Vector position, uint32_t courseChanges)
+{
+  Vector actual = m_model->GetPosition ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (actual.x, position.x, 1e-9, "Position x at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (actual.y, position.y, 1e-9, "Position y at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ (m_courseChanges, courseChanges, "Course changes at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+CompiledTraceMobilityModelTest::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("model.vmt");
+  CompiledTraceWriter writer;
+  writer.AddWaypoint (0, Seconds (0), Vector (1, 2, 0), Vector (1, 0, 0));
+  writer.AddWaypoint (0, Seconds (5), Vector (6, 2, 0), Vector (0, -2, 0));
+  writer.AddWaypoint (0, Seconds (6), Vector (6, 0, 0), Vector (0, 0, 0));
+  NS_TEST_ASSERT_MSG_EQ (writer.Write (filename), true, "Trace written");
+
+  m_model = CreateObject<CompiledTraceMobilityModel> ();
+  m_model->TraceConnectWithoutContext ("CourseChange", MakeCallback (&CompiledTraceMobilityModelTest::CourseChange, this));
+  m_model->SetTrace (Create<CompiledTrace> (filename), 0);
+  NS_TEST_EXPECT_MSG_EQ (m_courseChanges, 1, "SetTrace notifies");
+
+  Simulator::Schedule (Seconds (2), &CompiledTraceMobilityModelTest::Check, this, Vector (3, 2, 0), 1);
+  Simulator::Schedule (Seconds (5.5), &CompiledTraceMobilityModelTest::Check, this, Vector (6, 1, 0), 2);
+  Simulator::Schedule (Seconds (5.6), &CompiledTraceMobilityModelTest::Check, this, Vector (6, 0.8, 0), 2);
+  Simulator::Schedule (Seconds (8), &CompiledTraceMobilityModelTest::Check, this, Vector (6, 0, 0), 3);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_model = 0;
+}
+
+class CompiledTraceTestSuite : public TestSuite
+{
+public:
+  CompiledTraceTestSuite ();
+};
+
+CompiledTraceTestSuite::CompiledTraceTestSuite ()
+  : TestSuite ("vanet-mobility-compiled-trace", UNIT)
+{
+  AddTestCase (new CompiledTraceRoundTripTest, TestCase::QUICK);
+  AddTestCase (new CompiledTraceMobilityModelTest, TestCase::QUICK);
+}
+
+static CompiledTraceTestSuite g_compiledTraceTestSuite;
@@ -0,0 +1,330 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "async-output-stream.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#ifdef NS3_ASYNC_OUTPUT
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#include <deque>
+#endif
+#include <set>
+#include <cstring>
+
+NS_LOG_COMPONENT_DEFINE ("AsyncOutputStream");
+
+namespace ns3 {
+
+/// Write data to file, then close it if requested
+static void
+WriteChunk (FILE *file, const std::vector<char> &data, bool close)
+{
+  if (!data.empty ()
+      && std::fwrite (&data[0], 1, data.size (), file) != data.size ())
+    {
+      NS_LOG_WARN ("Short write of " << data.size () << " bytes");
+    }
+  if (close)
+    {
+      std::fclose (file);
+    }
+}
+
+#ifdef NS3_ASYNC_OUTPUT
+
+/**
+ * The thread that writes the buffers of all the AsyncOutputStreams. It is
+ * started by the first buffer and stopped by AsyncOutputStream::CloseAll.
+ */
+class AsyncWriter
+{
+public:
+  AsyncWriter ();
+  ~AsyncWriter ();
+
+  /// Queue data to be written to file, then close it if requested
+  void Submit (FILE *file, std::vector<char> &data, bool close);
+  /// Write out everything queued and stop the thread
+  void Stop (void);
+
+private:
+  struct Chunk
+  {
+    FILE *file;
+    std::vector<char> data;
+    bool close;
+  };
+
+  void Run (void);
+
+  /// Bytes queued before Submit waits for the writer
+  static const uint64_t MAX_QUEUED = 64 * 1024 * 1024;
+
+  Ptr<SystemThread> m_thread;
+  SystemMutex m_mutex;
+  SystemCondition m_ready;     ///< set when a chunk is queued or on Stop
+  SystemCondition m_drained;   ///< set when a chunk has been written
+  std::deque<Chunk> m_queue;
+  uint64_t m_queued;
+  bool m_stopping;
+};
+
+AsyncWriter::AsyncWriter ()
+  : m_queued (0),
+    m_stopping (false)
+{
+}
+
+AsyncWriter::~AsyncWriter ()
+{
+  Stop ();
+}
+
+void
+AsyncWriter::Submit (FILE *file, std::vector<char> &data, bool close)
+{
+  for (;;)
+    {
+      m_drained.SetCondition (false);
+      {
+        CriticalSection cs (m_mutex);
+        if (m_queued < MAX_QUEUED)
+          {
+            m_queue.push_back (Chunk ());
+            Chunk &chunk = m_queue.back ();
+            chunk.file = file;
+            chunk.data.swap (data);
+            chunk.close = close;
+            m_queued += chunk.data.size ();
+            if (m_thread == 0)
+              {
+                m_stopping = false;
+                m_thread = Create<SystemThread> (MakeCallback (&AsyncWriter::Run, this));
+                m_thread->Start ();
+              }
+            break;
+          }
+      }
+      NS_LOG_LOGIC ("Writer is behind, waiting");
+      m_drained.TimedWait (1000000);
+    }
+  m_ready.SetCondition (true);
+  m_ready.Signal ();
+}
+
+void
+AsyncWriter::Stop (void)
+{
+  Ptr<SystemThread> thread;
+  {
+    CriticalSection cs (m_mutex);
+    thread = m_thread;
+    m_thread = 0;
+    m_stopping = true;
+  }
+  if (thread != 0)
+    {
+      m_ready.SetCondition (true);
+      m_ready.Signal ();
+      thread->Join ();
+    }
+}
+
+void
+AsyncWriter::Run (void)
+{
+  for (;;)
+    {
+      m_ready.SetCondition (false);
+      Chunk chunk;
+      bool found = false;
+      {
+        CriticalSection cs (m_mutex);
+        if (!m_queue.empty ())
+          {
+            Chunk &front = m_queue.front ();
+            chunk.file = front.file;
+            chunk.data.swap (front.data);
+            chunk.close = front.close;
+            m_queue.pop_front ();
+            found = true;
+          }
+        else if (m_stopping)
+          {
+            return;
+          }
+      }
+      if (!found)
+        {
+          m_ready.TimedWait (10000000);
+          continue;
+        }
+      WriteChunk (chunk.file, chunk.data, chunk.close);
+      {
+        CriticalSection cs (m_mutex);
+        m_queued -= chunk.data.size ();
+      }
+      m_drained.SetCondition (true);
+      m_drained.Signal ();
+    }
+}
+
+#else /* NS3_ASYNC_OUTPUT */
+
+/**
+ * Without thread support in the core the buffers are written as soon as
+ * they are handed over, on the simulation thread.
+ */
+class AsyncWriter
+{
+public:
+  void Submit (FILE *file, std::vector<char> &data, bool close)
+  {
+    WriteChunk (file, data, close);
+    data.clear ();
+  }
+  void Stop (void)
+  {
+  }
+};
+
+#endif /* NS3_ASYNC_OUTPUT */
+
+/// The writer shared by all the streams, created on first use
+static AsyncWriter &
+GetWriter (void)
+{
+  static AsyncWriter writer;
+  return writer;
+}
+
+/// Streams not yet closed, for CloseAll
+static std::set<AsyncOutputStream *> &
+GetOpenStreams (void)
+{
+  static std::set<AsyncOutputStream *> openStreams;
+  return openStreams;
+}
+
+static bool g_destroyScheduled = false;
+
+
+AsyncOutputStream::Buffer::Buffer (AsyncOutputStream *owner, uint32_t size)
+  : m_owner (owner),
+    m_data (size == 0 ? 1 : size)
+{
+  setp (&m_data[0], &m_data[0] + m_data.size ());
+}
+
+void
+AsyncOutputStream::Buffer::Take (std::vector<char> &data)
+{
+  uint32_t size = m_data.size ();
+  data.swap (m_data);
+  data.resize (pptr () - pbase ());
+  m_data.resize (size);
+  setp (&m_data[0], &m_data[0] + m_data.size ());
+}
+
+AsyncOutputStream::Buffer::int_type
+AsyncOutputStream::Buffer::overflow (int_type c)
+{
+  m_owner->Flush ();
+  if (traits_type::eq_int_type (c, traits_type::eof ()))
+    {
+      return traits_type::not_eof (c);
+    }
+  *pptr () = traits_type::to_char_type (c);
+  pbump (1);
+  return c;
+}
+
+
+AsyncOutputStream::AsyncOutputStream (std::string filename, std::ios::openmode filemode,
+                                      uint32_t bufferSize)
+  : m_filename (filename),
+    m_file (0),
+    m_buffer (this, bufferSize),
+    m_stream (&m_buffer)
+{
+  m_file = std::fopen (filename.c_str (), (filemode & std::ios::app) ? "ab" : "wb");
+  if (m_file == 0)
+    {
+      NS_FATAL_ERROR ("Could not open " << filename);
+    }
+  GetOpenStreams ().insert (this);
+  if (!g_destroyScheduled)
+    {
+      Simulator::ScheduleDestroy (&AsyncOutputStream::CloseAll);
+      g_destroyScheduled = true;
+    }
+}
+
+AsyncOutputStream::~AsyncOutputStream ()
+{
+  Close ();
+}
+
+std::ostream *
+AsyncOutputStream::GetStream (void)
+{
+  return &m_stream;
+}
+
+void
+AsyncOutputStream::Write (const void *data, uint32_t size)
+{
+  m_buffer.sputn (static_cast<const char *> (data), size);
+}
+
+void
+AsyncOutputStream::Flush (void)
+{
+  std::vector<char> data;
+  m_buffer.Take (data);
+  if (m_file != 0 && !data.empty ())
+    {
+      GetWriter ().Submit (m_file, data, false);
+    }
+}
+
+void
+AsyncOutputStream::Close (void)
+{
+  if (m_file == 0)
+    {
+      return;
+    }
+  if (!m_closeCallback.IsNull ())
+    {
+      Callback<void> cb = m_closeCallback;
+      m_closeCallback = Callback<void> ();
+      cb ();
+    }
+  std::vector<char> data;
+  m_buffer.Take (data);
+  GetWriter ().Submit (m_file, data, true);
+  m_file = 0;
+  GetOpenStreams ().erase (this);
+}
+
+void
+AsyncOutputStream::SetCloseCallback (Callback<void> cb)
+{
+  m_closeCallback = cb;
+}
+
+void
+AsyncOutputStream::CloseAll (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  while (!GetOpenStreams ().empty ())
+    {
+      (*GetOpenStreams ().begin ())->Close ();
+    }
+  GetWriter ().Stop ();
+  g_destroyScheduled = false;
+}
+
+} // namespace ns3
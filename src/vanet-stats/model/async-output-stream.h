@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef ASYNC_OUTPUT_STREAM_H
+#define ASYNC_OUTPUT_STREAM_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <streambuf>
+#include <cstdio>
+#include <stdint.h>
+#include "ns3/simple-ref-count.h"
+#include "ns3/callback.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup vanet-stats
+ * \brief Output file written by a background thread
+ *
+ * A drop-in for OutputStreamWrapper when traces are written on every event.
+ * Text goes through GetStream () and packed binary records through Write ();
+ * both land in a per-stream memory buffer. Full buffers are handed to a
+ * single writer thread shared by all the streams, so the simulation never
+ * waits on the disk unless the writer falls far behind. When ns-3 is built
+ * without threads the full buffers are written directly instead.
+ *
+ * std::endl does not flush the buffer to the file; Flush () does, and so
+ * does Close (). Streams still open are closed by Simulator::Destroy.
+ */
+class AsyncOutputStream : public SimpleRefCount<AsyncOutputStream>
+{
+public:
+  /**
+   * \param filename file to write
+   * \param filemode std::ios::out truncates the file, std::ios::app appends
+   * \param bufferSize bytes buffered before they are handed to the writer
+   */
+  AsyncOutputStream (std::string filename, std::ios::openmode filemode = std::ios::out,
+                     uint32_t bufferSize = 64 * 1024);
+  ~AsyncOutputStream ();
+
+  /// Stream to write text to
+  std::ostream * GetStream (void);
+  /// Append size bytes of data, e.g. a packed record
+  void Write (const void *data, uint32_t size);
+  /// Hand what has been written so far to the writer
+  void Flush (void);
+  /// Flush and close the file; further output is discarded
+  void Close (void);
+  /**
+   * \param cb called by Close before the file is closed, e.g. to write
+   * out what the owner still buffers when Simulator::Destroy closes it
+   */
+  void SetCloseCallback (Callback<void> cb);
+
+  /// Close every open stream and wait until everything is on disk
+  static void CloseAll (void);
+
+private:
+  /// Fixed-size put area in front of the writer thread
+  class Buffer : public std::streambuf
+  {
+  public:
+    Buffer (AsyncOutputStream *owner, uint32_t size);
+    /// Take the buffered bytes out, leaving the buffer empty
+    void Take (std::vector<char> &data);
+  protected:
+    virtual int_type overflow (int_type c);
+  private:
+    AsyncOutputStream *m_owner;
+    std::vector<char> m_data;
+  };
+
+  std::string m_filename;
+  FILE *m_file;
+  Callback<void> m_closeCallback;
+  Buffer m_buffer;
+  std::ostream m_stream;
+};
+
+} // namespace ns3
+
+#endif /* ASYNC_OUTPUT_STREAM_H */
@@ -0,0 +1,420 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "profiling-simulator-impl.h"
+#include "ns3/default-simulator-impl.h"
+#include "ns3/event-impl.h"
+#include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/log.h"
+#include <typeinfo>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+#ifdef NS3_EVENT_PROFILING
+#include <cxxabi.h>
+#include <time.h>
+#endif
+
+NS_LOG_COMPONENT_DEFINE ("ProfilingSimulatorImpl");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (ProfilingSimulatorImpl);
+
+namespace
+{
+ObjectFactory
+GetDefaultSimulatorImplFactory ()
+{
+  ObjectFactory factory;
+  factory.SetTypeId (DefaultSimulatorImpl::GetTypeId ());
+  return factory;
+}
+
+#ifdef NS3_EVENT_PROFILING
+uint64_t
+GetWallClockNs (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return uint64_t (ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+#endif
+}
+
+/// An event that counts its execution before running the wrapped one
+class ProfilingSimulatorImpl::CountedEvent : public EventImpl
+{
+public:
+  CountedEvent (ProfilingSimulatorImpl *owner, EventImpl *event, EventStats *stats)
+    : m_owner (owner),
+      m_event (event, false),
+      m_stats (stats)
+  {
+  }
+
+protected:
+  virtual void Notify (void)
+  {
+    m_owner->m_executed++;
+#ifdef NS3_EVENT_PROFILING
+    if (m_stats != 0)
+      {
+        uint64_t start = GetWallClockNs ();
+        m_event->Invoke ();
+        m_stats->nanoseconds += GetWallClockNs () - start;
+        m_stats->executed++;
+        return;
+      }
+#endif
+    m_event->Invoke ();
+  }
+
+private:
+  ProfilingSimulatorImpl *m_owner;
+  Ptr<EventImpl> m_event;
+  EventStats *m_stats;
+};
+
+ProfilingSimulatorImpl::EventStats::EventStats ()
+  : scheduled (0),
+    executed (0),
+    nanoseconds (0)
+{
+}
+
+TypeId
+ProfilingSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ProfilingSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .AddConstructor<ProfilingSimulatorImpl> ()
+    .AddAttribute ("SimulatorImplFactory",
+                   "Factory for the underlying simulator implementation.",
+                   ObjectFactoryValue (GetDefaultSimulatorImplFactory ()),
+                   MakeObjectFactoryAccessor (&ProfilingSimulatorImpl::m_simulatorImplFactory),
+                   MakeObjectFactoryChecker ())
+    .AddAttribute ("ProfileEvents",
+                   "Measure the wall-clock time spent in events, per class of the called object.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&ProfilingSimulatorImpl::m_profileEvents),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ProfileOutput",
+                   "File the event profile is written to on Destroy, standard error if empty.",
+                   StringValue (""),
+                   MakeStringAccessor (&ProfilingSimulatorImpl::m_profileOutput),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+ProfilingSimulatorImpl::ProfilingSimulatorImpl ()
+  : m_scheduled (0),
+    m_executed (0),
+    m_cancelled (0),
+    m_profileEvents (false)
+{
+}
+
+ProfilingSimulatorImpl::~ProfilingSimulatorImpl ()
+{
+}
+
+void
+ProfilingSimulatorImpl::DoDispose (void)
+{
+  if (m_simulator)
+    {
+      m_simulator->Dispose ();
+      m_simulator = NULL;
+    }
+  SimulatorImpl::DoDispose ();
+}
+
+void
+ProfilingSimulatorImpl::NotifyConstructionCompleted ()
+{
+  m_simulator = m_simulatorImplFactory.Create<SimulatorImpl> ();
+#ifndef NS3_EVENT_PROFILING
+  if (m_profileEvents)
+    {
+      NS_LOG_WARN ("ProfileEvents is ignored, event profiling was disabled at configure time");
+      m_profileEvents = false;
+    }
+#endif
+}
+
+EventImpl *
+ProfilingSimulatorImpl::Wrap (EventImpl *event)
+{
+  m_scheduled++;
+  return new CountedEvent (this, event, GetStats (event));
+}
+
+ProfilingSimulatorImpl::EventStats *
+ProfilingSimulatorImpl::GetStats (const EventImpl *event)
+{
+  if (!m_profileEvents)
+    {
+      return 0;
+    }
+  // The name of a type_info is unique to its type, no need to compare strings
+  EventStats *stats = &m_stats[typeid (*event).name ()];
+  stats->scheduled++;
+  return stats;
+}
+
+std::string
+ProfilingSimulatorImpl::GetEventLabel (const char *typeName)
+{
+  std::string name = typeName;
+#ifdef NS3_EVENT_PROFILING
+  int status;
+  char *demangled = abi::__cxa_demangle (typeName, 0, 0, &status);
+  if (status == 0)
+    {
+      name = demangled;
+    }
+  std::free (demangled);
+#endif
+  // Events made by MakeEvent from a member function carry its type,
+  // "void (ns3::Class::*)(args)". Members of class templates (helpers
+  // such as timer implementations) are skipped for the callee they wrap,
+  // named in their template arguments.
+  std::string label;
+  std::string::size_type end = 0;
+  while ((end = name.find ("::*)", end)) != std::string::npos)
+    {
+      std::string::size_type begin = end;
+      int depth = 0;
+      while (begin > 0)
+        {
+          char c = name[begin - 1];
+          if (c == '>')
+            {
+              depth++;
+            }
+          else if (c == '<')
+            {
+              depth--;
+            }
+          else if (depth == 0 && (c == '(' || c == ' ' || c == ','))
+            {
+              break;
+            }
+          begin--;
+        }
+      std::string cls = name.substr (begin, end - begin);
+      end += 4;
+      if (cls.compare (0, 5, "ns3::") == 0)
+        {
+          cls = cls.substr (5);
+        }
+      if (cls.find ('<') != std::string::npos)
+        {
+          continue;
+        }
+      label = cls;
+    }
+  if (!label.empty ())
+    {
+      return label;
+    }
+  if (name.find ("(*)") != std::string::npos)
+    {
+      return "(function)";
+    }
+  return name;
+}
+
+void
+ProfilingSimulatorImpl::PrintProfile (std::ostream &os) const
+{
+  // Types of different template arguments often share a label
+  std::map<std::string, EventStats> byLabel;
+  uint64_t total = 0;
+  for (std::map<const char *, EventStats>::const_iterator i = m_stats.begin (); i != m_stats.end (); ++i)
+    {
+      EventStats &stats = byLabel[GetEventLabel (i->first)];
+      stats.scheduled += i->second.scheduled;
+      stats.executed += i->second.executed;
+      stats.nanoseconds += i->second.nanoseconds;
+      total += i->second.nanoseconds;
+    }
+  std::vector<std::pair<uint64_t, std::string> > order;
+  for (std::map<std::string, EventStats>::const_iterator i = byLabel.begin (); i != byLabel.end (); ++i)
+    {
+      order.push_back (std::make_pair (i->second.nanoseconds, i->first));
+    }
+  std::sort (order.rbegin (), order.rend ());
+
+  std::ios::fmtflags flags = os.flags ();
+  os << std::setw (12) << "scheduled" << std::setw (12) << "executed"
+     << std::setw (12) << "total(s)" << std::setw (10) << "mean(us)"
+     << std::setw (8) << "share" << "  callee" << std::endl;
+  for (std::vector<std::pair<uint64_t, std::string> >::const_iterator i = order.begin ();
+       i != order.end (); ++i)
+    {
+      const EventStats &stats = byLabel.find (i->second)->second;
+      os << std::setw (12) << stats.scheduled << std::setw (12) << stats.executed
+         << std::fixed << std::setprecision (3)
+         << std::setw (12) << stats.nanoseconds / 1e9
+         << std::setw (10) << (stats.executed == 0 ? 0.0 : stats.nanoseconds / 1e3 / stats.executed)
+         << std::setprecision (1)
+         << std::setw (7) << (total == 0 ? 0.0 : 100.0 * stats.nanoseconds / total) << "%"
+         << "  " << i->second << std::endl;
+      os.flags (flags);
+    }
+}
+
+void
+ProfilingSimulatorImpl::Destroy ()
+{
+  NS_LOG_INFO ("Scheduled " << m_scheduled << " events, executed " << m_executed
+                            << ", cancelled " << m_cancelled);
+  if (m_profileEvents)
+    {
+      if (m_profileOutput.empty ())
+        {
+          PrintProfile (std::cerr);
+        }
+      else
+        {
+          std::ofstream os (m_profileOutput.c_str ());
+          PrintProfile (os);
+        }
+    }
+  m_simulator->Destroy ();
+}
+
+void
+ProfilingSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  m_simulator->SetScheduler (schedulerFactory);
+}
+
+uint32_t
+ProfilingSimulatorImpl::GetSystemId (void) const
+{
+  return m_simulator->GetSystemId ();
+}
+
+bool
+ProfilingSimulatorImpl::IsFinished (void) const
+{
+  return m_simulator->IsFinished ();
+}
+
+void
+ProfilingSimulatorImpl::Run (void)
+{
+  m_simulator->Run ();
+}
+
+void
+ProfilingSimulatorImpl::Stop (void)
+{
+  m_simulator->Stop ();
+}
+
+void
+ProfilingSimulatorImpl::Stop (Time const &time)
+{
+  m_simulator->Stop (time);
+}
+
+EventId
+ProfilingSimulatorImpl::Schedule (Time const &time, EventImpl *event)
+{
+  return m_simulator->Schedule (time, Wrap (event));
+}
+
+void
+ProfilingSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event)
+{
+  m_simulator->ScheduleWithContext (context, time, Wrap (event));
+}
+
+EventId
+ProfilingSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return m_simulator->ScheduleNow (Wrap (event));
+}
+
+EventId
+ProfilingSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  return m_simulator->ScheduleDestroy (event);
+}
+
+Time
+ProfilingSimulatorImpl::Now (void) const
+{
+  return m_simulator->Now ();
+}
+
+Time
+ProfilingSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  return m_simulator->GetDelayLeft (id);
+}
+
+void
+ProfilingSimulatorImpl::Remove (const EventId &id)
+{
+  if (!m_simulator->IsExpired (id))
+    {
+      m_cancelled++;
+    }
+  m_simulator->Remove (id);
+}
+
+void
+ProfilingSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!m_simulator->IsExpired (id))
+    {
+      m_cancelled++;
+    }
+  m_simulator->Cancel (id);
+}
+
+bool
+ProfilingSimulatorImpl::IsExpired (const EventId &ev) const
+{
+  return m_simulator->IsExpired (ev);
+}
+
+Time
+ProfilingSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return m_simulator->GetMaximumSimulationTime ();
+}
+
+uint32_t
+ProfilingSimulatorImpl::GetContext (void) const
+{
+  return m_simulator->GetContext ();
+}
+
+uint64_t
+ProfilingSimulatorImpl::GetScheduledEvents (void) const
+{
+  return m_scheduled;
+}
+
+uint64_t
+ProfilingSimulatorImpl::GetExecutedEvents (void) const
+{
+  return m_executed;
+}
+
+uint64_t
+ProfilingSimulatorImpl::GetCancelledEvents (void) const
+{
+  return m_cancelled;
+}
+
+} // namespace ns3
@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef PROFILING_SIMULATOR_IMPL_H
+#define PROFILING_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/object-factory.h"
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <iostream>
+
+namespace ns3 {
+
+/**
+ * \ingroup vanet-stats
+ * \brief A simulator that counts the events run by the simulator it wraps
+ *
+ * Every event scheduled through it is wrapped, so that the events actually
+ * executed are counted apart from those cancelled or left in the queue when
+ * the simulation stops. Select it before anything is scheduled:
+ *
+ * \code
+ * GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::ProfilingSimulatorImpl"));
+ * ...
+ * Ptr<ProfilingSimulatorImpl> sim = DynamicCast<ProfilingSimulatorImpl> (Simulator::GetImplementation ());
+ * \endcode
+ *
+ * or run any simulation with --SimulatorImplementationType=ns3::ProfilingSimulatorImpl.
+ *
+ * With ProfileEvents set, the wall-clock time spent in every event is also
+ * attributed to the class of the object the event calls (YansWifiPhy,
+ * MacLow, gpsr::RoutingProtocol, ...; timers are attributed to the object
+ * they call back), together with the number of events of each class
+ * scheduled and executed. The time of an event includes everything it
+ * calls synchronously, trace sinks included. The table is written when the
+ * simulator is destroyed:
+ *
+ * \code
+ * --SimulatorImplementationType=ns3::ProfilingSimulatorImpl --ns3::ProfilingSimulatorImpl::ProfileEvents=true
+ * \endcode
+ *
+ * The timing code is only compiled when NS3_EVENT_PROFILING is defined,
+ * which the vanet-stats module does unless configured with
+ * --disable-event-profiling.
+ */
+class ProfilingSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  ProfilingSimulatorImpl ();
+  ~ProfilingSimulatorImpl ();
+
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &time);
+  virtual EventId Schedule (Time const &time, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &ev);
+  virtual void Cancel (const EventId &ev);
+  virtual bool IsExpired (const EventId &ev) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /// Events scheduled since the simulator was created, destroy events excluded
+  uint64_t GetScheduledEvents (void) const;
+  /// Events executed since the simulator was created, destroy events excluded
+  uint64_t GetExecutedEvents (void) const;
+  /// Events cancelled or removed before they ran
+  uint64_t GetCancelledEvents (void) const;
+
+  /**
+   * \brief Write the per-class event profile, most expensive first
+   *
+   * One line per class: scheduled and executed events, total and mean
+   * wall-clock time and share of the time spent in events. Empty unless
+   * ProfileEvents is set.
+   */
+  void PrintProfile (std::ostream &os) const;
+
+protected:
+  void DoDispose ();
+  void NotifyConstructionCompleted (void);
+
+private:
+  class CountedEvent;
+
+  /// Events of one dynamic EventImpl type
+  struct EventStats
+  {
+    EventStats ();
+    uint64_t scheduled;
+    uint64_t executed;
+    uint64_t nanoseconds;
+  };
+
+  /// Wrap event so that its execution is counted
+  EventImpl * Wrap (EventImpl *event);
+  /// Stats of the type of event, NULL when not profiling
+  EventStats * GetStats (const EventImpl *event);
+  /// Short name of an event type: the class of the called object
+  static std::string GetEventLabel (const char *typeName);
+
+  Ptr<SimulatorImpl> m_simulator;
+  ObjectFactory m_simulatorImplFactory;
+  uint64_t m_scheduled;
+  uint64_t m_executed;
+  uint64_t m_cancelled;
+  bool m_profileEvents;
+  std::string m_profileOutput;
+  /// Keyed by the mangled type name, i.e. by type
+  std::map<const char *, EventStats> m_stats;
+};
+
+} // namespace ns3
+
+#endif /* PROFILING_SIMULATOR_IMPL_H */
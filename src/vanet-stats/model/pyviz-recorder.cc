@@ -0,0 +1,234 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "pyviz-recorder.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/callback.h"
+#include <sstream>
+#include <limits>
+
+NS_LOG_COMPONENT_DEFINE ("PyVizRecorder");
+
+namespace ns3 {
+
+static const char g_magic[4] = { 'P', 'V', 'Z', 'R' };
+/// Transmissions are paired with their receptions for this long, as in PyViz
+static const Time g_txRecordLifetime = Seconds (10);
+
+PyVizRecorder::Counter::Counter ()
+  : packets (0),
+    bytes (0)
+{
+}
+
+PyVizRecorder::PyVizRecorder (std::string filename, double frameRate)
+  : m_file (Create<AsyncOutputStream> (filename)),
+    m_frameInterval (Seconds (1.0 / frameRate)),
+    m_offset (0),
+    m_installed (false)
+{
+  NS_ASSERT (frameRate > 0);
+  m_file->SetCloseCallback (MakeCallback (&PyVizRecorder::Flush, this));
+}
+
+PyVizRecorder::~PyVizRecorder ()
+{
+  Close ();
+}
+
+void
+PyVizRecorder::Install (NodeContainer nodes)
+{
+  NS_ASSERT_MSG (!m_installed, "PyVizRecorder can be installed once");
+  m_installed = true;
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      uint32_t id = (*i)->GetId ();
+      m_nodeIds.push_back (id);
+      m_mobility.push_back ((*i)->GetObject<MobilityModel> ());
+
+      // Connected per node, so that the traces are bound to the node id
+      // instead of carrying a context string to parse on every packet
+      std::ostringstream path;
+      path << "/NodeList/" << id << "/DeviceList/*/$ns3::WifiNetDevice/Mac/";
+      Config::ConnectWithoutContext (path.str () + "MacTx", MakeCallback (&PyVizRecorder::Tx, this).Bind (id));
+      Config::ConnectWithoutContext (path.str () + "MacRx", MakeCallback (&PyVizRecorder::Rx, this).Bind (id));
+      Config::ConnectWithoutContext (path.str () + "MacTxDrop", MakeCallback (&PyVizRecorder::Drop, this).Bind (id));
+      std::ostringstream ipv4;
+      ipv4 << "/NodeList/" << id << "/$ns3::Ipv4L3Protocol/Drop";
+      Config::ConnectWithoutContext (ipv4.str (), MakeCallback (&PyVizRecorder::Ipv4Drop, this).Bind (id));
+    }
+
+  uint32_t version = VERSION;
+  int64_t interval = m_frameInterval.GetNanoSeconds ();
+  uint32_t n = m_nodeIds.size ();
+  Write (g_magic, sizeof (g_magic));
+  WriteValue (version);
+  WriteValue (interval);
+  WriteValue (n);
+  if (n > 0)
+    {
+      Write (&m_nodeIds[0], n * sizeof (uint32_t));
+    }
+  m_frameEvent = Simulator::ScheduleNow (&PyVizRecorder::Frame, this);
+}
+
+void
+PyVizRecorder::InstallAll (void)
+{
+  Install (NodeContainer::GetGlobal ());
+}
+
+uint32_t
+PyVizRecorder::GetFrames (void) const
+{
+  return m_indexTimes.size ();
+}
+
+void
+PyVizRecorder::Tx (uint32_t node, Ptr<const Packet> p)
+{
+  Counter &c = m_tx[node];
+  c.packets++;
+  c.bytes += p->GetSize ();
+  m_txRecords[p->GetUid ()] = std::make_pair (node, Simulator::Now ());
+  m_txRecordTimes.push_back (std::make_pair (Simulator::Now (), p->GetUid ()));
+}
+
+void
+PyVizRecorder::Rx (uint32_t node, Ptr<const Packet> p)
+{
+  std::map<uint64_t, std::pair<uint32_t, Time> >::const_iterator i = m_txRecords.find (p->GetUid ());
+  if (i == m_txRecords.end () || i->second.first == node)
+    {
+      return;
+    }
+  Counter &c = m_links[Link (i->second.first, node)];
+  c.packets++;
+  c.bytes += p->GetSize ();
+}
+
+void
+PyVizRecorder::Drop (uint32_t node, Ptr<const Packet> p)
+{
+  Counter &c = m_drops[node];
+  c.packets++;
+  c.bytes += p->GetSize ();
+}
+
+void
+PyVizRecorder::Ipv4Drop (uint32_t node, const Ipv4Header &header, Ptr<const Packet> p,
+                         Ipv4L3Protocol::DropReason reason, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Drop (node, p);
+}
+
+void
+PyVizRecorder::Frame (void)
+{
+  WriteFrame ();
+
+  Time expired = Simulator::Now () - g_txRecordLifetime;
+  while (!m_txRecordTimes.empty () && m_txRecordTimes.front ().first < expired)
+    {
+      // A packet forwarded later keeps its UID and has a newer record, keep it
+      std::map<uint64_t, std::pair<uint32_t, Time> >::iterator i = m_txRecords.find (m_txRecordTimes.front ().second);
+      if (i != m_txRecords.end () && i->second.second < expired)
+        {
+          m_txRecords.erase (i);
+        }
+      m_txRecordTimes.pop_front ();
+    }
+
+  m_frameEvent = Simulator::Schedule (m_frameInterval, &PyVizRecorder::Frame, this);
+}
+
+void
+PyVizRecorder::WriteFrame (void)
+{
+  m_indexTimes.push_back (Simulator::Now ().GetNanoSeconds ());
+  m_indexOffsets.push_back (m_offset);
+
+  uint8_t tag = 1;
+  WriteValue (tag);
+  WriteValue (m_indexTimes.back ());
+  for (std::vector<Ptr<MobilityModel> >::const_iterator i = m_mobility.begin (); i != m_mobility.end (); ++i)
+    {
+      float xy[2] = { std::numeric_limits<float>::quiet_NaN (), std::numeric_limits<float>::quiet_NaN () };
+      if (*i != 0)
+        {
+          Vector pos = (*i)->GetPosition ();
+          xy[0] = pos.x;
+          xy[1] = pos.y;
+        }
+      Write (xy, sizeof (xy));
+    }
+
+  WriteValue (uint32_t (m_tx.size ()));
+  for (std::map<uint32_t, Counter>::const_iterator i = m_tx.begin (); i != m_tx.end (); ++i)
+    {
+      uint32_t row[3] = { i->first, i->second.packets, i->second.bytes };
+      Write (row, sizeof (row));
+    }
+  WriteValue (uint32_t (m_links.size ()));
+  for (std::map<Link, Counter>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      uint32_t row[4] = { i->first.first, i->first.second, i->second.packets, i->second.bytes };
+      Write (row, sizeof (row));
+    }
+  WriteValue (uint32_t (m_drops.size ()));
+  for (std::map<uint32_t, Counter>::const_iterator i = m_drops.begin (); i != m_drops.end (); ++i)
+    {
+      uint32_t row[3] = { i->first, i->second.packets, i->second.bytes };
+      Write (row, sizeof (row));
+    }
+  m_tx.clear ();
+  m_links.clear ();
+  m_drops.clear ();
+}
+
+void
+PyVizRecorder::Write (const void *data, uint32_t size)
+{
+  m_file->Write (data, size);
+  m_offset += size;
+}
+
+void
+PyVizRecorder::Close (void)
+{
+  if (m_file != 0)
+    {
+      m_file->Close ();
+      m_file = 0;
+    }
+  m_frameEvent.Cancel ();
+}
+
+void
+PyVizRecorder::Flush (void)
+{
+  if (!m_installed)
+    {
+      return;
+    }
+  if (m_indexTimes.empty () || m_indexTimes.back () < Simulator::Now ().GetNanoSeconds ())
+    {
+      WriteFrame ();
+    }
+  uint64_t indexOffset = m_offset;
+  uint8_t tag = 2;
+  uint32_t frames = m_indexTimes.size ();
+  WriteValue (tag);
+  WriteValue (frames);
+  for (uint32_t i = 0; i < frames; ++i)
+    {
+      WriteValue (m_indexTimes[i]);
+      WriteValue (m_indexOffsets[i]);
+    }
+  WriteValue (indexOffset);
+  NS_LOG_DEBUG ("Recorded " << frames << " frames of " << m_nodeIds.size () << " nodes");
+}
+
+} // namespace ns3
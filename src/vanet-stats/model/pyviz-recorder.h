@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef PYVIZ_RECORDER_H
+#define PYVIZ_RECORDER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <stdint.h>
+#include "ns3/simple-ref-count.h"
+#include "ns3/node-container.h"
+#include "ns3/mobility-model.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/async-output-stream.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup vanet-stats
+ * \brief Records what PyViz shows, for an offline replay
+ *
+ * The live visualizer steps the simulation in short slices to redraw it,
+ * which makes large runs crawl. This recorder lets the simulation run at
+ * full speed and writes, every frame interval, the node positions and the
+ * transmissions and drops since the previous frame, to be replayed with
+ *
+ * \verbatim
+   python src/visualizer/visualizer/replay.py run.pvzr
+   \endverbatim
+ *
+ * Transmissions are taken from the MacTx and MacRx traces of wifi devices,
+ * paired by packet UID (as PyViz does); drops from the MacTxDrop trace and
+ * from Ipv4L3Protocol. The file is written in the background through an
+ * AsyncOutputStream, in host byte order:
+ *
+ * \verbatim
+   file     "PVZR" | version (u32) | frame interval ns (i64) | nodes n (u32) |
+            node ids u32[n] | frame* | index
+   frame    1 (u8) | time ns (i64) | positions (x f32, y f32)[n] |
+            tx count (u32) | (node u32, packets u32, bytes u32)[count] |
+            link count (u32) | (tx node u32, rx node u32, packets u32, bytes u32)[count] |
+            drop count (u32) | (node u32, packets u32, bytes u32)[count]
+   index    2 (u8) | frames (u32) | (time ns i64, frame offset u64)[frames] |
+            index offset (u64)
+   \endverbatim
+ *
+ * A frame holds what happened after the previous frame, up to its time.
+ * The index is written on Close; a reader finds it from the last 8 bytes
+ * and falls back to scanning the frames if the run did not end cleanly.
+ * Recording keeps a frame event scheduled, so the simulation must be
+ * ended with Simulator::Stop.
+ */
+class PyVizRecorder : public SimpleRefCount<PyVizRecorder>
+{
+public:
+  static const uint32_t VERSION = 1;
+
+  /**
+   * \param filename file to write
+   * \param frameRate frames per simulated second
+   */
+  PyVizRecorder (std::string filename, double frameRate = 10);
+  ~PyVizRecorder ();
+
+  /// Record nodes, from now on; call once, after the devices are installed
+  void Install (NodeContainer nodes);
+  /// Record every node
+  void InstallAll (void);
+
+  /// Write the last frame and the index and close the file; done by Simulator::Destroy
+  void Close (void);
+
+  uint32_t GetFrames (void) const;
+
+private:
+  struct Counter
+  {
+    Counter ();
+    uint32_t packets;
+    uint32_t bytes;
+  };
+  typedef std::pair<uint32_t, uint32_t> Link;
+
+  void Tx (uint32_t node, Ptr<const Packet> p);
+  void Rx (uint32_t node, Ptr<const Packet> p);
+  void Drop (uint32_t node, Ptr<const Packet> p);
+  void Ipv4Drop (uint32_t node, const Ipv4Header &header, Ptr<const Packet> p,
+                 Ipv4L3Protocol::DropReason reason, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  /// Write a frame and schedule the next one
+  void Frame (void);
+  void WriteFrame (void);
+  /// Write the last frame and the index, before m_file closes
+  void Flush (void);
+  void Write (const void *data, uint32_t size);
+  template <typename T>
+  void WriteValue (T value)
+  {
+    Write (&value, sizeof (T));
+  }
+
+  Ptr<AsyncOutputStream> m_file;
+  Time m_frameInterval;
+  /// Bytes written so far, for the index
+  uint64_t m_offset;
+  bool m_installed;
+  EventId m_frameEvent;
+
+  std::vector<uint32_t> m_nodeIds;
+  std::vector<Ptr<MobilityModel> > m_mobility;
+
+  /// Last transmitter of the packets sent in the last seconds and when, by UID
+  std::map<uint64_t, std::pair<uint32_t, Time> > m_txRecords;
+  /// m_txRecords in the order they were added, to expire them
+  std::deque<std::pair<Time, uint64_t> > m_txRecordTimes;
+
+  ///\name Since the last frame
+  //\{
+  std::map<uint32_t, Counter> m_tx;
+  std::map<Link, Counter> m_links;
+  std::map<uint32_t, Counter> m_drops;
+  //\}
+
+  std::vector<int64_t> m_indexTimes;
+  std::vector<uint64_t> m_indexOffsets;
+};
+
+} // namespace ns3
+
+#endif /* PYVIZ_RECORDER_H */
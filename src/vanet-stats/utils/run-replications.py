@@ -0,0 +1,282 @@
+#! /usr/bin/env python
+## -*- Mode: python; py-indent-offset: 4; indent-tabs-mode: nil; coding: utf-8; -*-
+"""
+Run a scenario over a parameter grid and many RNG runs, in parallel.
+
+Every (parameter combination, run) pair is a separate process of the
+scenario binary, started with --RngRun=<run> in its own working directory,
+so that the files a scenario writes do not collide. The metrics each run
+prints are appended to a results table as soon as the run ends; running the
+same command again skips the runs already in the table, so an interrupted
+sweep resumes where it stopped. When all runs are done, a summary with the
+mean, standard deviation and 95% confidence interval of every metric per
+combination is written next to it.
+
+A run's metrics are read from its standard output, either
+  - a CSV header line followed by a CSV row (e.g. gpsr-scaling), or
+  - "name: value" / "name value" lines with a numeric value (e.g. the
+    "PDR:  97.5%" lines of scratch/buildings-test).
+
+Build first, then run the binaries directly (waf is not reentrant):
+
+  ./waf build
+  python src/vanet-stats/utils/run-replications.py \\
+      --program build/scratch/buildings-test --runs 30 \\
+      --param RP=2,5 --param numOfPacks=100,200 --out sweep-rp
+"""
+
+from __future__ import print_function, division
+
+import csv
+import itertools
+import math
+import optparse
+import os
+import re
+import subprocess
+import sys
+import threading
+
+try:
+    import Queue as queue
+except ImportError:
+    import queue
+
+# Student's t, two-sided 95%, by degrees of freedom
+T95 = {1: 12.706, 2: 4.303, 3: 3.182, 4: 2.776, 5: 2.571, 6: 2.447, 7: 2.365,
+       8: 2.306, 9: 2.262, 10: 2.228, 12: 2.179, 15: 2.131, 20: 2.086,
+       25: 2.060, 30: 2.042, 40: 2.021, 60: 2.000, 120: 1.980}
+
+KV_LINE = re.compile(r'^\s*([A-Za-z][\w .()/-]*?)\s*:?\s+(-?\d+(?:\.\d*)?(?:[eE][-+]?\d+)?)\s*%?\s*$')
+
+
+def t95(dof):
+    for d in sorted(T95):
+        if dof <= d:
+            return T95[d]
+    return 1.960
+
+
+def parse_grid(params):
+    """--param name=v1,v2 options to a list of [(name, value), ...] combinations"""
+    axes = []
+    for p in params:
+        if '=' not in p:
+            raise ValueError("bad --param %r, expected name=v1,v2,..." % p)
+        name, values = p.split('=', 1)
+        axes.append([(name, v) for v in values.split(',')])
+    return [list(c) for c in itertools.product(*axes)]
+
+
+def parse_metrics(output):
+    """Metrics printed by a run, as an ordered list of (name, value)"""
+    lines = [l.strip() for l in output.splitlines() if l.strip()]
+    # CSV header and row: the last two lines with the same number of fields
+    if len(lines) >= 2 and ',' in lines[-1]:
+        header = next(csv.reader([lines[-2]]))
+        row = next(csv.reader([lines[-1]]))
+        if len(header) == len(row):
+            metrics = []
+            for name, value in zip(header, row):
+                try:
+                    metrics.append((name, float(value)))
+                except ValueError:
+                    pass
+            if metrics:
+                return metrics
+    metrics = []
+    seen = set()
+    for line in lines:
+        m = KV_LINE.match(line)
+        if m and m.group(1) not in seen:
+            seen.add(m.group(1))
+            metrics.append((m.group(1), float(m.group(2))))
+    return metrics
+
+
+def combo_key(combo):
+    return tuple(v for _, v in combo)
+
+
+def combo_dir(combo):
+    if not combo:
+        return 'default'
+    return '_'.join('%s-%s' % (n, re.sub(r'[^\w.-]', '', v)) for n, v in combo)
+
+
+class Runner(object):
+    def __init__(self, options, grid):
+        self.options = options
+        self.grid = grid
+        self.names = [n for n, _ in grid[0]] if grid and grid[0] else []
+        self.results_path = os.path.join(options.out, 'results.csv')
+        self.lock = threading.Lock()
+        self.metric_names = []
+        self.rows = []          # (combo key, run, {metric: value})
+        self.failed = 0
+        self.load()
+
+    def load(self):
+        """Read the runs already done by an earlier invocation"""
+        if not os.path.exists(self.results_path):
+            return
+        with open(self.results_path) as f:
+            reader = csv.reader(f)
+            header = next(reader, None)
+            if header is None:
+                return
+            nparams = len(self.names)
+            self.metric_names = header[nparams + 1:]
+            for row in reader:
+                if len(row) != len(header):
+                    continue        # torn line of an interrupted write
+                metrics = {}
+                for name, value in zip(self.metric_names, row[nparams + 1:]):
+                    if value != '':
+                        metrics[name] = float(value)
+                self.rows.append((tuple(row[:nparams]), int(row[nparams]), metrics))
+
+    def pending(self):
+        done = set((key, run) for key, run, _ in self.rows)
+        first = self.options.first_run
+        for combo in self.grid:
+            for run in range(first, first + self.options.runs):
+                if (combo_key(combo), run) not in done:
+                    yield combo, run
+
+    def command(self, combo, run):
+        cmd = [os.path.abspath(self.options.program)]
+        cmd += self.options.args.split() if self.options.args else []
+        cmd += ['--%s=%s' % (n, v) for n, v in combo]
+        cmd.append('--RngRun=%d' % run)
+        return cmd
+
+    def run_one(self, combo, run):
+        workdir = os.path.join(self.options.out, combo_dir(combo), 'run-%d' % run)
+        if not os.path.isdir(workdir):
+            os.makedirs(workdir)
+        env = dict(os.environ)
+        libs = [os.path.abspath(p) for p in self.options.lib_path.split(':') if p]
+        env['LD_LIBRARY_PATH'] = ':'.join(libs + [env.get('LD_LIBRARY_PATH', '')])
+        with open(os.path.join(workdir, 'stdout.txt'), 'w') as out:
+            status = subprocess.call(self.command(combo, run), cwd=workdir, env=env,
+                                     stdout=out, stderr=subprocess.STDOUT)
+        with open(os.path.join(workdir, 'stdout.txt')) as f:
+            metrics = parse_metrics(f.read())
+        with self.lock:
+            if status != 0 or not metrics:
+                self.failed += 1
+                print("FAILED %s run %d (exit %d), see %s" % (combo_dir(combo), run, status, workdir),
+                      file=sys.stderr)
+                return
+            self.record(combo, run, metrics)
+            print("done %s run %d" % (combo_dir(combo), run))
+
+    def record(self, combo, run, metrics):
+        new_names = [n for n, _ in metrics if n not in self.metric_names]
+        values = dict(metrics)
+        self.rows.append((combo_key(combo), run, values))
+        if new_names or not os.path.exists(self.results_path):
+            # New columns: rewrite the whole table
+            self.metric_names += new_names
+            tmp = self.results_path + '.tmp'
+            with open(tmp, 'w') as f:
+                writer = csv.writer(f)
+                writer.writerow(self.names + ['run'] + self.metric_names)
+                for key, r, m in self.rows:
+                    writer.writerow(list(key) + [r] + [m.get(n, '') for n in self.metric_names])
+            os.rename(tmp, self.results_path)
+            return
+        with open(self.results_path, 'a') as f:
+            csv.writer(f).writerow(list(combo_key(combo)) + [run] +
+                                   [values.get(n, '') for n in self.metric_names])
+
+    def run(self):
+        jobs = queue.Queue()
+        count = 0
+        for job in self.pending():
+            jobs.put(job)
+            count += 1
+        print("%d runs to do, %d already done" % (count, len(self.rows)))
+
+        def worker():
+            while True:
+                try:
+                    combo, run = jobs.get_nowait()
+                except queue.Empty:
+                    return
+                self.run_one(combo, run)
+
+        threads = [threading.Thread(target=worker) for _ in range(max(1, self.options.jobs))]
+        for t in threads:
+            t.daemon = True
+            t.start()
+        for t in threads:
+            while t.is_alive():
+                t.join(1)
+
+    def summarize(self):
+        path = os.path.join(self.options.out, 'summary.csv')
+        with open(path, 'w') as f:
+            writer = csv.writer(f)
+            header = self.names + ['runs']
+            for n in self.metric_names:
+                header += [n + '_mean', n + '_std', n + '_ci95']
+            writer.writerow(header)
+            for combo in self.grid:
+                key = combo_key(combo)
+                rows = [m for k, _, m in self.rows if k == key]
+                line = list(key) + [len(rows)]
+                for n in self.metric_names:
+                    values = [m[n] for m in rows if n in m]
+                    line += summary(values)
+                writer.writerow(line)
+        print("summary written to %s" % path)
+
+
+def summary(values):
+    if not values:
+        return ['', '', '']
+    mean = sum(values) / len(values)
+    if len(values) < 2:
+        return [mean, '', '']
+    var = sum((v - mean) ** 2 for v in values) / (len(values) - 1)
+    std = math.sqrt(var)
+    return [mean, std, t95(len(values) - 1) * std / math.sqrt(len(values))]
+
+
+def main(argv):
+    parser = optparse.OptionParser(usage="%prog --program BINARY [options]", description=__doc__.split('\n\n')[0])
+    parser.add_option('--program', help="scenario binary, e.g. build/scratch/buildings-test")
+    parser.add_option('--args', default='', help="arguments given to every run")
+    parser.add_option('--param', action='append', default=[],
+                      help="name=v1,v2,... ; passed as --name=v, repeat for a grid")
+    parser.add_option('--runs', type='int', default=20, help="RNG runs per combination [%default]")
+    parser.add_option('--first-run', type='int', default=1, help="first RngRun value [%default]")
+    parser.add_option('-j', '--jobs', type='int', default=_cpu_count(),
+                      help="runs in parallel [%default]")
+    parser.add_option('--out', default='replications', help="output directory [%default]")
+    parser.add_option('--lib-path', default='build/lib:build',
+                      help="directories of the ns-3 libraries [%default]")
+    options, args = parser.parse_args(argv)
+    if not options.program:
+        parser.error("--program is required")
+    if not os.path.isdir(options.out):
+        os.makedirs(options.out)
+
+    runner = Runner(options, parse_grid(options.param))
+    runner.run()
+    runner.summarize()
+    return 1 if runner.failed else 0
+
+
+def _cpu_count():
+    try:
+        import multiprocessing
+        return multiprocessing.cpu_count()
+    except (ImportError, NotImplementedError):
+        return 1
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
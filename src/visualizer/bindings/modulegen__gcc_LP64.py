@@ -118,6 +118,10 @@ def register_types(module):
     module.add_class('PacketSample', outer_class=root_module['ns3::PyViz'])
     ## pyviz.h (module 'visualizer'): ns3::PyViz::RxPacketSample [struct]
     module.add_class('RxPacketSample', parent=root_module['ns3::PyViz::PacketSample'], outer_class=root_module['ns3::PyViz'])
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionBundleSample [struct]
+    module.add_class('TransmissionBundleSample', outer_class=root_module['ns3::PyViz'])
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionCellSample [struct]
+    module.add_class('TransmissionCellSample', outer_class=root_module['ns3::PyViz'])
     ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionSample [struct]
     module.add_class('TransmissionSample', outer_class=root_module['ns3::PyViz'])
     ## pyviz.h (module 'visualizer'): ns3::PyViz::TxPacketSample [struct]
@@ -289,6 +293,8 @@ def register_types(module):
     module.add_container('std::vector< ns3::PyViz::PacketSample >', 'ns3::PyViz::PacketSample', container_type='vector')
     module.add_container('std::set< ns3::TypeId >', 'ns3::TypeId', container_type='set')
     module.add_container('std::vector< ns3::PyViz::TransmissionSample >', 'ns3::PyViz::TransmissionSample', container_type='vector')
+    module.add_container('std::vector< ns3::PyViz::TransmissionCellSample >', 'ns3::PyViz::TransmissionCellSample', container_type='vector')
+    module.add_container('std::vector< ns3::PyViz::TransmissionBundleSample >', 'ns3::PyViz::TransmissionBundleSample', container_type='vector')
     module.add_container('std::vector< ns3::PyViz::PacketDropSample >', 'ns3::PyViz::PacketDropSample', container_type='vector')
     module.add_container('std::vector< ns3::PyViz::NetDeviceStatistics >', 'ns3::PyViz::NetDeviceStatistics', container_type='vector')
     module.add_container('std::vector< std::string >', 'std::string', container_type='vector')
@@ -382,6 +388,8 @@ def register_methods(root_module):
     register_Ns3PyVizPacketDropSample_methods(root_module, root_module['ns3::PyViz::PacketDropSample'])
     register_Ns3PyVizPacketSample_methods(root_module, root_module['ns3::PyViz::PacketSample'])
     register_Ns3PyVizRxPacketSample_methods(root_module, root_module['ns3::PyViz::RxPacketSample'])
+    register_Ns3PyVizTransmissionBundleSample_methods(root_module, root_module['ns3::PyViz::TransmissionBundleSample'])
+    register_Ns3PyVizTransmissionCellSample_methods(root_module, root_module['ns3::PyViz::TransmissionCellSample'])
     register_Ns3PyVizTransmissionSample_methods(root_module, root_module['ns3::PyViz::TransmissionSample'])
     register_Ns3PyVizTxPacketSample_methods(root_module, root_module['ns3::PyViz::TxPacketSample'])
     register_Ns3SimpleRefCount__Ns3Object_Ns3ObjectBase_Ns3ObjectDeleter_methods(root_module, root_module['ns3::SimpleRefCount< ns3::Object, ns3::ObjectBase, ns3::ObjectDeleter >'])
@@ -1987,6 +1995,16 @@ def register_Ns3PyViz_methods(root_module, cls):
                    'std::vector< std::string >', 
                    [], 
                    is_const=True)
+    ## pyviz.h (module 'visualizer'): std::vector<ns3::PyViz::TransmissionBundleSample,std::allocator<ns3::PyViz::TransmissionBundleSample> > ns3::PyViz::GetTransmissionBundleSamples() const [member function]
+    cls.add_method('GetTransmissionBundleSamples', 
+                   'std::vector< ns3::PyViz::TransmissionBundleSample >', 
+                   [], 
+                   is_const=True)
+    ## pyviz.h (module 'visualizer'): std::vector<ns3::PyViz::TransmissionCellSample,std::allocator<ns3::PyViz::TransmissionCellSample> > ns3::PyViz::GetTransmissionCellSamples() const [member function]
+    cls.add_method('GetTransmissionCellSamples', 
+                   'std::vector< ns3::PyViz::TransmissionCellSample >', 
+                   [], 
+                   is_const=True)
     ## pyviz.h (module 'visualizer'): std::vector<ns3::PyViz::TransmissionSample,std::allocator<ns3::PyViz::TransmissionSample> > ns3::PyViz::GetTransmissionSamples() const [member function]
     cls.add_method('GetTransmissionSamples', 
                    'std::vector< ns3::PyViz::TransmissionSample >', 
@@ -2026,6 +2044,10 @@ def register_Ns3PyViz_methods(root_module, cls):
     cls.add_method('SetPacketCaptureOptions', 
                    'void', 
                    [param('uint32_t', 'nodeId'), param('ns3::PyViz::PacketCaptureOptions', 'options')])
+    ## pyviz.h (module 'visualizer'): void ns3::PyViz::SetViewport(double x1, double y1, double x2, double y2, double cellSize) [member function]
+    cls.add_method('SetViewport', 
+                   'void', 
+                   [param('double', 'x1'), param('double', 'y1'), param('double', 'x2'), param('double', 'y2'), param('double', 'cellSize')])
     ## pyviz.h (module 'visualizer'): void ns3::PyViz::SimulatorRunUntil(ns3::Time time) [member function]
     cls.add_method('SimulatorRunUntil', 
                    'void', 
@@ -2117,6 +2139,40 @@ def register_Ns3PyVizRxPacketSample_methods(root_module, cls):
     cls.add_instance_attribute('from', 'ns3::Mac48Address', is_const=False)
     return
 
+def register_Ns3PyVizTransmissionBundleSample_methods(root_module, cls):
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionBundleSample::TransmissionBundleSample() [constructor]
+    cls.add_constructor([])
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionBundleSample::TransmissionBundleSample(ns3::PyViz::TransmissionBundleSample const & arg0) [copy constructor]
+    cls.add_constructor([param('ns3::PyViz::TransmissionBundleSample const &', 'arg0')])
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionBundleSample::bytes [variable]
+    cls.add_instance_attribute('bytes', 'uint32_t', is_const=False)
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionBundleSample::packets [variable]
+    cls.add_instance_attribute('packets', 'uint32_t', is_const=False)
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionBundleSample::x1 [variable]
+    cls.add_instance_attribute('x1', 'double', is_const=False)
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionBundleSample::x2 [variable]
+    cls.add_instance_attribute('x2', 'double', is_const=False)
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionBundleSample::y1 [variable]
+    cls.add_instance_attribute('y1', 'double', is_const=False)
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionBundleSample::y2 [variable]
+    cls.add_instance_attribute('y2', 'double', is_const=False)
+    return
+
+def register_Ns3PyVizTransmissionCellSample_methods(root_module, cls):
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionCellSample::TransmissionCellSample() [constructor]
+    cls.add_constructor([])
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionCellSample::TransmissionCellSample(ns3::PyViz::TransmissionCellSample const & arg0) [copy constructor]
+    cls.add_constructor([param('ns3::PyViz::TransmissionCellSample const &', 'arg0')])
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionCellSample::bytes [variable]
+    cls.add_instance_attribute('bytes', 'uint32_t', is_const=False)
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionCellSample::packets [variable]
+    cls.add_instance_attribute('packets', 'uint32_t', is_const=False)
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionCellSample::x [variable]
+    cls.add_instance_attribute('x', 'double', is_const=False)
+    ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionCellSample::y [variable]
+    cls.add_instance_attribute('y', 'double', is_const=False)
+    return
+
 def register_Ns3PyVizTransmissionSample_methods(root_module, cls):
     ## pyviz.h (module 'visualizer'): ns3::PyViz::TransmissionSample::TransmissionSample() [constructor]
     cls.add_constructor([])
@@ -29,10 +29,13 @@
 #include "ns3/ethernet-header.h"
 #include "ns3/log.h"
 #include "ns3/abort.h"
+#include "ns3/mobility-model.h"
 
 #include "visual-simulator-impl.h"
 
 #include <sstream>
+#include <cmath>
+#include <algorithm>
 
 NS_LOG_COMPONENT_DEFINE ("PyViz");
 #define NUM_LAST_PACKETS 10
@@ -121,6 +124,11 @@ PyVizPacketTag::PyVizPacketTag ()
 
 
 PyViz::PyViz ()
+  : m_viewportX1 (0),
+    m_viewportY1 (0),
+    m_viewportX2 (0),
+    m_viewportY2 (0),
+    m_cellSize (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
   NS_ASSERT (g_visualizer == NULL);
@@ -279,37 +287,12 @@ PyViz::SimulatorRunUntil (Time time)
 
   m_pauseMessages.clear ();
   m_transmissionSamples.clear ();
+  m_cellSamples.clear ();
+  m_bundleSamples.clear ();
   m_packetDrops.clear ();
 
-  Time expirationTime = Simulator::Now () - Seconds (10);
-
-  // Clear very old transmission records
-  for (std::map<TxRecordKey, TxRecordValue>::iterator iter = m_txRecords.begin ();
-       iter != m_txRecords.end ();)
-    {
-      if (iter->second.time < expirationTime)
-        {
-          m_txRecords.erase (iter++);
-        }
-      else
-        {
-          iter++;
-        }
-    }
-
-  // Clear very old packets of interest
-  for (std::map<uint32_t, Time>::iterator iter = m_packetsOfInterest.begin ();
-       iter != m_packetsOfInterest.end ();)
-    {
-      if (iter->second < expirationTime)
-        {
-          m_packetsOfInterest.erase (iter++);
-        }
-      else
-        {
-          iter++;
-        }
-    }
+  // Clear very old transmission records and packets of interest
+  ExpireRecords (Simulator::Now () - Seconds (10));
 
   if (Simulator::Now () >= time)
     {
@@ -335,6 +318,61 @@ PyViz::SimulatorRunUntil (Time time)
     }
 }
 
+size_t
+PyViz::TxRecordKeyHash::operator () (TxRecordKey const &key) const
+{
+  return reinterpret_cast<size_t> (PeekPointer (key.first)) * 31 + key.second;
+}
+
+size_t
+PyViz::TransmissionSampleKeyHash::operator () (TransmissionSampleKey const &key) const
+{
+  size_t hash = reinterpret_cast<size_t> (PeekPointer (key.transmitter));
+  hash = hash * 31 + reinterpret_cast<size_t> (PeekPointer (key.receiver));
+  return hash * 31 + reinterpret_cast<size_t> (PeekPointer (key.channel));
+}
+
+PyViz::ExpiryBucket &
+PyViz::GetExpiryBucket ()
+{
+  // One bucket per second of simulated time, records expire 10 s after their bucket
+  if (m_expiryBuckets.empty () || m_expiryBuckets.back ().start + Seconds (1) <= Simulator::Now ())
+    {
+      m_expiryBuckets.push_back (ExpiryBucket ());
+      m_expiryBuckets.back ().start = Simulator::Now ();
+    }
+  return m_expiryBuckets.back ();
+}
+
+void
+PyViz::ExpireRecords (Time time)
+{
+  while (!m_expiryBuckets.empty () && m_expiryBuckets.front ().start + Seconds (1) <= time)
+    {
+      ExpiryBucket &bucket = m_expiryBuckets.front ();
+      // A key added again since has a newer time, and is also in a newer bucket
+      for (std::vector<TxRecordKey>::const_iterator i = bucket.txRecords.begin ();
+           i != bucket.txRecords.end (); ++i)
+        {
+          TxRecordMap::iterator record = m_txRecords.find (*i);
+          if (record != m_txRecords.end () && record->second.time < time)
+            {
+              m_txRecords.erase (record);
+            }
+        }
+      for (std::vector<uint32_t>::const_iterator i = bucket.packetsOfInterest.begin ();
+           i != bucket.packetsOfInterest.end (); ++i)
+        {
+          PacketsOfInterestMap::iterator packet = m_packetsOfInterest.find (*i);
+          if (packet != m_packetsOfInterest.end () && packet->second < time)
+            {
+              m_packetsOfInterest.erase (packet);
+            }
+        }
+      m_expiryBuckets.pop_front ();
+    }
+}
+
 bool PyViz::TransmissionSampleKey::operator < (PyViz::TransmissionSampleKey const &other) const
 {
   if (this->transmitter < other.transmitter)
@@ -562,6 +600,7 @@ PyViz::TraceNetDevTxCommon (std::string const &context, Ptr<const Packet> packet
     {
       // We will follow this packet throughout the network.
       m_packetsOfInterest[packet->GetUid ()] = Simulator::Now ();
+      GetExpiryBucket ().packetsOfInterest.push_back (packet->GetUid ());
     }
 
   TxRecordValue record = { Simulator::Now (), node, false };
@@ -570,7 +609,9 @@ PyViz::TraceNetDevTxCommon (std::string const &context, Ptr<const Packet> packet
       record.isBroadcast = true;
     }
 
-  m_txRecords[TxRecordKey (device->GetChannel (), packet->GetUid ())] = record;
+  TxRecordKey key (device->GetChannel (), packet->GetUid ());
+  m_txRecords[key] = record;
+  GetExpiryBucket ().txRecords.push_back (key);
 
   PyVizPacketTag tag;
   //packet->RemovePacketTag (tag);
@@ -688,7 +729,7 @@ PyViz::TraceNetDevRxCommon (std::string const &context, Ptr<const Packet> packet
 
   Ptr<Channel> channel = device->GetChannel ();
 
-  std::map<TxRecordKey, TxRecordValue>::iterator recordIter = 
+  TxRecordMap::iterator recordIter = 
     m_txRecords.find (TxRecordKey (channel, uid));
 
   if (recordIter == m_txRecords.end ())
@@ -706,13 +747,19 @@ PyViz::TraceNetDevRxCommon (std::string const &context, Ptr<const Packet> packet
       return;
     }
 
+  if (m_cellSize > 0)
+    {
+      AddGridSample (record.srcNode, node, packet->GetSize ());
+      return;
+    }
+
   TransmissionSampleKey key = { record.srcNode, node, channel };
 
 #ifdef  NS3_LOG_ENABLE
   NS_LOG_DEBUG ("m_transmissionSamples begin:");
   if (g_log.IsEnabled (ns3::LOG_DEBUG))
     {
-      for (std::map<TransmissionSampleKey,TransmissionSampleValue>::const_iterator iter
+      for (TransmissionSampleMap::const_iterator iter
              = m_transmissionSamples.begin (); iter != m_transmissionSamples.end (); iter++)
         {
           NS_LOG_DEBUG (iter->first.transmitter<<"/"<<iter->first.transmitter->GetId () << ", "
@@ -723,8 +770,7 @@ PyViz::TraceNetDevRxCommon (std::string const &context, Ptr<const Packet> packet
   NS_LOG_DEBUG ("m_transmissionSamples end.");
 #endif
 
-  std::map<TransmissionSampleKey,TransmissionSampleValue>::iterator
-    iter = m_transmissionSamples.find (key);
+  TransmissionSampleMap::iterator iter = m_transmissionSamples.find (key);
 
   if (iter == m_transmissionSamples.end ())
     {
@@ -851,7 +897,7 @@ PyViz::GetTransmissionSamples () const
 {
   NS_LOG_DEBUG ("GetTransmissionSamples BEGIN");
   TransmissionSampleList list;
-  for (std::map<TransmissionSampleKey, TransmissionSampleValue>::const_iterator
+  for (TransmissionSampleMap::const_iterator
        iter = m_transmissionSamples.begin ();
        iter !=  m_transmissionSamples.end ();
        iter++)
@@ -1426,6 +1472,110 @@ PyViz::LineClipping (double boundsX1, double boundsY1, double boundsX2, double b
   lineY2 = line.end.y;
 }
 
+void
+PyViz::SetViewport (double x1, double y1, double x2, double y2, double cellSize)
+{
+  m_viewportX1 = std::min (x1, x2);
+  m_viewportY1 = std::min (y1, y2);
+  m_viewportX2 = std::max (x1, x2);
+  m_viewportY2 = std::max (y1, y2);
+  m_cellSize = std::max (cellSize, 0.0);
+}
+
+size_t
+PyViz::GridBundleHash::operator () (GridBundle const &bundle) const
+{
+  std::tr1::hash<uint64_t> hash;
+  return hash (bundle.first) * 31 + hash (bundle.second);
+}
+
+PyViz::GridCell
+PyViz::GetGridCell (double x, double y) const
+{
+  int32_t cx = static_cast<int32_t> (std::floor (x / m_cellSize));
+  int32_t cy = static_cast<int32_t> (std::floor (y / m_cellSize));
+  return (static_cast<uint64_t> (static_cast<uint32_t> (cx)) << 32) | static_cast<uint32_t> (cy);
+}
+
+void
+PyViz::GetGridCellCentre (GridCell cell, double &x, double &y) const
+{
+  int32_t cx = static_cast<int32_t> (static_cast<uint32_t> (cell >> 32));
+  int32_t cy = static_cast<int32_t> (static_cast<uint32_t> (cell));
+  x = (cx + 0.5) * m_cellSize;
+  y = (cy + 0.5) * m_cellSize;
+}
+
+void
+PyViz::AddGridSample (Ptr<Node> transmitter, Ptr<Node> receiver, uint32_t bytes)
+{
+  Ptr<MobilityModel> txMobility = transmitter->GetObject<MobilityModel> ();
+  Ptr<MobilityModel> rxMobility = receiver->GetObject<MobilityModel> ();
+  if (txMobility == 0 || rxMobility == 0)
+    {
+      return;
+    }
+  Vector txPos = txMobility->GetPosition ();
+  Vector rxPos = rxMobility->GetPosition ();
+  // Off screen: the bounding box of the transmission misses the viewport
+  if (std::max (txPos.x, rxPos.x) < m_viewportX1 || std::min (txPos.x, rxPos.x) > m_viewportX2
+      || std::max (txPos.y, rxPos.y) < m_viewportY1 || std::min (txPos.y, rxPos.y) > m_viewportY2)
+    {
+      return;
+    }
+  GridCell txCell = GetGridCell (txPos.x, txPos.y);
+  GridCell rxCell = GetGridCell (rxPos.x, rxPos.y);
+  GridSampleValue &sample = txCell == rxCell
+    ? m_cellSamples[txCell] : m_bundleSamples[GridBundle (txCell, rxCell)];
+  sample.packets++;
+  sample.bytes += bytes;
+}
+
+PyViz::TransmissionCellSampleList
+PyViz::GetTransmissionCellSamples () const
+{
+  TransmissionCellSampleList list;
+  list.reserve (m_cellSamples.size ());
+  for (std::tr1::unordered_map<GridCell, GridSampleValue>::const_iterator iter = m_cellSamples.begin ();
+       iter != m_cellSamples.end (); iter++)
+    {
+      TransmissionCellSample sample;
+      GetGridCellCentre (iter->first, sample.x, sample.y);
+      sample.packets = iter->second.packets;
+      sample.bytes = iter->second.bytes;
+      list.push_back (sample);
+    }
+  return list;
+}
 
+PyViz::TransmissionBundleSampleList
+PyViz::GetTransmissionBundleSamples () const
+{
+  FastClipping::Vector2 clipMin = { m_viewportX1, m_viewportY1 }, clipMax = { m_viewportX2, m_viewportY2 };
+  FastClipping clipper (clipMin, clipMax);
+  TransmissionBundleSampleList list;
+  list.reserve (m_bundleSamples.size ());
+  for (std::tr1::unordered_map<GridBundle, GridSampleValue, GridBundleHash>::const_iterator
+       iter = m_bundleSamples.begin (); iter != m_bundleSamples.end (); iter++)
+    {
+      TransmissionBundleSample sample;
+      GetGridCellCentre (iter->first.first, sample.x1, sample.y1);
+      GetGridCellCentre (iter->first.second, sample.x2, sample.y2);
+      FastClipping::Line line = { { sample.x1, sample.y1 }, { sample.x2, sample.y2 },
+                                  (sample.x2 - sample.x1), (sample.y2 - sample.y1) };
+      if (!clipper.ClipLine (line))
+        {
+          continue;
+        }
+      sample.x1 = line.start.x;
+      sample.y1 = line.start.y;
+      sample.x2 = line.end.x;
+      sample.y2 = line.end.y;
+      sample.packets = iter->second.packets;
+      sample.bytes = iter->second.bytes;
+      list.push_back (sample);
+    }
+  return list;
 }
 
+}
@@ -34,6 +34,8 @@
 
 #include <map>
 #include <set>
+#include <deque>
+#include <tr1/unordered_map>
 
 namespace ns3 {
 
@@ -111,6 +113,41 @@ public:
 
   void SetNodesOfInterest (std::set<uint32_t> nodes);
 
+  /**
+   * Level of detail for large networks: transmissions received from now on
+   * are summed in a grid of cellSize meters instead of per (transmitter,
+   * receiver) pair, and only those that cross the viewport (x1, y1)-(x2, y2)
+   * are kept. GetTransmissionSamples then returns nothing; the grid is read
+   * with GetTransmissionCellSamples and GetTransmissionBundleSamples, whose
+   * size depends on the screen, not on the network. cellSize 0 restores the
+   * per-pair samples.
+   */
+  void SetViewport (double x1, double y1, double x2, double y2, double cellSize);
+
+  /// Transmissions between nodes of the same grid cell
+  struct TransmissionCellSample
+  {
+    double x; // centre of the cell
+    double y;
+    uint32_t packets;
+    uint32_t bytes;
+  };
+  typedef std::vector<TransmissionCellSample> TransmissionCellSampleList;
+  TransmissionCellSampleList GetTransmissionCellSamples () const;
+
+  /// Transmissions from the nodes of one grid cell to those of another, as one edge
+  struct TransmissionBundleSample
+  {
+    double x1; // centre of the transmitters cell, clipped to the viewport
+    double y1;
+    double x2; // centre of the receivers cell, clipped to the viewport
+    double y2;
+    uint32_t packets;
+    uint32_t bytes;
+  };
+  typedef std::vector<TransmissionBundleSample> TransmissionBundleSampleList;
+  TransmissionBundleSampleList GetTransmissionBundleSamples () const;
+
   struct NetDeviceStatistics
   {
     NetDeviceStatistics () : transmittedBytes (0), receivedBytes (0),
@@ -159,6 +196,11 @@ private:
 
   typedef std::pair<Ptr<Channel>, uint32_t> TxRecordKey;
 
+  struct TxRecordKeyHash
+  {
+    size_t operator () (TxRecordKey const &key) const;
+  };
+
   struct TxRecordValue
   {
     Time time;
@@ -175,19 +217,64 @@ private:
     Ptr<Channel> channel;
   };
 
+  struct TransmissionSampleKeyHash
+  {
+    size_t operator () (TransmissionSampleKey const &key) const;
+  };
+
   struct TransmissionSampleValue
   {
     uint32_t bytes;
   };
 
+  /// Keys added during one expiry period, so that old records are found without a scan
+  struct ExpiryBucket
+  {
+    Time start;
+    std::vector<TxRecordKey> txRecords;
+    std::vector<uint32_t> packetsOfInterest;
+  };
+  /// Bucket that records added now go to
+  ExpiryBucket & GetExpiryBucket ();
+  /// Erase the records last refreshed before time
+  void ExpireRecords (Time time);
+
+  typedef std::tr1::unordered_map<TxRecordKey, TxRecordValue, TxRecordKeyHash> TxRecordMap;
+  typedef std::tr1::unordered_map<TransmissionSampleKey, TransmissionSampleValue,
+                                  TransmissionSampleKeyHash> TransmissionSampleMap;
+  typedef std::tr1::unordered_map<uint32_t, Time> PacketsOfInterestMap;
+
+  struct GridSampleValue
+  {
+    uint32_t packets;
+    uint32_t bytes;
+  };
+  /// A grid cell, x index in the high half and y index in the low half
+  typedef uint64_t GridCell;
+  typedef std::pair<GridCell, GridCell> GridBundle;
+  struct GridBundleHash
+  {
+    size_t operator () (GridBundle const &bundle) const;
+  };
+  GridCell GetGridCell (double x, double y) const;
+  /// Centre of the cell
+  void GetGridCellCentre (GridCell cell, double &x, double &y) const;
+  /// Sum a received transmission in the grid, if it crosses the viewport
+  void AddGridSample (Ptr<Node> transmitter, Ptr<Node> receiver, uint32_t bytes);
+
   // data
   std::map<uint32_t, PacketCaptureOptions> m_packetCaptureOptions;
   std::vector<std::string> m_pauseMessages;
-  std::map<TxRecordKey, TxRecordValue> m_txRecords;
-  std::map<TransmissionSampleKey, TransmissionSampleValue> m_transmissionSamples;
+  TxRecordMap m_txRecords;
+  TransmissionSampleMap m_transmissionSamples;
   std::map<Ptr<Node>, uint32_t> m_packetDrops;
   std::set<uint32_t> m_nodesOfInterest; // list of node IDs whose transmissions will be monitored
-  std::map<uint32_t, Time> m_packetsOfInterest; // list of packet UIDs that will be monitored
+  PacketsOfInterestMap m_packetsOfInterest; // list of packet UIDs that will be monitored
+  double m_viewportX1, m_viewportY1, m_viewportX2, m_viewportY2;
+  double m_cellSize; // 0 for per-pair transmission samples
+  std::tr1::unordered_map<GridCell, GridSampleValue> m_cellSamples;
+  std::tr1::unordered_map<GridBundle, GridSampleValue, GridBundleHash> m_bundleSamples;
+  std::deque<ExpiryBucket> m_expiryBuckets; // oldest first
   std::map<uint32_t, LastPacketsSample> m_lastPackets;
   std::map<uint32_t, std::vector<NetDeviceStatistics> > m_nodesStatistics;
 
@@ -7,6 +7,8 @@ REPRESENT_CHANNELS_AS_NODES = 1
 DEFAULT_NODE_SIZE = 3.0 # default node size in meters
 DEFAULT_TRANSMISSIONS_MEMORY = 5 # default number of of past intervals whose transmissions are remembered
 BITRATE_FONT_SIZE = 10
+LOD_MIN_NODES = 200 # from this many nodes on, transmissions are drawn per grid cell
+LOD_CELL_PIXELS = 40 # size of a grid cell on screen
 
 # internal constants, normally not meant to be changed
 SAMPLE_PERIOD = 0.1
@@ -454,6 +456,10 @@ class Visualizer(gobject.GObject):
         self.information_windows = []
         self._transmission_arrows = []
         self._last_transmissions = []
+        self._lod_items = []
+        self._last_cells = []
+        self._last_bundles = []
+        self._lod_cell_size = 0
         self._drop_arrows = []
         self._last_drops = []
         self._show_transmissions_mode = None
@@ -937,6 +943,12 @@ class Visualizer(gobject.GObject):
         while len(self._last_transmissions) > smooth_factor:
             self._last_transmissions.pop(0)            
 
+        self._last_cells.append(self.simulation.sim_helper.GetTransmissionCellSamples())
+        self._last_bundles.append(self.simulation.sim_helper.GetTransmissionBundleSamples())
+        while len(self._last_cells) > smooth_factor:
+            self._last_cells.pop(0)
+            self._last_bundles.pop(0)
+
         drops = self.simulation.sim_helper.GetPacketDropSamples()
         self._last_drops.append(drops)
         while len(self._last_drops) > smooth_factor:
@@ -1023,6 +1035,77 @@ class Visualizer(gobject.GObject):
             new_arrows.append((arrow, label))
             
         self._transmission_arrows = new_arrows + old_arrows
+        self._update_lod_view()
+
+    def _update_lod_view(self):
+        """Transmissions summed per grid cell, see _update_viewport"""
+        cells_average = {}
+        for cell_set in self._last_cells:
+            for cell in cell_set:
+                key = (cell.x, cell.y)
+                cells_average[key] = cells_average.get(key, 0) + cell.bytes
+        bundles_average = {}
+        for bundle_set in self._last_bundles:
+            for bundle in bundle_set:
+                key = (bundle.x1, bundle.y1, bundle.x2, bundle.y2)
+                bundles_average[key] = bundles_average.get(key, 0) + bundle.bytes
+
+        old_items = self._lod_items
+        for item in old_items:
+            item.set_property("visibility", goocanvas.ITEM_HIDDEN)
+        new_items = []
+        count = max(1, len(self._last_cells))
+        k = self.node_size_adjustment.value/5
+        # cells and bundles are both polylines, from a single pool
+        def get_item():
+            try:
+                item = old_items.pop()
+            except IndexError:
+                item = goocanvas.Polyline(close_path=False, parent=self.canvas.get_root_item())
+                item.props.pointer_events = 0
+                item.raise_(None)
+            new_items.append(item)
+            return item
+
+        if cells_average:
+            half = transform_distance_simulation_to_canvas(self._lod_cell_size)/2
+        for (x, y), rx_bytes in cells_average.iteritems():
+            x, y = transform_point_simulation_to_canvas(x, y)
+            rate = float(rx_bytes)/count/self.sample_period
+            alpha = int(min(0xC0, 0x20 + 0x10*math.log(1 + rate)))
+            item = get_item()
+            item.set_properties(visibility=goocanvas.ITEM_VISIBLE, close_path=True, end_arrow=False,
+                                line_width=0, fill_color_rgba=(0x00C00000 | alpha),
+                                points=goocanvas.Points([(x - half, y - half), (x + half, y - half),
+                                                         (x + half, y + half), (x - half, y + half)]))
+        for (x1, y1, x2, y2), rx_bytes in bundles_average.iteritems():
+            x1, y1 = transform_point_simulation_to_canvas(x1, y1)
+            x2, y2 = transform_point_simulation_to_canvas(x2, y2)
+            rate = float(rx_bytes)/count/self.sample_period
+            item = get_item()
+            item.set_properties(visibility=goocanvas.ITEM_VISIBLE, close_path=False, end_arrow=True,
+                                line_width=max(0.1, math.log(rate)*k), stroke_color_rgba=0x00C000C0,
+                                fill_color_rgba=0, points=goocanvas.Points([(x1, y1), (x2, y2)]))
+
+        self._lod_items = new_items + old_items
+
+    def _update_viewport(self):
+        """
+        Tell PyViz what part of the network is on screen; in large networks,
+        transmissions are then summed in a grid of LOD_CELL_PIXELS cells
+        instead of per pair of nodes. Called with the simulation lock held.
+        """
+        if len(self.nodes) < LOD_MIN_NODES:
+            cell_size = 0
+        else:
+            cell_size = transform_distance_canvas_to_simulation(LOD_CELL_PIXELS/self.zoom.value)
+        hadj = self._scrolled_window.get_hadjustment()
+        vadj = self._scrolled_window.get_vadjustment()
+        x1, y1 = transform_point_canvas_to_simulation(*self.canvas.convert_from_pixels(hadj.value, vadj.value))
+        x2, y2 = transform_point_canvas_to_simulation(*self.canvas.convert_from_pixels(hadj.value + hadj.page_size,
+                                                                                        vadj.value + vadj.page_size))
+        self._lod_cell_size = cell_size
+        self.simulation.sim_helper.SetViewport(x1, y1, x2, y2, cell_size)
 
 
     def _update_drops_view(self):
@@ -1094,6 +1177,7 @@ class Visualizer(gobject.GObject):
         self.simulation.pause_messages = []
         try:
             self.update_view()
+            self._update_viewport()
             self.simulation.target_time = ns.core.Simulator.Now ().GetSeconds () + self.sample_period
             #print "view: target time set to %f" % self.simulation.target_time
         finally:
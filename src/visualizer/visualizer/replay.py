@@ -0,0 +1,312 @@
+# -*- Mode: python; coding: utf-8 -*-
+"""
+Replay of a recording made by ns3::PyVizRecorder.
+
+The live visualizer needs the simulation in the same process; a recording
+can be watched anywhere, without ns-3, at any speed and from any time:
+
+  python src/visualizer/visualizer/replay.py run.pvzr
+  python src/visualizer/visualizer/replay.py --dump run.pvzr     # text, no GUI
+
+Nodes are drawn at their recorded positions, each frame's transmissions as
+lines from transmitter to receiver (thicker for more bytes), transmitters
+in blue and nodes that dropped packets in red.
+"""
+from __future__ import division, print_function
+
+import array
+import math
+import optparse
+import os
+import struct
+import sys
+
+MAGIC = b'PVZR'
+VERSION = 1
+FRAME_TAG = 1
+INDEX_TAG = 2
+
+# as in base.py, which can not be imported without the ns-3 bindings
+PIXELS_PER_METER = 3.0
+DEFAULT_NODE_SIZE = 3.0 # meters
+
+
+class Frame(object):
+    def __init__(self, time, xs, ys, tx, links, drops):
+        self.time = time    # seconds
+        self.xs = xs
+        self.ys = ys
+        self.tx = tx        # [(node, packets, bytes)]
+        self.links = links  # [(tx node, rx node, packets, bytes)]
+        self.drops = drops  # [(node, packets, bytes)]
+
+
+class Recording(object):
+    """Random access to the frames of a .pvzr file"""
+
+    def __init__(self, filename):
+        self.file = open(filename, 'rb')
+        head = self.file.read(4 + 4 + 8 + 4)
+        if len(head) < 20 or head[:4] != MAGIC:
+            raise ValueError("%s is not a PyVizRecorder file" % filename)
+        version, interval, n = struct.unpack('=IqI', head[4:])
+        if version != VERSION:
+            raise ValueError("%s: unsupported version %d" % (filename, version))
+        self.frame_interval = interval * 1e-9
+        self.node_ids = self._read_array('I', n)
+        self.index = {} # node id -> position in the frames
+        for i, node_id in enumerate(self.node_ids):
+            self.index[node_id] = i
+        self._frames_start = self.file.tell()
+        self.times, self.offsets = self._load_index()
+
+    def __len__(self):
+        return len(self.offsets)
+
+    def _read_array(self, typecode, count):
+        a = array.array(typecode)
+        data = self.file.read(a.itemsize * count)
+        if len(data) != a.itemsize * count:
+            raise EOFError
+        if hasattr(a, 'frombytes'):
+            a.frombytes(data)
+        else:
+            a.fromstring(data)
+        return a
+
+    def _read(self, fmt):
+        size = struct.calcsize(fmt)
+        data = self.file.read(size)
+        if len(data) != size:
+            raise EOFError
+        return struct.unpack(fmt, data)
+
+    def _load_index(self):
+        """The index written on close, or a scan of the frames if there is none"""
+        self.file.seek(0, os.SEEK_END)
+        end = self.file.tell()
+        if end >= self._frames_start + 8:
+            self.file.seek(end - 8)
+            index_offset, = self._read('=Q')
+            if self._frames_start <= index_offset < end - 8:
+                self.file.seek(index_offset)
+                tag, frames = self._read('=BI')
+                if tag == INDEX_TAG and index_offset + 5 + frames * 16 + 8 == end:
+                    # (time i64, offset u64) rows; offsets fit in an i64
+                    rows = self._read('=%dq' % (2 * frames))
+                    return [t * 1e-9 for t in rows[0::2]], list(rows[1::2])
+        # no index, the run did not end cleanly: scan
+        times, offsets = [], []
+        self.file.seek(self._frames_start)
+        while True:
+            offset = self.file.tell()
+            try:
+                frame = self._read_frame()
+            except EOFError:
+                break
+            if frame is None:
+                break
+            times.append(frame.time)
+            offsets.append(offset)
+        return times, offsets
+
+    def _read_frame(self):
+        tag, = self._read('=B')
+        if tag != FRAME_TAG:
+            return None
+        time, = self._read('=q')
+        xy = self._read_array('f', 2 * len(self.node_ids))
+        tx = self._read_rows(3)
+        links = self._read_rows(4)
+        drops = self._read_rows(3)
+        return Frame(time * 1e-9, xy[0::2], xy[1::2], tx, links, drops)
+
+    def _read_rows(self, columns):
+        count, = self._read('=I')
+        values = self._read_array('I', count * columns)
+        return [tuple(values[i:i + columns]) for i in range(0, len(values), columns)]
+
+    def frame(self, i):
+        self.file.seek(self.offsets[i])
+        return self._read_frame()
+
+    def find(self, time):
+        """Number of the last frame at or before time"""
+        lo, hi = 0, len(self.times)
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if self.times[mid] <= time:
+                lo = mid + 1
+            else:
+                hi = mid
+        return max(lo - 1, 0)
+
+    def bounds(self):
+        """(x1, y1, x2, y2) of the positions of the first frame"""
+        frame = self.frame(0)
+        xs = [x for x in frame.xs if not math.isnan(x)] or [0]
+        ys = [y for y in frame.ys if not math.isnan(y)] or [0]
+        return min(xs), min(ys), max(xs), max(ys)
+
+
+def dump(recording, out=sys.stdout):
+    print("%d nodes, %d frames, %g s apart" % (len(recording.node_ids), len(recording),
+                                                recording.frame_interval), file=out)
+    for i in range(len(recording)):
+        frame = recording.frame(i)
+        print("t=%.3f tx=%d links=%d drops=%d" % (
+            frame.time, sum(p for _, p, _ in frame.tx), len(frame.links),
+            sum(p for _, p, _ in frame.drops)), file=out)
+
+
+class ReplayWindow(object):
+    def __init__(self, recording):
+        import gtk
+        import goocanvas
+        import gobject
+        self.gtk, self.goocanvas, self.gobject = gtk, goocanvas, gobject
+        self.recording = recording
+        self.current = 0
+        self.speed = 1.0
+        self.timer = None
+
+        self.window = gtk.Window()
+        self.window.set_title("PyViz replay")
+        self.window.connect("destroy", lambda *args: gtk.main_quit())
+        vbox = gtk.VBox()
+        self.window.add(vbox)
+
+        self.canvas = goocanvas.Canvas()
+        self.canvas.set_size_request(800, 600)
+        sw = gtk.ScrolledWindow()
+        sw.add(self.canvas)
+        vbox.pack_start(sw, True, True, 4)
+        root = self.canvas.get_root_item()
+        self.links_group = goocanvas.Group(parent=root)
+        self.nodes_group = goocanvas.Group(parent=root)
+
+        radius = DEFAULT_NODE_SIZE * PIXELS_PER_METER
+        self.nodes = [goocanvas.Ellipse(parent=self.nodes_group, radius_x=radius, radius_y=radius,
+                                        fill_color="green", line_width=0.5, stroke_color="black")
+                      for _ in recording.node_ids]
+
+        hbox = gtk.HBox()
+        vbox.pack_start(hbox, False, False, 4)
+        self.play_button = gtk.ToggleButton(stock=gtk.STOCK_MEDIA_PLAY)
+        self.play_button.connect("toggled", self._on_play_toggled)
+        hbox.pack_start(self.play_button, False, False, 4)
+
+        hbox.pack_start(gtk.Label(" Speed:"), False, False, 4)
+        speed = gtk.SpinButton(gtk.Adjustment(1.0, 0.01, 100.0, 0.1, 1.0, 0), digits=2)
+        speed.connect("value-changed", self._on_speed_changed)
+        hbox.pack_start(speed, False, False, 4)
+
+        hbox.pack_start(gtk.Label(" Zoom:"), False, False, 4)
+        zoom = gtk.SpinButton(gtk.Adjustment(1.0, 0.01, 10.0, 0.02, 1.0, 0), digits=3)
+        zoom.connect("value-changed", lambda adj: self.canvas.set_scale(adj.get_value()))
+        hbox.pack_start(zoom, False, False, 4)
+
+        self.time_label = gtk.Label()
+        self.time_label.set_width_chars(16)
+        hbox.pack_start(self.time_label, False, False, 4)
+
+        self.position = gtk.Adjustment(0, 0, max(len(recording) - 1, 0), 1, 10, 0)
+        scale = gtk.HScale(self.position)
+        scale.set_draw_value(False)
+        self.position.connect("value-changed", self._on_position_changed)
+        hbox.pack_start(scale, True, True, 4)
+
+        x1, y1, x2, y2 = recording.bounds()
+        margin = 50
+        self.canvas.set_bounds(x1 * PIXELS_PER_METER - margin, y1 * PIXELS_PER_METER - margin,
+                               x2 * PIXELS_PER_METER + margin, y2 * PIXELS_PER_METER + margin)
+        self.window.show_all()
+        self.show(0)
+
+    def show(self, i):
+        self.current = i
+        frame = self.recording.frame(i)
+        self.time_label.set_text("Time: %.3f s" % frame.time)
+        transmitters = set(node for node, _, _ in frame.tx)
+        droppers = set(node for node, _, _ in frame.drops)
+        index = self.recording.index
+        for node_id, item, x, y in zip(self.recording.node_ids, self.nodes, frame.xs, frame.ys):
+            if math.isnan(x):
+                item.props.visibility = self.goocanvas.ITEM_INVISIBLE
+                continue
+            item.props.visibility = self.goocanvas.ITEM_VISIBLE
+            item.props.center_x = x * PIXELS_PER_METER
+            item.props.center_y = y * PIXELS_PER_METER
+            if node_id in droppers:
+                item.props.fill_color = "red"
+            elif node_id in transmitters:
+                item.props.fill_color = "blue"
+            else:
+                item.props.fill_color = "green"
+
+        while self.links_group.get_n_children():
+            self.links_group.remove_child(0)
+        for tx, rx, packets, nbytes in frame.links:
+            if tx not in index or rx not in index:
+                continue
+            a, b = index[tx], index[rx]
+            width = max(0.5, math.log(1 + nbytes / 100.0))
+            self.goocanvas.Polyline(parent=self.links_group, close_path=False,
+                                    points=self.goocanvas.Points([
+                                        (frame.xs[a] * PIXELS_PER_METER, frame.ys[a] * PIXELS_PER_METER),
+                                        (frame.xs[b] * PIXELS_PER_METER, frame.ys[b] * PIXELS_PER_METER)]),
+                                    line_width=width, stroke_color_rgba=0x0000C080,
+                                    end_arrow=True, arrow_tip_length=4, arrow_width=4)
+
+    def _on_position_changed(self, adj):
+        i = int(adj.get_value())
+        if i != self.current:
+            self.show(i)
+
+    def _on_speed_changed(self, spin):
+        self.speed = spin.get_value()
+        if self.timer is not None:
+            self._start_timer()
+
+    def _on_play_toggled(self, button):
+        if button.get_active():
+            self._start_timer()
+        elif self.timer is not None:
+            self.gobject.source_remove(self.timer)
+            self.timer = None
+
+    def _start_timer(self):
+        if self.timer is not None:
+            self.gobject.source_remove(self.timer)
+        period = max(1, int(self.recording.frame_interval * 1000 / self.speed))
+        self.timer = self.gobject.timeout_add(period, self._advance)
+
+    def _advance(self):
+        if self.current + 1 >= len(self.recording):
+            self.play_button.set_active(False)
+            return False
+        self.position.set_value(self.current + 1)
+        return True
+
+
+def main(argv):
+    parser = optparse.OptionParser(usage="%prog [--dump] FILE.pvzr", description=__doc__.split('\n\n')[0])
+    parser.add_option('--dump', action='store_true', help="print a summary of every frame instead of showing it")
+    options, args = parser.parse_args(argv)
+    if len(args) != 1:
+        parser.error("one recording expected")
+    recording = Recording(args[0])
+    if options.dump:
+        dump(recording)
+        return 0
+    if not len(recording):
+        print("%s has no frames" % args[0], file=sys.stderr)
+        return 1
+    import gtk
+    ReplayWindow(recording)
+    gtk.main()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
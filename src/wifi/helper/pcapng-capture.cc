@@ -0,0 +1,258 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "pcapng-capture.h"
+#include "ns3/simulator.h"
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cstring>
+
+NS_LOG_COMPONENT_DEFINE ("PcapNgCapture");
+
+namespace ns3 {
+
+/// Block types and options of the pcapng format
+enum
+{
+  PCAPNG_SECTION_HEADER = 0x0A0D0D0A,
+  PCAPNG_INTERFACE_DESCRIPTION = 0x00000001,
+  PCAPNG_ENHANCED_PACKET = 0x00000006,
+  PCAPNG_BYTE_ORDER_MAGIC = 0x1A2B3C4D,
+  PCAPNG_OPT_ENDOFOPT = 0,
+  PCAPNG_OPT_IF_NAME = 2,
+  PCAPNG_OPT_IF_TSRESOL = 9,
+};
+
+/// Bytes buffered before they are written to the file
+static const uint32_t PCAPNG_BUFFER_SIZE = 1024 * 1024;
+
+static uint32_t
+Pad4 (uint32_t length)
+{
+  return (length + 3) & ~3U;
+}
+
+PcapNgCapture::PcapNgCapture (std::string filename, uint32_t dataLinkType, uint32_t snapLen)
+  : m_filename (filename),
+    m_dataLinkType (dataLinkType),
+    m_snapLen (snapLen),
+    m_window (Seconds (0)),
+    m_udpPort (0),
+    m_interfaces (0)
+{
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary);
+  NS_ABORT_MSG_UNLESS (m_file.is_open (), "PcapNgCapture: could not open " << filename);
+  m_buffer.reserve (PCAPNG_BUFFER_SIZE);
+
+  // Section header: byte order magic, version 1.0, unknown section length
+  BeginBlock (PCAPNG_SECTION_HEADER, 16);
+  Put32 (PCAPNG_BYTE_ORDER_MAGIC);
+  Put16 (1);
+  Put16 (0);
+  Put32 (0xffffffff);
+  Put32 (0xffffffff);
+  EndBlock (16);
+
+  Simulator::ScheduleDestroy (&PcapNgCapture::Close, Ptr<PcapNgCapture> (this));
+}
+
+PcapNgCapture::~PcapNgCapture ()
+{
+  Close ();
+}
+
+void
+PcapNgCapture::SetRingBuffer (Time window)
+{
+  m_window = window;
+}
+
+void
+PcapNgCapture::SetUdpPortFilter (uint16_t port)
+{
+  m_udpPort = port;
+}
+
+uint32_t
+PcapNgCapture::GetDataLinkType (void) const
+{
+  return m_dataLinkType;
+}
+
+uint32_t
+PcapNgCapture::AddInterface (std::string name)
+{
+  NS_ASSERT (m_file.is_open ());
+  uint16_t nameLength = std::min<size_t> (name.size (), 0xffff);
+  uint8_t tsresol = 9;
+  uint32_t body = 8 + 4 + Pad4 (nameLength) + 4 + Pad4 (1) + 4;
+  BeginBlock (PCAPNG_INTERFACE_DESCRIPTION, body);
+  Put16 (m_dataLinkType);
+  Put16 (0);
+  Put32 (m_snapLen);
+  PutOption (PCAPNG_OPT_IF_NAME, name.data (), nameLength);
+  PutOption (PCAPNG_OPT_IF_TSRESOL, &tsresol, 1);
+  PutOption (PCAPNG_OPT_ENDOFOPT, 0, 0);
+  EndBlock (body);
+  return m_interfaces++;
+}
+
+bool
+PcapNgCapture::IsCaptured (Ptr<const Packet> macFrame) const
+{
+  if (!m_file.is_open ())
+    {
+      return false;
+    }
+  if (m_udpPort == 0)
+    {
+      return true;
+    }
+  uint8_t bytes[96];
+  uint32_t size = macFrame->CopyData (bytes, sizeof (bytes));
+  // 802.11 data frame, optionally QoS and with four addresses
+  if (size < 24 || ((bytes[0] >> 2) & 0x3) != 2)
+    {
+      return false;
+    }
+  uint32_t offset = 24;
+  if ((bytes[1] & 0x3) == 0x3)
+    {
+      offset += 6;
+    }
+  if (bytes[0] & 0x80)
+    {
+      offset += 2;
+    }
+  // LLC/SNAP carrying IPv4
+  if (size < offset + 8 + 20 || bytes[offset + 6] != 0x08 || bytes[offset + 7] != 0x00)
+    {
+      return false;
+    }
+  offset += 8;
+  uint32_t ihl = (bytes[offset] & 0x0f) * 4;
+  if (bytes[offset + 9] != 17 || size < offset + ihl + 4)
+    {
+      return false;
+    }
+  offset += ihl;
+  uint16_t src = (bytes[offset] << 8) | bytes[offset + 1];
+  uint16_t dst = (bytes[offset + 2] << 8) | bytes[offset + 3];
+  return src == m_udpPort || dst == m_udpPort;
+}
+
+void
+PcapNgCapture::Write (uint32_t interface, Ptr<const Packet> p)
+{
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  Frame frame;
+  frame.time = Simulator::Now ().GetNanoSeconds ();
+  frame.interface = interface;
+  frame.length = p->GetSize ();
+  frame.data.resize (std::min (frame.length, m_snapLen));
+  p->CopyData (frame.data.empty () ? 0 : &frame.data[0], frame.data.size ());
+
+  if (!m_window.IsStrictlyPositive ())
+    {
+      WriteFrame (frame);
+      return;
+    }
+  m_ring.push_back (Frame ());
+  m_ring.back ().time = frame.time;
+  m_ring.back ().interface = frame.interface;
+  m_ring.back ().length = frame.length;
+  m_ring.back ().data.swap (frame.data);
+  int64_t oldest = frame.time - m_window.GetNanoSeconds ();
+  while (m_ring.front ().time < oldest)
+    {
+      m_ring.pop_front ();
+    }
+}
+
+void
+PcapNgCapture::WriteFrame (const Frame &frame)
+{
+  uint32_t captured = frame.data.size ();
+  uint32_t body = 20 + Pad4 (captured);
+  BeginBlock (PCAPNG_ENHANCED_PACKET, body);
+  Put32 (frame.interface);
+  Put32 (static_cast<uint64_t> (frame.time) >> 32);
+  Put32 (static_cast<uint64_t> (frame.time) & 0xffffffff);
+  Put32 (captured);
+  Put32 (frame.length);
+  m_buffer.insert (m_buffer.end (), frame.data.begin (), frame.data.end ());
+  m_buffer.resize (m_buffer.size () + Pad4 (captured) - captured, 0);
+  EndBlock (body);
+  FlushBuffer (false);
+}
+
+void
+PcapNgCapture::BeginBlock (uint32_t type, uint32_t bodyLength)
+{
+  Put32 (type);
+  Put32 (bodyLength + 12);
+}
+
+void
+PcapNgCapture::EndBlock (uint32_t bodyLength)
+{
+  Put32 (bodyLength + 12);
+}
+
+void
+PcapNgCapture::Put16 (uint16_t value)
+{
+  uint8_t *bytes = reinterpret_cast<uint8_t *> (&value);
+  m_buffer.insert (m_buffer.end (), bytes, bytes + sizeof (value));
+}
+
+void
+PcapNgCapture::Put32 (uint32_t value)
+{
+  uint8_t *bytes = reinterpret_cast<uint8_t *> (&value);
+  m_buffer.insert (m_buffer.end (), bytes, bytes + sizeof (value));
+}
+
+void
+PcapNgCapture::PutOption (uint16_t code, const void *data, uint16_t length)
+{
+  Put16 (code);
+  Put16 (length);
+  const uint8_t *bytes = static_cast<const uint8_t *> (data);
+  m_buffer.insert (m_buffer.end (), bytes, bytes + length);
+  m_buffer.resize (m_buffer.size () + Pad4 (length) - length, 0);
+}
+
+void
+PcapNgCapture::FlushBuffer (bool force)
+{
+  if (m_buffer.empty () || (!force && m_buffer.size () < PCAPNG_BUFFER_SIZE))
+    {
+      return;
+    }
+  m_file.write (reinterpret_cast<const char *> (&m_buffer[0]), m_buffer.size ());
+  m_buffer.clear ();
+}
+
+void
+PcapNgCapture::Close (void)
+{
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  for (std::deque<Frame>::const_iterator i = m_ring.begin (); i != m_ring.end (); ++i)
+    {
+      WriteFrame (*i);
+    }
+  m_ring.clear ();
+  FlushBuffer (true);
+  m_file.close ();
+  NS_LOG_DEBUG ("Closed " << m_filename << " with " << m_interfaces << " interfaces");
+}
+
+} // namespace ns3
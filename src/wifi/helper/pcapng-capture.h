@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef PCAPNG_CAPTURE_H
+#define PCAPNG_CAPTURE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <stdint.h>
+#include "ns3/simple-ref-count.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \brief A single pcapng capture file shared by many devices
+ *
+ * Each device is a pcapng interface with its own interface ID, so one file
+ * replaces the per-device pcap files and can still be split by device in
+ * Wireshark. Blocks are assembled in memory and written in large chunks.
+ *
+ * Optionally:
+ * - frames are truncated to a snapshot length;
+ * - only the frames of the last RingBuffer seconds are kept in memory and
+ *   written when the capture is closed ("what led to this" captures);
+ * - only UDP frames to or from one port are captured, e.g. GPSR control
+ *   traffic with gpsr::RoutingProtocol::GPSR_PORT.
+ *
+ * Timestamps have nanosecond resolution. The capture is closed by
+ * Simulator::Destroy.
+ */
+class PcapNgCapture : public SimpleRefCount<PcapNgCapture>
+{
+public:
+  /**
+   * \param filename file to write
+   * \param dataLinkType a PcapHelper::DataLinkType, the same for all interfaces
+   * \param snapLen frames are truncated to this many bytes
+   */
+  PcapNgCapture (std::string filename, uint32_t dataLinkType, uint32_t snapLen = 65535);
+  ~PcapNgCapture ();
+
+  /// Only keep the frames of the last window, zero to keep everything
+  void SetRingBuffer (Time window);
+  /// Only capture UDP datagrams from or to port, zero to capture everything
+  void SetUdpPortFilter (uint16_t port);
+
+  uint32_t GetDataLinkType (void) const;
+
+  /// Declare an interface, \return its interface ID
+  uint32_t AddInterface (std::string name);
+  /**
+   * \param macFrame an 802.11 frame, without any radiotap header
+   * \return false if the frame is filtered out
+   */
+  bool IsCaptured (Ptr<const Packet> macFrame) const;
+  /**
+   * \param interface ID returned by AddInterface
+   * \param p frame, starting with the link-layer header given by the data link type
+   */
+  void Write (uint32_t interface, Ptr<const Packet> p);
+
+  /// Write what is buffered and close the file
+  void Close (void);
+
+private:
+  struct Frame
+  {
+    int64_t time;
+    uint32_t interface;
+    uint32_t length;
+    std::vector<uint8_t> data;
+  };
+
+  void WriteFrame (const Frame &frame);
+  void BeginBlock (uint32_t type, uint32_t bodyLength);
+  void EndBlock (uint32_t bodyLength);
+  void Put16 (uint16_t value);
+  void Put32 (uint32_t value);
+  void PutOption (uint16_t code, const void *data, uint16_t length);
+  void FlushBuffer (bool force);
+
+  std::ofstream m_file;
+  std::string m_filename;
+  uint32_t m_dataLinkType;
+  uint32_t m_snapLen;
+  Time m_window;
+  uint16_t m_udpPort;
+  uint32_t m_interfaces;
+  std::vector<uint8_t> m_buffer;
+  std::deque<Frame> m_ring;
+};
+
+} // namespace ns3
+
+#endif /* PCAPNG_CAPTURE_H */
@@ -245,6 +245,55 @@ YansWifiPhyHelper::Create (Ptr<Node> node, Ptr<WifiNetDevice> device) const
   return phy;
 }
 
+static RadiotapHeader
+GetRadiotapHeader (
+  uint16_t channelFreqMhz,
+  uint32_t rate,
+  bool isShortPreamble)
+{
+  RadiotapHeader header;
+  uint8_t frameFlags = RadiotapHeader::FRAME_FLAG_NONE;
+  header.SetTsft (Simulator::Now ().GetMicroSeconds ());
+
+  // Our capture includes the FCS, so we set the flag to say so.
+  frameFlags |= RadiotapHeader::FRAME_FLAG_FCS_INCLUDED;
+
+  if (isShortPreamble)
+    {
+      frameFlags |= RadiotapHeader::FRAME_FLAG_SHORT_PREAMBLE;
+    }
+
+  header.SetFrameFlags (frameFlags);
+  header.SetRate (rate);
+
+  uint16_t channelFlags = 0;
+  switch (rate)
+    {
+    case 2:  // 1Mbps
+    case 4:  // 2Mbps
+    case 10: // 5Mbps
+    case 22: // 11Mbps
+      channelFlags |= RadiotapHeader::CHANNEL_FLAG_CCK;
+      break;
+
+    default:
+      channelFlags |= RadiotapHeader::CHANNEL_FLAG_OFDM;
+      break;
+    }
+
+  if (channelFreqMhz < 2500)
+    {
+      channelFlags |= RadiotapHeader::CHANNEL_FLAG_SPECTRUM_2GHZ;
+    }
+  else
+    {
+      channelFlags |= RadiotapHeader::CHANNEL_FLAG_SPECTRUM_5GHZ;
+    }
+
+  header.SetChannelFrequencyAndFlags (channelFreqMhz, channelFlags);
+  return header;
+}
+
 static void
 PcapSniffTxEvent (
   Ptr<PcapFileWrapper> file,
@@ -270,48 +319,7 @@ PcapSniffTxEvent (
     case PcapHelper::DLT_IEEE802_11_RADIO:
       {
         Ptr<Packet> p = packet->Copy ();
-        RadiotapHeader header;
-        uint8_t frameFlags = RadiotapHeader::FRAME_FLAG_NONE;
-        header.SetTsft (Simulator::Now ().GetMicroSeconds ());
-
-        // Our capture includes the FCS, so we set the flag to say so.
-        frameFlags |= RadiotapHeader::FRAME_FLAG_FCS_INCLUDED;
-
-        if (isShortPreamble)
-          {
-            frameFlags |= RadiotapHeader::FRAME_FLAG_SHORT_PREAMBLE;
-          }
-
-        header.SetFrameFlags (frameFlags);
-        header.SetRate (rate);
-
-        uint16_t channelFlags = 0;
-        switch (rate)
-          {
-          case 2:  // 1Mbps
-          case 4:  // 2Mbps
-          case 10: // 5Mbps
-          case 22: // 11Mbps
-            channelFlags |= RadiotapHeader::CHANNEL_FLAG_CCK;
-            break;
-
-          default:
-            channelFlags |= RadiotapHeader::CHANNEL_FLAG_OFDM;
-            break;
-          }
-
-        if (channelFreqMhz < 2500)
-          {
-            channelFlags |= RadiotapHeader::CHANNEL_FLAG_SPECTRUM_2GHZ;
-          }
-        else
-          {
-            channelFlags |= RadiotapHeader::CHANNEL_FLAG_SPECTRUM_5GHZ;
-          }
-
-        header.SetChannelFrequencyAndFlags (channelFreqMhz, channelFlags);
-        
-
+        RadiotapHeader header = GetRadiotapHeader (channelFreqMhz, rate, isShortPreamble);
         p->AddHeader (header);
         file->Write (Simulator::Now (), p);
         return;
@@ -347,47 +355,7 @@ PcapSniffRxEvent (
     case PcapHelper::DLT_IEEE802_11_RADIO:
       {
         Ptr<Packet> p = packet->Copy ();
-        RadiotapHeader header;
-        uint8_t frameFlags = RadiotapHeader::FRAME_FLAG_NONE;
-        header.SetTsft (Simulator::Now ().GetMicroSeconds ());
-
-        // Our capture includes the FCS, so we set the flag to say so.
-        frameFlags |= RadiotapHeader::FRAME_FLAG_FCS_INCLUDED;
-
-        if (isShortPreamble)
-          {
-            frameFlags |= RadiotapHeader::FRAME_FLAG_SHORT_PREAMBLE;
-          }
-
-        header.SetFrameFlags (frameFlags);
-        header.SetRate (rate);
-
-        uint16_t channelFlags = 0;
-        switch (rate)
-          {
-          case 2:  // 1Mbps
-          case 4:  // 2Mbps
-          case 10: // 5Mbps
-          case 22: // 11Mbps
-            channelFlags |= RadiotapHeader::CHANNEL_FLAG_CCK;
-            break;
-
-          default:
-            channelFlags |= RadiotapHeader::CHANNEL_FLAG_OFDM;
-            break;
-          }
-
-        if (channelFreqMhz < 2500)
-          {
-            channelFlags |= RadiotapHeader::CHANNEL_FLAG_SPECTRUM_2GHZ;
-          }
-        else
-          {
-            channelFlags |= RadiotapHeader::CHANNEL_FLAG_SPECTRUM_5GHZ;
-          }
-
-        header.SetChannelFrequencyAndFlags (channelFreqMhz, channelFlags);
-
+        RadiotapHeader header = GetRadiotapHeader (channelFreqMhz, rate, isShortPreamble);
         header.SetAntennaSignalPower (signalDbm);
         header.SetAntennaNoisePower (noiseDbm);
 
@@ -400,6 +368,66 @@ PcapSniffRxEvent (
     }
 }
 
+/// A device of a consolidated capture
+struct PcapNgInterface : public SimpleRefCount<PcapNgInterface>
+{
+  Ptr<PcapNgCapture> capture;
+  uint32_t id;
+};
+
+static void
+PcapNgSniffTxEvent (
+  Ptr<PcapNgInterface> iface,
+  Ptr<const Packet>   packet,
+  uint16_t            channelFreqMhz,
+  uint16_t            channelNumber,
+  uint32_t            rate,
+  bool                isShortPreamble,
+  uint8_t             txPower)
+{
+  if (!iface->capture->IsCaptured (packet))
+    {
+      return;
+    }
+  if (iface->capture->GetDataLinkType () == PcapHelper::DLT_IEEE802_11_RADIO)
+    {
+      Ptr<Packet> p = packet->Copy ();
+      RadiotapHeader header = GetRadiotapHeader (channelFreqMhz, rate, isShortPreamble);
+      p->AddHeader (header);
+      iface->capture->Write (iface->id, p);
+      return;
+    }
+  iface->capture->Write (iface->id, packet);
+}
+
+static void
+PcapNgSniffRxEvent (
+  Ptr<PcapNgInterface> iface,
+  Ptr<const Packet> packet,
+  uint16_t channelFreqMhz,
+  uint16_t channelNumber,
+  uint32_t rate,
+  bool isShortPreamble,
+  double signalDbm,
+  double noiseDbm)
+{
+  if (!iface->capture->IsCaptured (packet))
+    {
+      return;
+    }
+  if (iface->capture->GetDataLinkType () == PcapHelper::DLT_IEEE802_11_RADIO)
+    {
+      Ptr<Packet> p = packet->Copy ();
+      RadiotapHeader header = GetRadiotapHeader (channelFreqMhz, rate, isShortPreamble);
+      header.SetAntennaSignalPower (signalDbm);
+      header.SetAntennaNoisePower (noiseDbm);
+      p->AddHeader (header);
+      iface->capture->Write (iface->id, p);
+      return;
+    }
+  iface->capture->Write (iface->id, packet);
+}
+
 void
 YansWifiPhyHelper::SetPcapDataLinkType (enum SupportedPcapDataLinkTypes dlt)
 {
@@ -419,6 +447,15 @@ YansWifiPhyHelper::SetPcapDataLinkType (enum SupportedPcapDataLinkTypes dlt)
     }
 }
 
+Ptr<PcapNgCapture>
+YansWifiPhyHelper::EnablePcapCapture (std::string filename, uint32_t snapLen)
+{
+  NS_ABORT_MSG_IF (m_pcapDlt == PcapHelper::DLT_PRISM_HEADER,
+                   "YansWifiPhyHelper::EnablePcapCapture(): DLT_PRISM_HEADER not implemented");
+  m_pcapCapture = Create<PcapNgCapture> (filename, m_pcapDlt, snapLen);
+  return m_pcapCapture;
+}
+
 void
 YansWifiPhyHelper::EnablePcapInternal (std::string prefix, Ptr<NetDevice> nd, bool promiscuous, bool explicitFilename)
 {
@@ -449,6 +486,16 @@ YansWifiPhyHelper::EnablePcapInternal (std::string prefix, Ptr<NetDevice> nd, bo
       filename = pcapHelper.GetFilenameFromDevice (prefix, device);
     }
 
+  if (m_pcapCapture != 0)
+    {
+      Ptr<PcapNgInterface> iface = Create<PcapNgInterface> ();
+      iface->capture = m_pcapCapture;
+      iface->id = m_pcapCapture->AddInterface (filename);
+      phy->TraceConnectWithoutContext ("MonitorSnifferTx", MakeBoundCallback (&PcapNgSniffTxEvent, iface));
+      phy->TraceConnectWithoutContext ("MonitorSnifferRx", MakeBoundCallback (&PcapNgSniffRxEvent, iface));
+      return;
+    }
+
   Ptr<PcapFileWrapper> file = pcapHelper.CreateFile (filename, std::ios::out, m_pcapDlt);
 
   phy->TraceConnectWithoutContext ("MonitorSnifferTx", MakeBoundCallback (&PcapSniffTxEvent, file));
@@ -24,6 +24,7 @@
 #include "ns3/trace-helper.h"
 #include "ns3/yans-wifi-channel.h"
 #include "ns3/deprecated.h"
+#include "ns3/pcapng-capture.h"
 
 namespace ns3 {
 
@@ -244,6 +245,17 @@ public:
    */
   void SetPcapDataLinkType (enum SupportedPcapDataLinkTypes dlt);
 
+  /**
+   * Write the devices passed to the following EnablePcap calls into a
+   * single pcapng file, one interface per device, instead of one pcap file
+   * per device. The data link type must be set before.
+   *
+   * \param filename the pcapng file
+   * \param snapLen frames are truncated to this many bytes
+   * \returns the capture, to set a ring buffer or a filter on it
+   */
+  Ptr<PcapNgCapture> EnablePcapCapture (std::string filename, uint32_t snapLen = 65535);
+
 private:
   /**
    * \param node the node on which we wish to create a wifi PHY
@@ -291,6 +303,7 @@ private:
   ObjectFactory m_errorRateModel;
   Ptr<YansWifiChannel> m_channel;
   uint32_t m_pcapDlt;
+  Ptr<PcapNgCapture> m_pcapCapture;
 };
 
 } // namespace ns3
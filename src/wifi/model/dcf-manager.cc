@@ -275,6 +275,11 @@ DcfManager::DcfManager ()
     m_lastSwitchingStart (MicroSeconds (0)),
     m_lastSwitchingDuration (MicroSeconds (0)),
     m_rxing (false),
+    m_accessGrantStart (MicroSeconds (0)),
+    m_accessTimeoutEnd (MicroSeconds (0)),
+    m_accessTimeoutsScheduled (0),
+    m_accessTimeoutsCancelled (0),
+    m_accessTimeoutsIdle (0),
     m_slotTimeUs (0),
     m_sifs (Seconds (0.0)),
     m_phyListener (0),
@@ -285,6 +290,9 @@ DcfManager::DcfManager ()
 
 DcfManager::~DcfManager ()
 {
+  NS_LOG_INFO ("access timeouts: scheduled=" << m_accessTimeoutsScheduled <<
+               ", cancelled=" << m_accessTimeoutsCancelled <<
+               ", idle=" << m_accessTimeoutsIdle);
   delete m_phyListener;
   delete m_lowListener;
   m_phyListener = 0;
@@ -325,12 +333,14 @@ DcfManager::SetSifs (Time sifs)
 {
   NS_LOG_FUNCTION (this << sifs);
   m_sifs = sifs;
+  UpdateAccessGrantStart ();
 }
 void
 DcfManager::SetEifsNoDifs (Time eifsNoDifs)
 {
   NS_LOG_FUNCTION (this << eifsNoDifs);
   m_eifsNoDifs = eifsNoDifs;
+  UpdateAccessGrantStart ();
 }
 Time
 DcfManager::GetEifsNoDifs () const
@@ -443,7 +453,23 @@ DcfManager::RequestAccess (DcfState *state)
   DoRestartAccessTimeoutIfNeeded ();
 }
 
-void
+uint64_t
+DcfManager::GetScheduledAccessTimeouts (void) const
+{
+  return m_accessTimeoutsScheduled;
+}
+uint64_t
+DcfManager::GetCancelledAccessTimeouts (void) const
+{
+  return m_accessTimeoutsCancelled;
+}
+uint64_t
+DcfManager::GetIdleAccessTimeouts (void) const
+{
+  return m_accessTimeoutsIdle;
+}
+
+bool
 DcfManager::DoGrantAccess (void)
 {
   NS_LOG_FUNCTION (this);
@@ -492,10 +518,11 @@ DcfManager::DoGrantAccess (void)
             {
               (*k)->NotifyInternalCollision ();
             }
-          break;
+          return true;
         }
       i++;
     }
+  return false;
 }
 
 void
@@ -503,12 +530,28 @@ DcfManager::AccessTimeout (void)
 {
   NS_LOG_FUNCTION (this);
   UpdateBackoff ();
-  DoGrantAccess ();
+  if (!DoGrantAccess ())
+    {
+      /**
+       * The medium got busy after the timeout was scheduled, which
+       * moved every backoff end later. The timeout is left to expire
+       * rather than being moved on every busy notification: it only
+       * needs to be scheduled again, for the new backoff end.
+       */
+      MY_DEBUG ("access timeout expired before any backoff end");
+      m_accessTimeoutsIdle++;
+    }
   DoRestartAccessTimeoutIfNeeded ();
 }
 
 Time
 DcfManager::GetAccessGrantStart (void) const
+{
+  return m_accessGrantStart;
+}
+
+void
+DcfManager::UpdateAccessGrantStart (void)
 {
   NS_LOG_FUNCTION (this);
   Time rxAccessStart;
@@ -543,17 +586,14 @@ DcfManager::GetAccessGrantStart (void) const
                ", busy access start=" << busyAccessStart <<
                ", tx access start=" << txAccessStart <<
                ", nav access start=" << navAccessStart);
-  return accessGrantedStart;
+  m_accessGrantStart = accessGrantedStart;
 }
 
 Time
 DcfManager::GetBackoffStartFor (DcfState *state)
 {
-  NS_LOG_FUNCTION (this << state);
-  Time mostRecentEvent = MostRecent (state->GetBackoffStart (),
-                                     GetAccessGrantStart () + MicroSeconds (state->GetAifsn () * m_slotTimeUs));
-
-  return mostRecentEvent;
+  return Max (state->GetBackoffStart (),
+              m_accessGrantStart + MicroSeconds (state->GetAifsn () * m_slotTimeUs));
 }
 
 Time
@@ -566,15 +606,16 @@ void
 DcfManager::UpdateBackoff (void)
 {
   NS_LOG_FUNCTION (this);
+  Time now = Simulator::Now ();
   uint32_t k = 0;
   for (States::const_iterator i = m_states.begin (); i != m_states.end (); i++, k++)
     {
       DcfState *state = *i;
 
       Time backoffStart = GetBackoffStartFor (state);
-      if (backoffStart <= Simulator::Now ())
+      if (backoffStart <= now)
         {
-          uint32_t nus = (Simulator::Now () - backoffStart).GetMicroSeconds ();
+          uint32_t nus = (now - backoffStart).GetMicroSeconds ();
           uint32_t nIntSlots = nus / m_slotTimeUs;
           uint32_t n = std::min (nIntSlots, state->GetBackoffSlots ());
           MY_DEBUG ("dcf " << k << " dec backoff slots=" << n);
@@ -593,6 +634,7 @@ DcfManager::DoRestartAccessTimeoutIfNeeded (void)
    * if there is one, how many slots for AIFS+backoff does it require ?
    */
   bool accessTimeoutNeeded = false;
+  Time now = Simulator::Now ();
   Time expectedBackoffEnd = Simulator::GetMaximumSimulationTime ();
   for (States::const_iterator i = m_states.begin (); i != m_states.end (); i++)
     {
@@ -600,7 +642,7 @@ DcfManager::DoRestartAccessTimeoutIfNeeded (void)
       if (state->IsAccessRequested ())
         {
           Time tmp = GetBackoffEndFor (state);
-          if (tmp > Simulator::Now ())
+          if (tmp > now)
             {
               accessTimeoutNeeded = true;
               expectedBackoffEnd = std::min (expectedBackoffEnd, tmp);
@@ -610,16 +652,24 @@ DcfManager::DoRestartAccessTimeoutIfNeeded (void)
   if (accessTimeoutNeeded)
     {
       MY_DEBUG ("expected backoff end=" << expectedBackoffEnd);
-      Time expectedBackoffDelay = expectedBackoffEnd - Simulator::Now ();
-      if (m_accessTimeout.IsRunning ()
-          && Simulator::GetDelayLeft (m_accessTimeout) > expectedBackoffDelay)
+      /**
+       * A pending timeout is only moved when it would expire too late.
+       * One which expires too early is kept: AccessTimeout then finds
+       * no backoff ended and comes back here.
+       */
+      bool running = m_accessTimeout.IsRunning ();
+      if (running && m_accessTimeoutEnd > expectedBackoffEnd)
         {
           m_accessTimeout.Cancel ();
+          m_accessTimeoutsCancelled++;
+          running = false;
         }
-      if (m_accessTimeout.IsExpired ())
+      if (!running)
         {
-          m_accessTimeout = Simulator::Schedule (expectedBackoffDelay,
+          m_accessTimeoutEnd = expectedBackoffEnd;
+          m_accessTimeout = Simulator::Schedule (expectedBackoffEnd - now,
                                                  &DcfManager::AccessTimeout, this);
+          m_accessTimeoutsScheduled++;
         }
     }
 }
@@ -633,6 +683,7 @@ DcfManager::NotifyRxStartNow (Time duration)
   m_lastRxStart = Simulator::Now ();
   m_lastRxDuration = duration;
   m_rxing = true;
+  UpdateAccessGrantStart ();
 }
 void
 DcfManager::NotifyRxEndOkNow (void)
@@ -642,6 +693,7 @@ DcfManager::NotifyRxEndOkNow (void)
   m_lastRxEnd = Simulator::Now ();
   m_lastRxReceivedOk = true;
   m_rxing = false;
+  UpdateAccessGrantStart ();
 }
 void
 DcfManager::NotifyRxEndErrorNow (void)
@@ -651,6 +703,7 @@ DcfManager::NotifyRxEndErrorNow (void)
   m_lastRxEnd = Simulator::Now ();
   m_lastRxReceivedOk = false;
   m_rxing = false;
+  UpdateAccessGrantStart ();
 }
 void
 DcfManager::NotifyTxStartNow (Time duration)
@@ -666,11 +719,13 @@ DcfManager::NotifyTxStartNow (Time duration)
       m_lastRxDuration = m_lastRxEnd - m_lastRxStart;
       m_lastRxReceivedOk = true;
       m_rxing = false;
+      UpdateAccessGrantStart ();
     }
   MY_DEBUG ("tx start for " << duration);
   UpdateBackoff ();
   m_lastTxStart = Simulator::Now ();
   m_lastTxDuration = duration;
+  UpdateAccessGrantStart ();
 }
 void
 DcfManager::NotifyMaybeCcaBusyStartNow (Time duration)
@@ -680,6 +735,7 @@ DcfManager::NotifyMaybeCcaBusyStartNow (Time duration)
   UpdateBackoff ();
   m_lastBusyStart = Simulator::Now ();
   m_lastBusyDuration = duration;
+  UpdateAccessGrantStart ();
 }
 
 
@@ -720,6 +776,7 @@ DcfManager::NotifySwitchingStartNow (Time duration)
   if (m_accessTimeout.IsRunning ())
     {
       m_accessTimeout.Cancel ();
+      m_accessTimeoutsCancelled++;
     }
 
   // Reset backoffs
@@ -740,7 +797,7 @@ DcfManager::NotifySwitchingStartNow (Time duration)
   MY_DEBUG ("switching start for " << duration);
   m_lastSwitchingStart = Simulator::Now ();
   m_lastSwitchingDuration = duration;
-
+  UpdateAccessGrantStart ();
 }
 
 void
@@ -751,6 +808,7 @@ DcfManager::NotifyNavResetNow (Time duration)
   UpdateBackoff ();
   m_lastNavStart = Simulator::Now ();
   m_lastNavDuration = duration;
+  UpdateAccessGrantStart ();
   UpdateBackoff ();
   /**
    * If the nav reset indicates an end-of-nav which is earlier
@@ -773,6 +831,7 @@ DcfManager::NotifyNavStartNow (Time duration)
     {
       m_lastNavStart = Simulator::Now ();
       m_lastNavDuration = duration;
+      UpdateAccessGrantStart ();
     }
 }
 void
@@ -781,12 +840,14 @@ DcfManager::NotifyAckTimeoutStartNow (Time duration)
   NS_LOG_FUNCTION (this << duration);
   NS_ASSERT (m_lastAckTimeoutEnd < Simulator::Now ());
   m_lastAckTimeoutEnd = Simulator::Now () + duration;
+  UpdateAccessGrantStart ();
 }
 void
 DcfManager::NotifyAckTimeoutResetNow ()
 {
   NS_LOG_FUNCTION (this);
   m_lastAckTimeoutEnd = Simulator::Now ();
+  UpdateAccessGrantStart ();
   DoRestartAccessTimeoutIfNeeded ();
 }
 void
@@ -794,12 +855,14 @@ DcfManager::NotifyCtsTimeoutStartNow (Time duration)
 {
   NS_LOG_FUNCTION (this << duration);
   m_lastCtsTimeoutEnd = Simulator::Now () + duration;
+  UpdateAccessGrantStart ();
 }
 void
 DcfManager::NotifyCtsTimeoutResetNow ()
 {
   NS_LOG_FUNCTION (this);
   m_lastCtsTimeoutEnd = Simulator::Now ();
+  UpdateAccessGrantStart ();
   DoRestartAccessTimeoutIfNeeded ();
 }
 } // namespace ns3
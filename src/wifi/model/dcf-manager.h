@@ -295,6 +295,21 @@ public:
    */
   void RequestAccess (DcfState *state);
 
+  /**
+   * \return the number of access timeout events scheduled so far
+   */
+  uint64_t GetScheduledAccessTimeouts (void) const;
+  /**
+   * \return the number of access timeout events cancelled before they
+   *         expired, to be scheduled again earlier
+   */
+  uint64_t GetCancelledAccessTimeouts (void) const;
+  /**
+   * \return the number of access timeout events which expired without
+   *         any backoff having ended, because the medium got busy
+   */
+  uint64_t GetIdleAccessTimeouts (void) const;
+
   /**
    * \param duration expected duration of reception
    *
@@ -431,6 +446,13 @@ private:
    * be granted
    */
   Time GetAccessGrantStart (void) const;
+  /**
+   * Recompute the access grant start from the last rx, tx, busy, nav,
+   * ack/cts timeout and switching times. Called whenever one of them
+   * changes, so that the per-DcfState backoff computations, which run on
+   * every notification, read a single value.
+   */
+  void UpdateAccessGrantStart (void);
   /**
    * Return the time when the backoff procedure
    * started for the given DcfState.
@@ -455,8 +477,10 @@ private:
   void AccessTimeout (void);
   /**
    * Grant access to DCF
+   *
+   * \return true if a DcfState was granted access
    */
-  void DoGrantAccess (void);
+  bool DoGrantAccess (void);
   /**
    * Check if the device is busy sending or receiving,
    * or NAV busy.
@@ -487,8 +511,13 @@ private:
   Time m_lastSwitchingStart;
   Time m_lastSwitchingDuration;
   bool m_rxing;
+  Time m_accessGrantStart; //!< cached by UpdateAccessGrantStart
   Time m_eifsNoDifs;
   EventId m_accessTimeout;
+  Time m_accessTimeoutEnd; //!< expiry time of m_accessTimeout
+  uint64_t m_accessTimeoutsScheduled;
+  uint64_t m_accessTimeoutsCancelled;
+  uint64_t m_accessTimeoutsIdle;
   uint32_t m_slotTimeUs;
   Time m_sifs;
   PhyListener* m_phyListener;
@@ -156,22 +156,23 @@ MinstrelWifiManager::AssignStreams (int64_t stream)
 Time
 MinstrelWifiManager::GetCalcTxTime (WifiMode mode) const
 {
-
-  for (TxTime::const_iterator i = m_calcTxTime.begin (); i != m_calcTxTime.end (); i++)
-    {
-      if (mode == i->second)
-        {
-          return i->first;
-        }
-    }
-  NS_ASSERT (false);
-  return Seconds (0);
+  uint32_t uid = mode.GetUid ();
+  NS_ASSERT (uid < m_calcTxTime.size () && !m_calcTxTime[uid].IsNegative ());
+  return m_calcTxTime[uid];
 }
 
 void
 MinstrelWifiManager::AddCalcTxTime (WifiMode mode, Time t)
 {
-  m_calcTxTime.push_back (std::make_pair (t, mode));
+  uint32_t uid = mode.GetUid ();
+  if (uid >= m_calcTxTime.size ())
+    {
+      m_calcTxTime.resize (uid + 1, Seconds (-1));
+    }
+  if (m_calcTxTime[uid].IsNegative ())
+    {
+      m_calcTxTime[uid] = t;
+    }
 }
 
 WifiRemoteStation *
@@ -211,7 +212,7 @@ MinstrelWifiManager::CheckInit (MinstrelWifiRemoteStation *station)
       // before we perform our own initialization.
       m_nsupported = GetNSupported (station);
       m_minstrelTable = MinstrelRate (m_nsupported);
-      m_sampleTable = SampleRate (m_nsupported, std::vector<uint32_t> (m_sampleCol));
+      m_sampleTable = SampleRate (m_nsupported * (uint32_t) m_sampleCol, 0);
       InitSampleTable (station);
       RateInit (station);
       station->m_initialized = true;
@@ -473,7 +474,7 @@ uint32_t
 MinstrelWifiManager::GetNextSample (MinstrelWifiRemoteStation *station)
 {
   uint32_t bitrate;
-  bitrate = m_sampleTable[station->m_index][station->m_col];
+  bitrate = m_sampleTable[station->m_index * (uint32_t) m_sampleCol + station->m_col];
   station->m_index++;
 
   /// bookeeping for m_index and m_col variables
@@ -595,12 +596,19 @@ MinstrelWifiManager::UpdateStats (MinstrelWifiRemoteStation *station)
 
   Time txTime;
   uint32_t tempProb;
+  uint32_t max_prob = 0, index_max_prob = 0, max_tp = 0, index_max_tp = 0, index_max_tp2 = 0;
 
+  /**
+   * One pass over the table updates the statistics of every rate and
+   * finds the max throughput and high probability rates; the rates are
+   * independent, so the max of rates 0..i is final once rate i is done.
+   */
   for (uint32_t i = 0; i < m_nsupported; i++)
     {
+      RateInfo &rate = m_minstrelTable[i];
 
       /// calculate the perfect tx time for this rate
-      txTime = m_minstrelTable[i].perfectTxTime;
+      txTime = rate.perfectTxTime;
 
       /// just for initialization
       if (txTime.GetMicroSeconds () == 0)
@@ -609,83 +617,77 @@ MinstrelWifiManager::UpdateStats (MinstrelWifiRemoteStation *station)
         }
 
       NS_LOG_DEBUG ("m_txrate=" << station->m_txrate <<
-                    "\t attempt=" << m_minstrelTable[i].numRateAttempt <<
-                    "\t success=" << m_minstrelTable[i].numRateSuccess);
+                    "\t attempt=" << rate.numRateAttempt <<
+                    "\t success=" << rate.numRateSuccess);
 
       /// if we've attempted something
-      if (m_minstrelTable[i].numRateAttempt)
+      if (rate.numRateAttempt)
         {
           /**
            * calculate the probability of success
            * assume probability scales from 0 to 18000
            */
-          tempProb = (m_minstrelTable[i].numRateSuccess * 18000) / m_minstrelTable[i].numRateAttempt;
+          tempProb = (rate.numRateSuccess * 18000) / rate.numRateAttempt;
 
           /// bookeeping
-          m_minstrelTable[i].successHist += m_minstrelTable[i].numRateSuccess;
-          m_minstrelTable[i].attemptHist += m_minstrelTable[i].numRateAttempt;
-          m_minstrelTable[i].prob = tempProb;
+          rate.successHist += rate.numRateSuccess;
+          rate.attemptHist += rate.numRateAttempt;
+          rate.prob = tempProb;
 
           /// ewma probability (cast for gcc 3.4 compatibility)
-          tempProb = static_cast<uint32_t> (((tempProb * (100 - m_ewmaLevel)) + (m_minstrelTable[i].ewmaProb * m_ewmaLevel) ) / 100);
+          tempProb = static_cast<uint32_t> (((tempProb * (100 - m_ewmaLevel)) + (rate.ewmaProb * m_ewmaLevel) ) / 100);
 
-          m_minstrelTable[i].ewmaProb = tempProb;
+          rate.ewmaProb = tempProb;
 
           /// calculating throughput
-          m_minstrelTable[i].throughput = tempProb * (1000000 / txTime.GetMicroSeconds ());
+          rate.throughput = tempProb * (1000000 / txTime.GetMicroSeconds ());
 
         }
 
       /// bookeeping
-      m_minstrelTable[i].prevNumRateAttempt = m_minstrelTable[i].numRateAttempt;
-      m_minstrelTable[i].prevNumRateSuccess = m_minstrelTable[i].numRateSuccess;
-      m_minstrelTable[i].numRateSuccess = 0;
-      m_minstrelTable[i].numRateAttempt = 0;
+      rate.prevNumRateAttempt = rate.numRateAttempt;
+      rate.prevNumRateSuccess = rate.numRateSuccess;
+      rate.numRateSuccess = 0;
+      rate.numRateAttempt = 0;
 
       /// Sample less often below 10% and  above 95% of success
-      if ((m_minstrelTable[i].ewmaProb > 17100) || (m_minstrelTable[i].ewmaProb < 1800))
+      if ((rate.ewmaProb > 17100) || (rate.ewmaProb < 1800))
         {
           /**
            * retry count denotes the number of retries permitted for each rate
            * # retry_count/2
            */
-          m_minstrelTable[i].adjustedRetryCount = m_minstrelTable[i].retryCount >> 1;
-          if (m_minstrelTable[i].adjustedRetryCount > 2)
+          rate.adjustedRetryCount = rate.retryCount >> 1;
+          if (rate.adjustedRetryCount > 2)
             {
-              m_minstrelTable[i].adjustedRetryCount = 2;
+              rate.adjustedRetryCount = 2;
             }
         }
       else
         {
-          m_minstrelTable[i].adjustedRetryCount = m_minstrelTable[i].retryCount;
+          rate.adjustedRetryCount = rate.retryCount;
         }
 
       /// if it's 0 allow one retry limit
-      if (m_minstrelTable[i].adjustedRetryCount == 0)
+      if (rate.adjustedRetryCount == 0)
         {
-          m_minstrelTable[i].adjustedRetryCount = 1;
+          rate.adjustedRetryCount = 1;
         }
-    }
 
+      /// go find max throughput, high probability succ
+      NS_LOG_DEBUG ("throughput" << rate.throughput <<
+                    "\n ewma" << rate.ewmaProb);
 
-  uint32_t max_prob = 0, index_max_prob = 0, max_tp = 0, index_max_tp = 0, index_max_tp2 = 0;
-
-  /// go find max throughput, second maximum throughput, high probability succ
-  for (uint32_t i = 0; i < m_nsupported; i++)
-    {
-      NS_LOG_DEBUG ("throughput" << m_minstrelTable[i].throughput <<
-                    "\n ewma" << m_minstrelTable[i].ewmaProb);
-
-      if (max_tp < m_minstrelTable[i].throughput)
+      if (max_tp < rate.throughput)
         {
           index_max_tp = i;
-          max_tp = m_minstrelTable[i].throughput;
+          max_tp = rate.throughput;
         }
 
-      if (max_prob < m_minstrelTable[i].ewmaProb)
+      if (max_prob < rate.ewmaProb)
         {
           index_max_prob = i;
-          max_prob = m_minstrelTable[i].ewmaProb;
+          max_prob = rate.ewmaProb;
         }
     }
 
@@ -724,18 +726,19 @@ MinstrelWifiManager::RateInit (MinstrelWifiRemoteStation *station)
 
   for (uint32_t i = 0; i < m_nsupported; i++)
     {
-      m_minstrelTable[i].numRateAttempt = 0;
-      m_minstrelTable[i].numRateSuccess = 0;
-      m_minstrelTable[i].prob = 0;
-      m_minstrelTable[i].ewmaProb = 0;
-      m_minstrelTable[i].prevNumRateAttempt = 0;
-      m_minstrelTable[i].prevNumRateSuccess = 0;
-      m_minstrelTable[i].successHist = 0;
-      m_minstrelTable[i].attemptHist = 0;
-      m_minstrelTable[i].throughput = 0;
-      m_minstrelTable[i].perfectTxTime = GetCalcTxTime (GetSupported (station, i));
-      m_minstrelTable[i].retryCount = 1;
-      m_minstrelTable[i].adjustedRetryCount = 1;
+      RateInfo &rate = m_minstrelTable[i];
+      rate.numRateAttempt = 0;
+      rate.numRateSuccess = 0;
+      rate.prob = 0;
+      rate.ewmaProb = 0;
+      rate.prevNumRateAttempt = 0;
+      rate.prevNumRateSuccess = 0;
+      rate.successHist = 0;
+      rate.attemptHist = 0;
+      rate.throughput = 0;
+      rate.perfectTxTime = GetCalcTxTime (GetSupported (station, i));
+      rate.retryCount = 1;
+      rate.adjustedRetryCount = 1;
     }
 }
 
@@ -763,11 +766,11 @@ MinstrelWifiManager::InitSampleTable (MinstrelWifiRemoteStation *station)
           newIndex = (i + uv) % numSampleRates;
 
           /// this loop is used for filling in other uninitilized places
-          while (m_sampleTable[newIndex][col] != 0)
+          while (m_sampleTable[newIndex * (uint32_t) m_sampleCol + col] != 0)
             {
               newIndex = (newIndex + 1) % m_nsupported;
             }
-          m_sampleTable[newIndex][col] = i;
+          m_sampleTable[newIndex * (uint32_t) m_sampleCol + col] = i;
 
         }
     }
@@ -783,7 +786,7 @@ MinstrelWifiManager::PrintSampleTable (MinstrelWifiRemoteStation *station)
     {
       for (uint32_t j = 0; j < m_sampleCol; j++)
         {
-          std::cout << m_sampleTable[i][j] << "\t";
+          std::cout << m_sampleTable[i * (uint32_t) m_sampleCol + j] << "\t";
         }
       std::cout << std::endl;
     }
@@ -71,9 +71,9 @@ typedef std::vector<struct RateInfo> MinstrelRate;
 
 /**
  * Data structure for a Sample Rate table
- * A vector of a vector uint32_t
+ * One row of sample columns per rate, stored row after row
  */
-typedef std::vector<std::vector<uint32_t> > SampleRate;
+typedef std::vector<uint32_t> SampleRate;
 
 
 /**
@@ -158,11 +158,11 @@ private:
   void CheckInit (MinstrelWifiRemoteStation *station);  ///< check for initializations
 
   /**
-   * typedef for a vector of a pair of Time, WifiMode.
-   * (Essentially a list for WifiMode and its corresponding transmission time
-   * to transmit a reference packet.
+   * typedef for a vector of Time, indexed by WifiMode::GetUid.
+   * (Essentially a table of the transmission time of a reference packet
+   * for each WifiMode; negative for the modes not added.)
    */
-  typedef std::vector<std::pair<Time,WifiMode> > TxTime;
+  typedef std::vector<Time> TxTime;
   MinstrelRate m_minstrelTable;  ///< minstrel table
   SampleRate m_sampleTable;  ///< sample table
 
@@ -0,0 +1,305 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "vehicular-wifi-manager.h"
+#include "wifi-phy.h"
+#include "yans-wifi-phy.h"
+#include "ns3/mobility-model.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/double.h"
+#include <cmath>
+#include <algorithm>
+
+#define Min(a,b) ((a < b) ? a : b)
+
+NS_LOG_COMPONENT_DEFINE ("VehicularWifiManager");
+
+namespace ns3 {
+
+/**
+ * \brief hold per-remote-station state for Vehicular Wifi manager.
+ *
+ * This struct extends from WifiRemoteStation struct to hold additional
+ * information required by the Vehicular Wifi manager
+ */
+struct VehicularWifiRemoteStation : public WifiRemoteStation
+{
+  double m_lastSnr;  //!< last snr measured on the link, 0 if none yet
+  Time m_lastSnrTime;  //!< when m_lastSnr was measured
+  uint32_t m_failures;  //!< consecutive data failures
+};
+
+NS_OBJECT_ENSURE_REGISTERED (VehicularWifiManager);
+
+TypeId
+VehicularWifiManager::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::VehicularWifiManager")
+    .SetParent<WifiRemoteStationManager> ()
+    .AddConstructor<VehicularWifiManager> ()
+    .AddAttribute ("BerThreshold",
+                   "The maximum Bit Error Rate acceptable at any transmission mode",
+                   DoubleValue (10e-6),
+                   MakeDoubleAccessor (&VehicularWifiManager::m_ber),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("PredictionHorizon",
+                   "How far ahead the snr is predicted from the motion of the stations",
+                   TimeValue (MilliSeconds (200)),
+                   MakeTimeAccessor (&VehicularWifiManager::m_horizon),
+                   MakeTimeChecker ())
+    .AddAttribute ("PathLossExponent",
+                   "Exponent of the log-distance path loss used to predict the snr",
+                   DoubleValue (2.7),
+                   MakeDoubleAccessor (&VehicularWifiManager::m_exponent),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("SnrMargin",
+                   "Margin (dB) of the predicted snr above the threshold of the selected mode",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&VehicularWifiManager::m_margin),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("FailureMargin",
+                   "Margin (dB) added per consecutive data failure",
+                   DoubleValue (3.0),
+                   MakeDoubleAccessor (&VehicularWifiManager::m_failureMargin),
+                   MakeDoubleChecker<double> (0.0))
+  ;
+  return tid;
+}
+
+VehicularWifiManager::VehicularWifiManager ()
+{
+}
+VehicularWifiManager::~VehicularWifiManager ()
+{
+}
+
+void
+VehicularWifiManager::SetupPhy (Ptr<WifiPhy> phy)
+{
+  uint32_t nModes = phy->GetNModes ();
+  for (uint32_t i = 0; i < nModes; i++)
+    {
+      WifiMode mode = phy->GetMode (i);
+      uint32_t uid = mode.GetUid ();
+      if (uid >= m_thresholds.size ())
+        {
+          m_thresholds.resize (uid + 1, -1.0);
+        }
+      m_thresholds[uid] = phy->CalculateSnr (mode, m_ber);
+    }
+  m_phy = phy;
+  m_mobility = 0;
+
+  WifiRemoteStationManager::SetupPhy (phy);
+}
+
+void
+VehicularWifiManager::SetKinematicsCallback (KinematicsCallback callback)
+{
+  m_kinematics = callback;
+}
+
+double
+VehicularWifiManager::GetSnrThreshold (WifiMode mode) const
+{
+  uint32_t uid = mode.GetUid ();
+  NS_ASSERT (uid < m_thresholds.size () && m_thresholds[uid] >= 0);
+  return m_thresholds[uid];
+}
+
+bool
+VehicularWifiManager::GetRelativeKinematics (VehicularWifiRemoteStation *station, Vector &position, Vector &velocity)
+{
+  if (m_kinematics.IsNull ())
+    {
+      return false;
+    }
+  if (m_mobility == 0)
+    {
+      // The phy gets its mobility after SetupPhy, when the node is set up
+      Ptr<YansWifiPhy> phy = DynamicCast<YansWifiPhy> (m_phy);
+      if (phy == 0 || phy->GetMobility () == 0)
+        {
+          return false;
+        }
+      m_mobility = phy->GetMobility ()->GetObject<MobilityModel> ();
+      if (m_mobility == 0)
+        {
+          return false;
+        }
+    }
+  Vector remotePosition;
+  Vector remoteVelocity;
+  if (!m_kinematics (station->m_state->m_address, remotePosition, remoteVelocity))
+    {
+      return false;
+    }
+  Vector ownPosition = m_mobility->GetPosition ();
+  Vector ownVelocity = m_mobility->GetVelocity ();
+  position = Vector (remotePosition.x - ownPosition.x, remotePosition.y - ownPosition.y,
+                     remotePosition.z - ownPosition.z);
+  velocity = Vector (remoteVelocity.x - ownVelocity.x, remoteVelocity.y - ownVelocity.y,
+                     remoteVelocity.z - ownVelocity.z);
+  return true;
+}
+
+void
+VehicularWifiManager::UpdateSnr (VehicularWifiRemoteStation *station, double snr)
+{
+  station->m_lastSnr = snr;
+  station->m_lastSnrTime = Simulator::Now ();
+}
+
+double
+VehicularWifiManager::GetPredictedSnr (VehicularWifiRemoteStation *station)
+{
+  Vector position;
+  Vector velocity;
+  if (station->m_lastSnr <= 0
+      || !GetRelativeKinematics (station, position, velocity))
+    {
+      return station->m_lastSnr;
+    }
+  // Distances when the snr was measured and at the horizon, both
+  // extrapolated from now with the current relative velocity. Below a
+  // meter the path loss model does not hold.
+  double before = (station->m_lastSnrTime - Simulator::Now ()).GetSeconds ();
+  double after = m_horizon.GetSeconds ();
+  Vector measured (position.x + velocity.x * before, position.y + velocity.y * before,
+                   position.z + velocity.z * before);
+  Vector predicted (position.x + velocity.x * after, position.y + velocity.y * after,
+                    position.z + velocity.z * after);
+  double measuredDistance = std::max (CalculateDistance (measured, Vector ()), 1.0);
+  double predictedDistance = std::max (CalculateDistance (predicted, Vector ()), 1.0);
+  double snr = station->m_lastSnr * std::pow (measuredDistance / predictedDistance, m_exponent);
+  NS_LOG_DEBUG ("station=" << station->m_state->m_address << " snr=" << station->m_lastSnr
+                           << " at " << measuredDistance << "m, predicted=" << snr
+                           << " at " << predictedDistance << "m");
+  return snr;
+}
+
+WifiRemoteStation *
+VehicularWifiManager::DoCreateStation (void) const
+{
+  VehicularWifiRemoteStation *station = new VehicularWifiRemoteStation ();
+  station->m_lastSnr = 0.0;
+  station->m_lastSnrTime = Seconds (0);
+  station->m_failures = 0;
+  return station;
+}
+
+
+void
+VehicularWifiManager::DoReportRxOk (WifiRemoteStation *st,
+                                    double rxSnr, WifiMode txMode)
+{
+  // The channel is reciprocal: frames heard from the station, beacons
+  // and hellos included, measure the link as well as our own acks do
+  VehicularWifiRemoteStation *station = (VehicularWifiRemoteStation *)st;
+  UpdateSnr (station, rxSnr);
+}
+void
+VehicularWifiManager::DoReportRtsFailed (WifiRemoteStation *station)
+{
+}
+void
+VehicularWifiManager::DoReportDataFailed (WifiRemoteStation *st)
+{
+  VehicularWifiRemoteStation *station = (VehicularWifiRemoteStation *)st;
+  station->m_failures++;
+}
+void
+VehicularWifiManager::DoReportRtsOk (WifiRemoteStation *st,
+                                     double ctsSnr, WifiMode ctsMode, double rtsSnr)
+{
+  VehicularWifiRemoteStation *station = (VehicularWifiRemoteStation *)st;
+  UpdateSnr (station, rtsSnr);
+}
+void
+VehicularWifiManager::DoReportDataOk (WifiRemoteStation *st,
+                                      double ackSnr, WifiMode ackMode, double dataSnr)
+{
+  VehicularWifiRemoteStation *station = (VehicularWifiRemoteStation *)st;
+  station->m_failures = 0;
+  UpdateSnr (station, dataSnr);
+}
+void
+VehicularWifiManager::DoReportFinalRtsFailed (WifiRemoteStation *station)
+{
+}
+void
+VehicularWifiManager::DoReportFinalDataFailed (WifiRemoteStation *st)
+{
+  VehicularWifiRemoteStation *station = (VehicularWifiRemoteStation *)st;
+  station->m_failures = 0;
+}
+
+WifiTxVector
+VehicularWifiManager::DoGetDataTxVector (WifiRemoteStation *st, uint32_t size)
+{
+  VehicularWifiRemoteStation *station = (VehicularWifiRemoteStation *)st;
+  // We search within the Supported rate set the mode with the
+  // highest snr threshold possible which, with the margins, is
+  // smaller than the predicted snr.
+  double margin = std::pow (10.0, (m_margin + station->m_failures * m_failureMargin) / 10.0);
+  double snr = GetPredictedSnr (station) / margin;
+  double maxThreshold = 0.0;
+  WifiMode maxMode = GetDefaultMode ();
+  for (uint32_t i = 0; i < GetNSupported (station); i++)
+    {
+      WifiMode mode = GetSupported (station, i);
+      double threshold = GetSnrThreshold (mode);
+      if (threshold > maxThreshold
+          && threshold < snr)
+        {
+          maxThreshold = threshold;
+          maxMode = mode;
+        }
+    }
+  return WifiTxVector (maxMode, GetDefaultTxPowerLevel (), GetLongRetryCount (station), GetShortGuardInterval (station), Min (GetNumberOfReceiveAntennas (station),GetNumberOfTransmitAntennas()), GetNumberOfTransmitAntennas (station), GetStbc (station));
+}
+WifiTxVector
+VehicularWifiManager::DoGetRtsTxVector (WifiRemoteStation *st)
+{
+  VehicularWifiRemoteStation *station = (VehicularWifiRemoteStation *)st;
+  // We search within the Basic rate set the mode with the highest
+  // snr threshold possible which is smaller than the predicted snr.
+  double snr = GetPredictedSnr (station) / std::pow (10.0, m_margin / 10.0);
+  double maxThreshold = 0.0;
+  WifiMode maxMode = GetDefaultMode ();
+  for (uint32_t i = 0; i < GetNBasicModes (); i++)
+    {
+      WifiMode mode = GetBasicMode (i);
+      double threshold = GetSnrThreshold (mode);
+      if (threshold > maxThreshold
+          && threshold < snr)
+        {
+          maxThreshold = threshold;
+          maxMode = mode;
+        }
+    }
+  return WifiTxVector (maxMode, GetDefaultTxPowerLevel (), GetShortRetryCount (station), GetShortGuardInterval (station), Min (GetNumberOfReceiveAntennas (station),GetNumberOfTransmitAntennas()), GetNumberOfTransmitAntennas (station), GetStbc (station));
+}
+
+bool
+VehicularWifiManager::IsLowLatency (void) const
+{
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef VEHICULAR_WIFI_MANAGER_H
+#define VEHICULAR_WIFI_MANAGER_H
+
+#include <stdint.h>
+#include <vector>
+#include "wifi-mode.h"
+#include "wifi-remote-station-manager.h"
+#include "ns3/callback.h"
+#include "ns3/vector.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+class MobilityModel;
+struct VehicularWifiRemoteStation;
+
+/**
+ * \brief Rate control which predicts the SNR from the motion of the stations
+ * \ingroup wifi
+ *
+ * Like IdealWifiManager, every station keeps the last snr measured
+ * on a link, from the frames received from the remote station and
+ * from the snr sent back with its acks, and picks the fastest mode
+ * whose snr threshold (built from a target ber) is below it. Loss-driven
+ * managers only step down after the link degrades; at highway speeds
+ * the snr changes faster than they converge. This manager instead
+ * predicts the snr PredictionHorizon ahead, when the frame will be in
+ * the air and retried: the measured snr is scaled by the change of the
+ * distance between the stations since the measurement, with a log-distance
+ * path loss of exponent PathLossExponent:
+ *
+ *   snr(t + h) = snr(t0) * (d(t0) / d(t + h)) ^ PathLossExponent
+ *
+ * where d(t0) and d(t + h) extrapolate the current positions with the
+ * current velocities, so that the remote station is only looked up when
+ * a frame is sent.
+ *
+ * The position of this station comes from the mobility of its
+ * YansWifiPhy; that of the remote station from a callback set with
+ * SetKinematicsCallback, typically by the routing protocol from its
+ * neighbour table (GPSR does so when it runs on the interface). Without
+ * it, the manager uses the last snr as measured. Each consecutive data
+ * failure adds FailureMargin dB to the required snr, until a success.
+ */
+class VehicularWifiManager : public WifiRemoteStationManager
+{
+public:
+  /**
+   * Fills in the position and velocity, now, of the remote station
+   * with the given address and returns true, or returns false if they
+   * are not known.
+   */
+  typedef Callback<bool, Mac48Address, Vector &, Vector &> KinematicsCallback;
+
+  static TypeId GetTypeId (void);
+  VehicularWifiManager ();
+  virtual ~VehicularWifiManager ();
+
+  virtual void SetupPhy (Ptr<WifiPhy> phy);
+
+  /**
+   * \param callback source of the position and velocity of the remote stations
+   */
+  void SetKinematicsCallback (KinematicsCallback callback);
+
+private:
+  // overriden from base class
+  virtual WifiRemoteStation* DoCreateStation (void) const;
+  virtual void DoReportRxOk (WifiRemoteStation *station,
+                             double rxSnr, WifiMode txMode);
+  virtual void DoReportRtsFailed (WifiRemoteStation *station);
+  virtual void DoReportDataFailed (WifiRemoteStation *station);
+  virtual void DoReportRtsOk (WifiRemoteStation *station,
+                              double ctsSnr, WifiMode ctsMode, double rtsSnr);
+  virtual void DoReportDataOk (WifiRemoteStation *station,
+                               double ackSnr, WifiMode ackMode, double dataSnr);
+  virtual void DoReportFinalRtsFailed (WifiRemoteStation *station);
+  virtual void DoReportFinalDataFailed (WifiRemoteStation *station);
+  virtual WifiTxVector DoGetDataTxVector (WifiRemoteStation *station, uint32_t size);
+  virtual WifiTxVector DoGetRtsTxVector (WifiRemoteStation *station);
+  virtual bool IsLowLatency (void) const;
+
+  /**
+   * \param station the remote station
+   * \param position set to the position of the station relative to this one
+   * \param velocity set to the velocity of the station relative to this one
+   * \return false if the positions are not known
+   */
+  bool GetRelativeKinematics (VehicularWifiRemoteStation *station, Vector &position, Vector &velocity);
+  /// Record an snr measured on the link to station
+  void UpdateSnr (VehicularWifiRemoteStation *station, double snr);
+  /// The snr expected PredictionHorizon from now, 0 if never measured
+  double GetPredictedSnr (VehicularWifiRemoteStation *station);
+  /**
+   * \param mode the mode
+   * \return the minimum snr for the mode at the BerThreshold
+   */
+  double GetSnrThreshold (WifiMode mode) const;
+
+  /**
+   * Minimum snr of each mode, indexed by WifiMode::GetUid,
+   * negative for the modes of other phys
+   */
+  typedef std::vector<double> Thresholds;
+
+  double m_ber;  //!< The maximum Bit Error Rate acceptable at any transmission mode
+  Time m_horizon;  //!< How far ahead the snr is predicted
+  double m_exponent;  //!< Path loss exponent of the prediction
+  double m_margin;  //!< Snr margin above the mode threshold, dB
+  double m_failureMargin;  //!< Snr margin added per consecutive data failure, dB
+  Thresholds m_thresholds;  //!< Minimum snr per mode
+  Ptr<WifiPhy> m_phy;  //!< For the position of this station
+  Ptr<MobilityModel> m_mobility;  //!< Position of this station, found on first use
+  KinematicsCallback m_kinematics;  //!< Position of the remote stations
+};
+
+} // namespace ns3
+
+#endif /* VEHICULAR_WIFI_MANAGER_H */
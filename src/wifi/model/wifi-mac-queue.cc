@@ -186,6 +186,26 @@ WifiMacQueue::DequeueByTidAndAddress (WifiMacHeader *hdr, uint8_t tid,
   return packet;
 }
 
+Ptr<const Packet>
+WifiMacQueue::DequeueByAddress (WifiMacHeader *hdr,
+                                WifiMacHeader::AddressType type, Mac48Address dest)
+{
+  Cleanup ();
+  Ptr<const Packet> packet = 0;
+  for (PacketQueueI it = m_queue.begin (); it != m_queue.end (); ++it)
+    {
+      if (GetAddressForPacket (type, it) == dest)
+        {
+          packet = it->packet;
+          *hdr = it->hdr;
+          m_queue.erase (it);
+          m_size--;
+          break;
+        }
+    }
+  return packet;
+}
+
 Ptr<const Packet>
 WifiMacQueue::PeekByTidAndAddress (WifiMacHeader *hdr, uint8_t tid,
                                    WifiMacHeader::AddressType type, Mac48Address dest)
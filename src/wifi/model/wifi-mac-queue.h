@@ -141,6 +141,20 @@ public:
                                          uint8_t tid,
                                          WifiMacHeader::AddressType type,
                                          Mac48Address addr);
+  /**
+   * Searchs and returns, if is present in this queue, first packet having
+   * address indicated by <i>type</i> equals to <i>addr</i>, QoS or not.
+   * This method removes the packet from this queue. Is typically used to
+   * take back the packets for a station that can no longer be reached.
+   *
+   * \param hdr the header of the dequeued packet
+   * \param type the given address type
+   * \param addr the given destination
+   * \return packet, 0 if none
+   */
+  Ptr<const Packet> DequeueByAddress (WifiMacHeader *hdr,
+                                      WifiMacHeader::AddressType type,
+                                      Mac48Address addr);
   /**
    * If exists, removes <i>packet</i> from queue and returns true. Otherwise it
    * takes no effects and return false. Deletion of the packet is
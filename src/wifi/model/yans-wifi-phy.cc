@@ -170,7 +170,8 @@ YansWifiPhy::GetTypeId (void)
 YansWifiPhy::YansWifiPhy ()
   :  m_channelNumber (1),
     m_endRxEvent (),
-    m_channelStartingFrequency (0)
+    m_channelStartingFrequency (0),
+    m_nRxSnr (0)
 {
   NS_LOG_FUNCTION (this);
   m_random = CreateObject<UniformRandomVariable> ();
@@ -352,6 +353,23 @@ YansWifiPhy::GetMobility (void)
   return m_mobility;
 }
 
+bool
+YansWifiPhy::GetRxSnr (uint64_t uid, double &snr) const
+{
+  // Most recent first: the packet looked up is usually the last one
+  uint32_t n = m_nRxSnr < RX_SNR_HISTORY ? m_nRxSnr : RX_SNR_HISTORY;
+  for (uint32_t i = 1; i <= n; i++)
+    {
+      const RxSnr &rx = m_rxSnr[(m_nRxSnr - i) % RX_SNR_HISTORY];
+      if (rx.uid == uid)
+        {
+          snr = rx.snr;
+          return true;
+        }
+    }
+  return false;
+}
+
 double
 YansWifiPhy::CalculateSnr (WifiMode txMode, double ber) const
 {
@@ -837,17 +855,15 @@ YansWifiPhy::EndReceive (Ptr<Packet> packet, Ptr<InterferenceHelper::Event> even
       double signalDbm = RatioToDb (event->GetRxPowerW ()) + 30;
       double noiseDbm = RatioToDb (event->GetRxPowerW () / snrPer.snr) - GetRxNoiseFigure () + 30;
       NotifyMonitorSniffRx (packet, (uint16_t)GetChannelFrequencyMhz (), GetChannelNumber (), dataRate500KbpsUnits, isShortPreamble, signalDbm, noiseDbm);
-      
-      SnrTag tag;
-      tag.Set(signalDbm - noiseDbm);
-      
-      if (! packet->PeekPacketTag (tag))
-        {
-          packet->AddPacketTag (tag);
-//          std::cout << "Add SNR Tag with value: " << tag.Get() << "\n";
-          NS_LOG_DEBUG("Add SNR Tag with value :" << tag.Get());
-        }
-      
+
+      // Kept for GetRxSnr rather than tagged on the packet: a tag costs
+      // an allocation per frame and travels on with forwarded packets
+      RxSnr &rx = m_rxSnr[m_nRxSnr % RX_SNR_HISTORY];
+      rx.uid = packet->GetUid ();
+      rx.snr = signalDbm - noiseDbm;
+      m_nRxSnr++;
+      NS_LOG_DEBUG ("rx snr=" << rx.snr << " dB");
+
       m_state->SwitchFromRxEndOk (packet, snrPer.snr, event->GetPayloadMode (), event->GetPreambleType ());
     }
   else
@@ -36,7 +36,6 @@
 #include "wifi-preamble.h"
 #include "wifi-phy-standard.h"
 #include "interference-helper.h"
-#include "snr-tag.h"
 
 namespace ns3 {
 
@@ -228,6 +227,16 @@ public:
    * \return the mobility model this PHY is associated with
    */
   Ptr<Object> GetMobility (void);
+  /**
+   * Look up the snr a recent packet was received with. Upper layers
+   * get a packet in the same event as its reception, so that only
+   * reassembled or reordered packets need the short history kept.
+   *
+   * \param uid the uid of a packet received by this phy
+   * \param snr set to the snr (signal minus noise, dB) of its reception
+   * \return false if the packet is not among the last ones received
+   */
+  bool GetRxSnr (uint64_t uid, double &snr) const;
 
   /**
    * Return the minimum available transmission power level (dBm).
@@ -525,6 +534,17 @@ private:
   InterferenceHelper m_interference;    //!< Pointer to InterferenceHelper
   Time m_channelSwitchDelay;            //!< Time required to switch between channel
 
+  /// The snr of a packet received successfully
+  struct RxSnr
+  {
+    uint64_t uid;  //!< uid of the packet
+    double snr;    //!< snr (dB) of its reception
+  };
+  /// Number of receptions GetRxSnr remembers
+  static const uint32_t RX_SNR_HISTORY = 16;
+  RxSnr m_rxSnr[RX_SNR_HISTORY];        //!< Last receptions, circular
+  uint32_t m_nRxSnr;                    //!< Number of receptions so far
+
 };
 
 } // namespace ns3
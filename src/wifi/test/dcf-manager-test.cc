@@ -74,6 +74,10 @@ private:
   void EndTest (void);
   void ExpectInternalCollision (uint64_t time, uint32_t from, uint32_t nSlots);
   void ExpectCollision (uint64_t time, uint32_t from, uint32_t nSlots);
+  ///\param scheduled expected number of access timeouts scheduled by the end of the test
+  ///\param cancelled expected number of access timeouts cancelled to be scheduled earlier
+  ///\param idle expected number of access timeouts which expired without granting access
+  void ExpectAccessTimeouts (uint64_t scheduled, uint64_t cancelled, uint64_t idle);
   void AddRxOkEvt (uint64_t at, uint64_t duration);
   void AddRxErrorEvt (uint64_t at, uint64_t duration);
   void AddRxInsideSifsEvt (uint64_t at, uint64_t duration);
@@ -102,6 +106,10 @@ private:
   DcfManager *m_dcfManager;
   DcfStates m_dcfStates;
   uint32_t m_ackTimeoutValue;
+  bool m_checkAccessTimeouts;
+  uint64_t m_expectedScheduled;
+  uint64_t m_expectedCancelled;
+  uint64_t m_expectedIdle;
 };
 
 
@@ -212,9 +220,19 @@ DcfManagerTest::ExpectCollision (uint64_t time, uint32_t nSlots, uint32_t from)
   state->m_expectedCollision.push_back (col);
 }
 
+void
+DcfManagerTest::ExpectAccessTimeouts (uint64_t scheduled, uint64_t cancelled, uint64_t idle)
+{
+  m_checkAccessTimeouts = true;
+  m_expectedScheduled = scheduled;
+  m_expectedCancelled = cancelled;
+  m_expectedIdle = idle;
+}
+
 void
 DcfManagerTest::StartTest (uint64_t slotTime, uint64_t sifs, uint64_t eifsNoDifsNoSifs, uint32_t ackTimeoutValue)
 {
+  m_checkAccessTimeouts = false;
   m_dcfManager = new DcfManager ();
   m_dcfManager->SetSlot (MicroSeconds (slotTime));
   m_dcfManager->SetSifs (MicroSeconds (sifs));
@@ -236,6 +254,12 @@ DcfManagerTest::EndTest (void)
 {
   Simulator::Run ();
   Simulator::Destroy ();
+  if (m_checkAccessTimeouts)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_dcfManager->GetScheduledAccessTimeouts (), m_expectedScheduled, "Scheduled access timeouts");
+      NS_TEST_EXPECT_MSG_EQ (m_dcfManager->GetCancelledAccessTimeouts (), m_expectedCancelled, "Cancelled access timeouts");
+      NS_TEST_EXPECT_MSG_EQ (m_dcfManager->GetIdleAccessTimeouts (), m_expectedIdle, "Idle access timeouts");
+    }
   for (DcfStates::const_iterator i = m_dcfStates.begin (); i != m_dcfStates.end (); i++)
     {
       DcfStateTest *state = *i;
@@ -387,6 +411,9 @@ DcfManagerTest::DoRun (void)
   AddRxOkEvt (80, 20);
   AddAccessRequest (30, 2, 118, 0);
   ExpectCollision (30, 4, 0); // backoff: 4 slots
+  // The timeout scheduled at 30 for 86 is not moved by the rx at 80:
+  // it expires idle and the next one is scheduled for 118.
+  ExpectAccessTimeouts (2, 0, 1);
   EndTest ();
 
   // Test the case where the backoff slots is zero.
@@ -564,6 +591,28 @@ DcfManagerTest::DoRun (void)
   AddNavReset (71, 2);
   AddAccessRequest (30, 10, 91, 0);
   ExpectCollision (30, 2, 0); // backoff: 2 slot
+  // The NAV reset moves the backoff end from 78 to 91, later: the timeout
+  // at 78 is kept and expires idle.
+  ExpectAccessTimeouts (2, 0, 1);
+  EndTest ();
+
+  // A backoff end which moves earlier does cancel the pending timeout:
+  // at 40 for the request of dcf 1 (90 -> 74), at 76 for the ack timeout
+  // reset (122 -> 102).
+  //
+  //  20          60     66      70   74   76   82      86                 102  104
+  //   |    rx     | sifs | aifsn |bs0| tx1 |sifs| aifsn | bslot1..bslot4    | tx0 |
+  //        |   |
+  //       30  40 request access. dcf 0: 5 backoff slots, dcf 1: 1 slot
+  StartTest (4, 6, 10);
+  AddDcfState (1);
+  AddDcfState (1);
+  AddRxOkEvt (20, 40);
+  AddAccessRequest (30, 2, 102, 0);
+  AddAccessRequest (40, 2, 74, 1);
+  ExpectCollision (30, 5, 0); // backoff: 5 slots
+  ExpectCollision (40, 1, 1); // backoff: 1 slot
+  ExpectAccessTimeouts (4, 2, 0);
   EndTest ();
 
 
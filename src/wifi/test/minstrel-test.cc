@@ -0,0 +1,195 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/minstrel-wifi-manager.h"
+#include "ns3/yans-wifi-phy.h"
+#include "ns3/wifi-mac-header.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/test.h"
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Drives a MinstrelWifiManager directly, without a MAC, over a link on
+ * which every rate up to m_maxGoodRate always succeeds and every faster
+ * rate always fails.  Minstrel must sample every supported rate (so the
+ * sample table holds each rate once per column) and must settle on the
+ * fastest rate that works, for every station of the manager.  With a fixed
+ * seed the rates chosen must not depend on anything but that seed, so two
+ * runs pick the same rate for every frame.
+ */
+class MinstrelRateControlTest : public TestCase
+{
+public:
+  MinstrelRateControlTest ();
+  virtual void DoRun (void);
+
+private:
+  typedef std::map<uint64_t, uint32_t> RateCount;
+
+  /// Send frames to two stations for five seconds, return the rate of every attempt
+  std::vector<uint64_t> Run (void);
+  void SendOne (Mac48Address to);
+  void Reset (void);
+  void CheckStation (Mac48Address station);
+
+  Ptr<MinstrelWifiManager> m_manager;
+  uint32_t m_nModes;
+  uint64_t m_maxGoodRate;
+  RateCount m_tried;
+  /// Rates of the frames sent in the last second, per station
+  std::map<Mac48Address, RateCount> m_used;
+  std::vector<uint64_t> m_sequence;
+};
+
+MinstrelRateControlTest::MinstrelRateControlTest ()
+  : TestCase ("Minstrel samples all rates and settles on the best one"),
+    m_nModes (0),
+    m_maxGoodRate (24000000)
+{
+}
+
+void
+MinstrelRateControlTest::SendOne (Mac48Address to)
+{
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_DATA);
+  hdr.SetAddr1 (to);
+  Ptr<Packet> packet = Create<Packet> (1000);
+  uint32_t size = packet->GetSize () + hdr.GetSize () + 4;
+
+  while (true)
+    {
+      WifiMode mode = m_manager->GetDataTxVector (to, &hdr, packet, size).GetMode ();
+      m_tried[mode.GetDataRate ()]++;
+      m_sequence.push_back (mode.GetDataRate ());
+      if (mode.GetDataRate () <= m_maxGoodRate)
+        {
+          m_used[to][mode.GetDataRate ()]++;
+          m_manager->ReportDataOk (to, &hdr, 30, mode, 30);
+          return;
+        }
+      m_manager->ReportDataFailed (to, &hdr);
+      if (!m_manager->NeedDataRetransmission (to, &hdr, packet))
+        {
+          m_manager->ReportFinalDataFailed (to, &hdr);
+          return;
+        }
+    }
+}
+
+void
+MinstrelRateControlTest::Reset (void)
+{
+  m_used.clear ();
+}
+
+void
+MinstrelRateControlTest::CheckStation (Mac48Address station)
+{
+  const RateCount &used = m_used[station];
+  uint64_t best = 0;
+  uint32_t bestCount = 0;
+  uint32_t total = 0;
+  for (RateCount::const_iterator i = used.begin (); i != used.end (); i++)
+    {
+      total += i->second;
+      if (i->second > bestCount)
+        {
+          best = i->first;
+          bestCount = i->second;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (best, m_maxGoodRate, "the fastest working rate should carry most frames to " << station);
+  // lookaround sends about one frame in ten at another rate
+  NS_TEST_EXPECT_MSG_GT (bestCount * 10, total * 7, "too few frames at the fastest working rate to " << station);
+}
+
+std::vector<uint64_t>
+MinstrelRateControlTest::Run (void)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  m_tried.clear ();
+  m_used.clear ();
+  m_sequence.clear ();
+
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  m_nModes = phy->GetNModes ();
+  m_manager = CreateObject<MinstrelWifiManager> ();
+  m_manager->SetupPhy (phy);
+  m_manager->AssignStreams (1);
+
+  Mac48Address a = Mac48Address ("00:00:00:00:00:01");
+  Mac48Address b = Mac48Address ("00:00:00:00:00:02");
+  for (uint32_t i = 0; i < phy->GetNModes (); i++)
+    {
+      m_manager->AddSupportedMode (a, phy->GetMode (i));
+      m_manager->AddSupportedMode (b, phy->GetMode (i));
+    }
+
+  // one frame per millisecond to each station, the second station
+  // joins after one second
+  for (uint32_t ms = 0; ms < 5000; ms++)
+    {
+      Simulator::Schedule (MilliSeconds (ms), &MinstrelRateControlTest::SendOne, this, a);
+      if (ms >= 1000)
+        {
+          Simulator::Schedule (MilliSeconds (ms), &MinstrelRateControlTest::SendOne, this, b);
+        }
+    }
+  Simulator::Schedule (MilliSeconds (4000) - NanoSeconds (1), &MinstrelRateControlTest::Reset, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_manager = 0;
+  return m_sequence;
+}
+
+void
+MinstrelRateControlTest::DoRun (void)
+{
+  std::vector<uint64_t> first = Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_tried.size (), m_nModes, "every rate should have been sampled");
+  CheckStation (Mac48Address ("00:00:00:00:00:01"));
+  CheckStation (Mac48Address ("00:00:00:00:00:02"));
+
+  std::vector<uint64_t> second = Run ();
+  NS_TEST_ASSERT_MSG_EQ (second.size (), first.size (), "same number of attempts with the same seed");
+  for (uint32_t i = 0; i < first.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (second[i], first[i], "same rate for attempt " << i << " with the same seed");
+    }
+}
+
+class MinstrelTestSuite : public TestSuite
+{
+public:
+  MinstrelTestSuite ();
+};
+
+MinstrelTestSuite::MinstrelTestSuite ()
+  : TestSuite ("devices-wifi-minstrel", UNIT)
+{
+  AddTestCase (new MinstrelRateControlTest, TestCase::QUICK);
+}
+
+static MinstrelTestSuite g_minstrelTestSuite;
@@ -25,6 +25,7 @@
 #include "ns3/adhoc-wifi-mac.h"
 #include "ns3/yans-wifi-phy.h"
 #include "ns3/arf-wifi-manager.h"
+#include "ns3/vehicular-wifi-manager.h"
 #include "ns3/propagation-delay-model.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/error-rate-model.h"
@@ -38,9 +39,11 @@
 #include "ns3/mac-rx-middle.h"
 #include "ns3/pointer.h"
 #include "ns3/rng-seed-manager.h"
+#include "ns3/wifi-mac-queue.h"
 #include "ns3/edca-txop-n.h"
 #include "ns3/config.h"
 #include "ns3/boolean.h"
+#include <cmath>
 
 using namespace ns3;
 
@@ -212,6 +215,161 @@ public:
   }
 };
 
+//-----------------------------------------------------------------------------
+class WifiMacQueueDequeueByAddressTest : public TestCase
+{
+public:
+  WifiMacQueueDequeueByAddressTest () : TestCase ("WifiMacQueue::DequeueByAddress")
+  {
+  }
+  virtual void DoRun (void)
+  {
+    Ptr<WifiMacQueue> queue = CreateObject<WifiMacQueue> ();
+    Mac48Address a = Mac48Address ("00:00:00:00:00:01");
+    Mac48Address b = Mac48Address ("00:00:00:00:00:02");
+    // a, b, a: the frames for a come out oldest first, the one for b stays
+    Ptr<Packet> first = Create<Packet> (10);
+    Ptr<Packet> other = Create<Packet> (20);
+    Ptr<Packet> second = Create<Packet> (30);
+    WifiMacHeader hdr;
+    hdr.SetType (WIFI_MAC_DATA);
+    hdr.SetAddr1 (a);
+    queue->Enqueue (first, hdr);
+    hdr.SetAddr1 (b);
+    queue->Enqueue (other, hdr);
+    hdr.SetAddr1 (a);
+    hdr.SetSequenceNumber (1);
+    queue->Enqueue (second, hdr);
+
+    WifiMacHeader out;
+    NS_TEST_EXPECT_MSG_EQ (queue->DequeueByAddress (&out, WifiMacHeader::ADDR1, a), first, "oldest frame for a");
+    NS_TEST_EXPECT_MSG_EQ (out.GetAddr1 (), a, "header of the frame is returned");
+    NS_TEST_EXPECT_MSG_EQ (queue->GetSize (), 2, "one frame removed");
+    NS_TEST_EXPECT_MSG_EQ (queue->DequeueByAddress (&out, WifiMacHeader::ADDR1, a), second, "next frame for a");
+    NS_TEST_EXPECT_MSG_EQ (out.GetSequenceNumber (), 1, "header of the second frame");
+    NS_TEST_EXPECT_MSG_EQ (queue->DequeueByAddress (&out, WifiMacHeader::ADDR1, a), Ptr<const Packet> (), "no frame left for a");
+    NS_TEST_EXPECT_MSG_EQ (queue->GetSize (), 1, "frame for b kept");
+    NS_TEST_EXPECT_MSG_EQ (queue->Dequeue (&out), other, "frame for b untouched");
+    NS_TEST_EXPECT_MSG_EQ (queue->IsEmpty (), true, "queue empty");
+  }
+};
+
+//-----------------------------------------------------------------------------
+/**
+ * VehicularWifiManager scales the last snr of a station by the change of
+ * its distance over the prediction horizon, and uses the snr as measured
+ * when the motion of the station is not known.
+ */
+class VehicularWifiManagerTest : public TestCase
+{
+public:
+  VehicularWifiManagerTest ();
+  virtual void DoRun (void);
+
+private:
+  bool GetKinematics (Mac48Address address, Vector &position, Vector &velocity);
+  /// The mode the manager should pick for a predicted snr
+  WifiMode ExpectedMode (double snr) const;
+  WifiMode GetDataMode (void);
+
+  Ptr<YansWifiPhy> m_phy;
+  Ptr<VehicularWifiManager> m_manager;
+  Mac48Address m_station;
+  bool m_known;
+  Vector m_velocity;
+};
+
+VehicularWifiManagerTest::VehicularWifiManagerTest ()
+  : TestCase ("VehicularWifiManager snr prediction"),
+    m_station ("00:00:00:00:00:02"),
+    m_known (false)
+{
+}
+
+bool
+VehicularWifiManagerTest::GetKinematics (Mac48Address address, Vector &position, Vector &velocity)
+{
+  NS_TEST_EXPECT_MSG_EQ (address, m_station, "kinematics of the remote station");
+  position = Vector (100, 0, 0);
+  velocity = m_velocity;
+  return m_known;
+}
+
+WifiMode
+VehicularWifiManagerTest::ExpectedMode (double snr) const
+{
+  // SnrMargin of 1 dB, BerThreshold of 10e-6
+  snr /= std::pow (10.0, 0.1);
+  WifiMode best = m_phy->GetMode (0);
+  double bestThreshold = 0;
+  for (uint32_t i = 0; i < m_phy->GetNModes (); i++)
+    {
+      double threshold = m_phy->CalculateSnr (m_phy->GetMode (i), 10e-6);
+      if (threshold > bestThreshold && threshold < snr)
+        {
+          best = m_phy->GetMode (i);
+          bestThreshold = threshold;
+        }
+    }
+  return best;
+}
+
+WifiMode
+VehicularWifiManagerTest::GetDataMode (void)
+{
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_DATA);
+  hdr.SetAddr1 (m_station);
+  return m_manager->GetDataTxVector (m_station, &hdr, Create<Packet> (1000), 1000).GetMode ();
+}
+
+void
+VehicularWifiManagerTest::DoRun (void)
+{
+  m_phy = CreateObject<YansWifiPhy> ();
+  m_phy->SetErrorRateModel (CreateObject<YansErrorRateModel> ());
+  m_phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  m_phy->SetMobility (CreateObject<ConstantPositionMobilityModel> ());
+  m_manager = CreateObject<VehicularWifiManager> ();
+  m_manager->SetupPhy (m_phy);
+  for (uint32_t i = 0; i < m_phy->GetNModes (); i++)
+    {
+      m_manager->AddSupportedMode (m_station, m_phy->GetMode (i));
+    }
+
+  // The snr is measured with the station 100 m away, at the horizon of
+  // 200 ms it is 200 m away when receding at 500 m/s, 50 m away when
+  // approaching at 250 m/s
+  double snr = 30;
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_DATA);
+  m_manager->ReportRxOk (m_station, &hdr, snr, m_phy->GetMode (0));
+
+  WifiMode measured = GetDataMode ();
+  NS_TEST_EXPECT_MSG_EQ (measured, ExpectedMode (snr), "measured snr without kinematics");
+  m_manager->SetKinematicsCallback (MakeCallback (&VehicularWifiManagerTest::GetKinematics, this));
+  NS_TEST_EXPECT_MSG_EQ (GetDataMode (), measured, "measured snr for an unknown station");
+
+  m_known = true;
+  NS_TEST_EXPECT_MSG_EQ (GetDataMode (), measured, "same snr for a station at rest");
+  m_velocity = Vector (500, 0, 0);
+  WifiMode receding = GetDataMode ();
+  NS_TEST_EXPECT_MSG_EQ (receding, ExpectedMode (snr * std::pow (0.5, 2.7)), "snr of a receding station");
+  NS_TEST_EXPECT_MSG_LT (receding.GetDataRate (), measured.GetDataRate (), "slower mode for a receding station");
+  m_velocity = Vector (-250, 0, 0);
+  WifiMode approaching = GetDataMode ();
+  NS_TEST_EXPECT_MSG_EQ (approaching, ExpectedMode (snr * std::pow (2.0, 2.7)), "snr of an approaching station");
+  NS_TEST_EXPECT_MSG_GT (approaching.GetDataRate (), measured.GetDataRate (), "faster mode for an approaching station");
+
+  m_manager->SetKinematicsCallback (MakeNullCallback<bool, Mac48Address, Vector &, Vector &> ());
+  NS_TEST_EXPECT_MSG_EQ (GetDataMode (), measured, "measured snr once the callback is gone");
+
+  m_manager = 0;
+  m_phy->Dispose ();
+  m_phy = 0;
+  Simulator::Destroy ();
+}
+
 //-----------------------------------------------------------------------------
 /**
  * \internal
@@ -490,6 +648,8 @@ WifiTestSuite::WifiTestSuite ()
 {
   AddTestCase (new WifiTest, TestCase::QUICK);
   AddTestCase (new QosUtilsIsOldPacketTest, TestCase::QUICK);
+  AddTestCase (new WifiMacQueueDequeueByAddressTest, TestCase::QUICK);
+  AddTestCase (new VehicularWifiManagerTest, TestCase::QUICK);
   AddTestCase (new InterferenceHelperSequenceTest, TestCase::QUICK); // Bug 991
   AddTestCase (new Bug555TestCase, TestCase::QUICK); // Bug 555
 }